@@ -16,10 +16,14 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
+#include <QPointF>
+
 #include "mediaobject.h"
 
 #include "abstractaudioeffect.h"
 #include "audioplayer.h"
+#include "backend.h"
+#include "softwareplayer.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -34,28 +38,60 @@ using namespace Phonon::MMF;
   \internal
 */
 
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Minimum time between successive applications of parameter changes to the
+// native effect
+const int       FlushInterval = 25; // ms
+
+// Interval at which envelopes are evaluated during playback.  This is a
+// multiple of the default tick interval, so that envelope ticks coincide
+// with player ticks, and is no shorter than the flush interval, so that each
+// evaluation can be applied immediately.
+const int       EnvelopeTickInterval = 3 * DefaultTickInterval; // ms
+
+
 AbstractAudioEffect::AbstractAudioEffect(QObject *parent,
-                                         const QList<EffectParameter> &params)
+                                         const EffectDescriptorPointer &descriptor)
     :   MediaNode(parent)
-    ,   m_params(params)
+    ,   m_descriptor(descriptor)
+    ,   m_type(EffectFactory::TypeAudioEqualizer)
     ,   m_player(0)
+    ,   m_values(descriptor->count())
+    ,   m_applyCount(0)
+    ,   m_dirty(descriptor->count())
+    ,   m_flushTimer(new QTimer(this))
+    ,   m_envelopes(descriptor->count())
+    ,   m_processorEnabled(false)
+    ,   m_tickScheduler(0)
+    ,   m_audioGraph(0)
 {
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer.data(), SIGNAL(timeout()), this, SLOT(flush()));
 
 }
 
+AbstractAudioEffect::~AbstractAudioEffect()
+{
+    if (m_tickScheduler)
+        m_tickScheduler->unRegisterTarget(this);
+}
+
 QList<Phonon::EffectParameter> AbstractAudioEffect::parameters() const
 {
     // Convert from QList<MMF::EffectParameter> to QList<Phonon::EffectParameter>
     QList<Phonon::EffectParameter> result;
-    EffectParameter param;
-    foreach (param, m_params)
-        result += param;
+    for (int i = 0; i < m_descriptor->count(); ++i)
+        result += m_descriptor->parameter(i);
     return result;
 }
 
 QVariant AbstractAudioEffect::parameterValue(const Phonon::EffectParameter &queriedParam) const
 {
-    const QVariant &val = m_values.value(queriedParam.id());
+    const int index = m_descriptor->indexOf(queriedParam.id());
+    const QVariant val = (-1 == index) ? QVariant() : m_values.at(index);
 
     if (val.isNull())
         return queriedParam.defaultValue();
@@ -66,20 +102,148 @@ QVariant AbstractAudioEffect::parameterValue(const Phonon::EffectParameter &quer
 void AbstractAudioEffect::setParameterValue(const Phonon::EffectParameter &param,
                                             const QVariant &newValue)
 {
-    m_values.insert(param.id(), newValue);
+    setValue(param.id(), newValue);
+    scheduleFlush();
+}
 
-    if (m_effect.data()) {
-        const EffectParameter& internalParam = internalParameter(param.id());
-        int err = parameterChanged(internalParam, newValue);
+int AbstractAudioEffect::applyCount() const
+{
+    return m_applyCount;
+}
+
+QStringList AbstractAudioEffect::presetNames() const
+{
+    return m_factory ? m_factory->presetNames(m_type) : QStringList();
+}
+
+bool AbstractAudioEffect::setParameterValues(const QVariantMap &values)
+{
+    QVariantMap::const_iterator i = values.begin();
+    for ( ; i != values.end(); ++i) {
+        bool ok = false;
+        const int id = i.key().toInt(&ok);
+        if (!ok || -1 == m_descriptor->indexOf(id))
+            return false;
+    }
+
+    for (i = values.begin(); i != values.end(); ++i)
+        setValue(i.key().toInt(), i.value());
+    scheduleFlush();
+    return true;
+}
+
+bool AbstractAudioEffect::applyPreset(const QString &name)
+{
+    const EffectPreset *const preset = m_factory ? m_factory->preset(m_type, name) : 0;
+    if (!preset)
+        return false;
+
+    Q_ASSERT(preset->descriptor() == m_descriptor);
+    applyPresetValues(*preset);
+    return true;
+}
+
+bool AbstractAudioEffect::setEnvelope(int parameterId, const QVariantList &points)
+{
+    const int index = m_descriptor->indexOf(parameterId);
+    if (-1 == index || QVariant::Bool == m_descriptor->parameter(index).type())
+        return false;
+
+    EffectEnvelope envelope;
+    foreach (const QVariant &point, points) {
+        if (QVariant::PointF != point.type())
+            return false;
+        const QPointF p = point.toPointF();
+        envelope.addPoint(qint64(p.x()), p.y());
+    }
+
+    m_envelopes[index] = envelope;
+
+    // Bring the parameter up to date straight away, rather than waiting
+    // for the next tick.
+    if (m_player && !envelope.isEmpty()) {
+        const QVariant value(envelope.valueAt(m_player->currentTime()));
+        if (value != m_values.at(index)) {
+            m_values[index] = value;
+            m_dirty.setBit(index);
+            scheduleFlush();
+        }
+    }
+
+    updateEnvelopeTimer();
+    return true;
+}
+
+void AbstractAudioEffect::clearEnvelope(int parameterId)
+{
+    const int index = m_descriptor->indexOf(parameterId);
+    if (-1 != index)
+        m_envelopes[index].clear();
+    updateEnvelopeTimer();
+}
+
+void AbstractAudioEffect::clearEnvelopes()
+{
+    for (int i = 0; i < m_envelopes.count(); ++i)
+        m_envelopes[i].clear();
+    updateEnvelopeTimer();
+}
+
+AudioProcessor *AbstractAudioEffect::audioProcessor()
+{
+    return this;
+}
+
+void AbstractAudioEffect::process(float *samples, int frameCount)
+{
+    if (m_processor.data() && m_processorEnabled)
+        m_processor->process(samples, frameCount);
+}
+
+void AbstractAudioEffect::flush()
+{
+    m_flushTimer->stop();
+    m_lastFlush.start();
+
+    // If there is no native effect or processor, all values are applied
+    // when it is created.
+    if (hasImplementation() && m_dirty.count(true)) {
+        int err = 0;
+        for (int i = 0; i < m_descriptor->count() && !err; ++i)
+            if (m_dirty.testBit(i))
+                err = stageParameter(m_descriptor->parameter(i), m_values.at(i));
+        if (!err)
+            err = applyParameters();
         // TODO: handle audio effect errors
         Q_UNUSED(err);
     }
+
+    m_dirty.fill(false);
 }
 
 void AbstractAudioEffect::abstractPlayerChanged(AbstractPlayer *player)
 {
     m_player = qobject_cast<AbstractMediaPlayer *>(player);
     m_effect.reset();
+    m_processor.reset();
+    updateEnvelopeTimer();
+
+    // A player which was prepared in advance, for example the standby
+    // player used for gapless playback, has already finished loading.
+    if (m_player && Phonon::LoadingState != m_player->state())
+        createEffect();
+}
+
+void AbstractAudioEffect::crossfadeStarted()
+{
+    // The player to which m_effect is applied is about to become the
+    // outgoing player
+    m_outgoingEffect.reset(m_effect.take());
+}
+
+void AbstractAudioEffect::outgoingPlayerReleased()
+{
+    m_outgoingEffect.reset();
 }
 
 void AbstractAudioEffect::stateChanged(Phonon::State newState,
@@ -88,43 +252,102 @@ void AbstractAudioEffect::stateChanged(Phonon::State newState,
     if (Phonon::LoadingState == oldState
         && Phonon::LoadingState != newState)
         createEffect();
+
+    updateEnvelopeTimer();
+}
+
+void AbstractAudioEffect::seeked(qint64 position)
+{
+    // Envelopes are stateless, so they are simply evaluated at the new
+    // position.
+    if (updateEnvelopeValues(position))
+        flush();
+
+    // Seeking back before the end of an envelope resumes evaluation.
+    updateEnvelopeTimer();
 }
 
 void AbstractAudioEffect::connectMediaObject(MediaObject *mediaObject)
 {
     Q_ASSERT_X(!m_player, Q_FUNC_INFO, "Player already connected");
-    Q_ASSERT_X(!m_effect.data(), Q_FUNC_INFO, "Effect already created");
+    Q_ASSERT_X(!hasImplementation(), Q_FUNC_INFO, "Effect already created");
 
+    m_tickScheduler = mediaObject->backend()->tickScheduler();
+    m_audioGraph = mediaObject->backend()->audioGraph();
+
+    outputVolumeChanged(mediaObject->volume());
     abstractPlayerChanged(mediaObject->abstractPlayer());
 
     connect(mediaObject, SIGNAL(stateChanged(Phonon::State, Phonon::State)),
             SLOT(stateChanged(Phonon::State, Phonon::State)));
 
+    connect(mediaObject, SIGNAL(seeked(qint64)), SLOT(seeked(qint64)));
+
+    connect(mediaObject, SIGNAL(outputVolumeChanged(qreal)),
+            SLOT(outputVolumeChanged(qreal)));
+
     connect(mediaObject, SIGNAL(abstractPlayerChanged(AbstractPlayer *)),
             SLOT(abstractPlayerChanged(AbstractPlayer *)));
 
-    if (mediaObject->state() != Phonon::LoadingState)
-        createEffect();
+    connect(mediaObject, SIGNAL(crossfadeStarted()), SLOT(crossfadeStarted()));
+
+    connect(mediaObject, SIGNAL(outgoingPlayerReleased()),
+            SLOT(outgoingPlayerReleased()));
 }
 
 void AbstractAudioEffect::disconnectMediaObject(MediaObject *mediaObject)
 {
     mediaObject->disconnect(this);
+    m_outgoingEffect.reset();
     abstractPlayerChanged(0);
 }
 
 void AbstractAudioEffect::setEnabled(bool enabled)
 {
-    TInt err = KErrNone;
+    m_processorEnabled = enabled;
 
-    if (enabled)
-        // TODO: handle audio effect errors
-        TRAP(err, m_effect->EnableL())
-    else
+    if (m_effect.data()) {
+        TInt err = KErrNone;
+
+        if (enabled)
+            // TODO: handle audio effect errors
+            TRAP(err, m_effect->EnableL())
+        else
+            // TODO: handle audio effect errors
+            TRAP(err, m_effect->DisableL())
+
+        Q_UNUSED(err);
+    }
+}
+
+void AbstractAudioEffect::applyPresetValues(const EffectPreset &preset)
+{
+    for (int i = 0; i < m_descriptor->count(); ++i)
+        m_values[i] = preset.externalValue(i);
+
+    // Automated parameters continue to follow their envelopes.
+    if (m_player)
+        updateEnvelopeValues(m_player->currentTime());
+
+    if (hasImplementation()) {
+        int err = 0;
+        for (int i = 0; i < m_descriptor->count() && !err; ++i) {
+            const EffectParameter &param = m_descriptor->parameter(i);
+            if (m_envelopes.at(i).isEmpty())
+                err = stageInternalParameter(param, preset.internalValue(i));
+            else
+                err = stageParameter(param, m_values.at(i));
+        }
+        if (!err)
+            err = applyParameters();
         // TODO: handle audio effect errors
-        TRAP(err, m_effect->DisableL())
+        Q_UNUSED(err)
+
+        m_lastFlush.start();
+    }
 
-    Q_UNUSED(err);
+    m_dirty.fill(false);
+    m_flushTimer->stop();
 }
 
 void AbstractAudioEffect::createEffect()
@@ -133,31 +356,59 @@ void AbstractAudioEffect::createEffect()
 
     if (AudioPlayer *audioPlayer = qobject_cast<AudioPlayer *>(m_player)) {
         createEffect(audioPlayer->nativePlayer());
+    } else if (m_audioGraph && qobject_cast<SoftwarePlayer *>(m_player)) {
+        m_processor.reset(createProcessor(m_audioGraph->sampleRate(),
+                                          m_audioGraph->channelCount()));
     }
 
-    if (m_effect.data()) {
-        EffectParameter param;
-	int err = 0;
-        foreach (param, m_params) {
-            const QVariant value = parameterValue(param);
-            err = parameterChanged(param, value);
+    if (hasImplementation()) {
+        updateEnvelopeValues(m_player->currentTime());
+
+        // All parameters are staged, and then applied together.
+        int err = 0;
+        for (int i = 0; i < m_descriptor->count() && !err; ++i) {
+            const EffectParameter &param = m_descriptor->parameter(i);
+            err = stageParameter(param, parameterValue(param));
         }
-	Q_UNUSED(err)
+        if (!err)
+            err = applyParameters();
+        // TODO: handle audio effect errors
+        Q_UNUSED(err)
+
+        m_dirty.fill(false);
+        m_flushTimer->stop();
+        m_lastFlush.start();
     }
 }
 
+const EffectDescriptorPointer &AbstractAudioEffect::descriptor() const
+{
+    return m_descriptor;
+}
+
+bool AbstractAudioEffect::hasImplementation() const
+{
+    return m_effect.data() || m_processor.data();
+}
+
 const MMF::EffectParameter& AbstractAudioEffect::internalParameter(int id) const
 {
-    const EffectParameter *result = 0;
-    for (int i=0; i<m_params.count() && !result; ++i) {
-        if (m_params[i].id() == id)
-            result = &m_params[i];
+    const int index = m_descriptor->indexOf(id);
+    Q_ASSERT_X(-1 != index, Q_FUNC_INFO, "Parameter not found");
+    return m_descriptor->parameter(index);
+}
+
+void AbstractAudioEffect::setValue(int id, const QVariant &value)
+{
+    const int index = m_descriptor->indexOf(id);
+    Q_ASSERT_X(-1 != index, Q_FUNC_INFO, "Parameter not found");
+    if (-1 != index) {
+        m_values[index] = value;
+        m_dirty.setBit(index);
     }
-    Q_ASSERT_X(result, Q_FUNC_INFO, "Parameter not found");
-    return *result;
 }
 
-int AbstractAudioEffect::parameterChanged(const EffectParameter &param,
+int AbstractAudioEffect::stageParameter(const EffectParameter &param,
             const QVariant &value)
 {
     int err = 0;
@@ -169,27 +420,158 @@ int AbstractAudioEffect::parameterChanged(const EffectParameter &param,
     default:
         {
         const EffectParameter& internalParam = internalParameter(param.id());
-        err = effectParameterChanged(internalParam, value);
+        err = stageInternalParameter(internalParam,
+                  internalParam.toInternalValue(value.toReal()));
         }
         break;
     }
 
-    if (!err)
-        TRAP(err, m_effect->ApplyL());
+    return err;
+}
+
+int AbstractAudioEffect::stageInternalParameter(const EffectParameter &param,
+            qint32 internalLevel)
+{
+    int err = 0;
+
+    switch (param.id()) {
+    case ParameterEnable:
+        setEnabled(internalLevel);
+        break;
+    default:
+        if (m_effect.data())
+            err = effectParameterChanged(param, internalLevel);
+        if (m_processor.data())
+            processorParameterChanged(param, internalLevel);
+        break;
+    }
+
+    return err;
+}
+
+int AbstractAudioEffect::applyParameters()
+{
+    ++m_applyCount;
 
+    // Processor parameter changes take effect immediately
+    TInt err = KErrNone;
+    if (m_effect.data())
+        TRAP(err, m_effect->ApplyL());
     return err;
 }
 
+void AbstractAudioEffect::scheduleFlush()
+{
+    if (!m_flushTimer->isActive()) {
+        // The first change after a quiet period is applied immediately;
+        // subsequent changes are deferred until the flush interval has
+        // elapsed.
+        const qint64 elapsed = m_lastFlush.isValid()
+                             ? m_lastFlush.elapsed() : FlushInterval;
+        if (elapsed >= FlushInterval)
+            flush();
+        else
+            m_flushTimer->start(FlushInterval - elapsed);
+    }
+}
+
+/**
+ * Returns true if any envelope has breakpoints after position, i.e. if its
+ * value may still change.
+ */
+bool AbstractAudioEffect::hasEnvelopesAfter(qint64 position) const
+{
+    foreach (const EffectEnvelope &envelope, m_envelopes)
+        if (!envelope.isEmpty() && envelope.endPosition() > position)
+            return true;
+    return false;
+}
+
+/**
+ * Sets the values of automated parameters to the values of their envelopes
+ * at position, and marks those which changed as dirty.  Returns true if
+ * any value changed.
+ */
+bool AbstractAudioEffect::updateEnvelopeValues(qint64 position)
+{
+    bool changed = false;
+
+    for (int i = 0; i < m_envelopes.count(); ++i) {
+        if (!m_envelopes[i].isEmpty()) {
+            const QVariant value(m_envelopes[i].valueAt(position));
+            if (value != m_values.at(i)) {
+                m_values[i] = value;
+                m_dirty.setBit(i);
+                changed = true;
+            }
+        }
+    }
+
+    return changed;
+}
+
+void AbstractAudioEffect::updateEnvelopeTimer()
+{
+    if (m_tickScheduler) {
+        if (m_player && Phonon::PlayingState == m_player->state()
+            && hasEnvelopesAfter(m_player->currentTime()))
+            m_tickScheduler->registerTarget(this, EnvelopeTickChannel, EnvelopeTickInterval);
+        else
+            m_tickScheduler->unRegisterTarget(this, EnvelopeTickChannel);
+    }
+}
+
+void AbstractAudioEffect::scheduledTick(int channel)
+{
+    Q_ASSERT_X(EnvelopeTickChannel == channel, Q_FUNC_INFO, "Unknown channel");
+    Q_UNUSED(channel)
+
+    if (m_player) {
+        // All values which are due are applied together.
+        const qint64 position = m_player->currentTime();
+        if (updateEnvelopeValues(position))
+            flush();
+
+        // Once every envelope has passed its last breakpoint, the values
+        // are constant, so ticks are no longer required.
+        if (!hasEnvelopesAfter(position))
+            m_tickScheduler->unRegisterTarget(this, EnvelopeTickChannel);
+    }
+}
+
 int AbstractAudioEffect::effectParameterChanged(
-    const EffectParameter &param, const QVariant &value)
+    const EffectParameter &param, qint32 internalLevel)
 {
     // Default implementation
     Q_UNUSED(param)
-    Q_UNUSED(value)
+    Q_UNUSED(internalLevel)
     Q_ASSERT_X(false, Q_FUNC_INFO, "Effect has no parameters");
     return 0;
 }
 
+AudioProcessor *AbstractAudioEffect::createProcessor(int sampleRate,
+                                                     int channelCount)
+{
+    // Default implementation
+    Q_UNUSED(sampleRate)
+    Q_UNUSED(channelCount)
+    return 0;
+}
+
+void AbstractAudioEffect::outputVolumeChanged(qreal volume)
+{
+    // Default implementation
+    Q_UNUSED(volume)
+}
+
+void AbstractAudioEffect::processorParameterChanged(
+    const EffectParameter &param, qint32 internalLevel)
+{
+    // Default implementation
+    Q_UNUSED(param)
+    Q_UNUSED(internalLevel)
+}
+
 
 QT_END_NAMESPACE
 
@@ -19,15 +19,28 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PHONON_MMF_ABSTRACTEFFECT_H
 #define PHONON_MMF_ABSTRACTEFFECT_H
 
+#include <QBitArray>
+#include <QElapsedTimer>
+#include <QPointer>
 #include <QScopedPointer>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+#include <QVector>
 
 #include <AudioEffectBase.h>
 
 #include <phonon/effectinterface.h>
 
+#include "audiograph.h"
 #include "audioplayer.h"
+#include "effectdescriptor.h"
+#include "effectenvelope.h"
+#include "effectfactory.h"
 #include "effectparameter.h"
+#include "effectpreset.h"
 #include "mmf_medianode.h"
+#include "tickscheduler.h"
 
 class CMdaAudioOutputStream;
 
@@ -55,15 +68,48 @@ class AbstractMediaPlayer;
  *   that aren't applied, and apply it if we have a media object.
  * - There are plenty of corner cases which we don't handle and where behavior
  *   are undefined. For instance, graphs with more than one MediaObject.
+ *
+ * Parameter changes are not applied to the native effect immediately.
+ * Changed parameters are marked dirty, and the dirty set is flushed to the
+ * native effect with a single call to ApplyL(), at most once per flush
+ * interval.  This means that rapid changes, such as those which result
+ * from dragging a slider, are coalesced, while the last value set is
+ * always applied.
+ *
+ * Parameters may also be automated by envelopes, which are evaluated
+ * against the position of the media object's player.  While the player is
+ * playing, all envelopes of all effects are evaluated on ticks delivered
+ * by the Backend's TickScheduler, so effects are serviced in the same
+ * wakeup, and the values due from each effect's envelopes are applied
+ * in a single flush.
+ *
+ * When the backend renders audio in-process (see SoftwarePlayer), there
+ * is no native effect.  Instead, effects which have an in-process
+ * implementation create an AudioProcessor, to which parameter changes
+ * are applied in the same way, and through which the AudioGraph passes
+ * audio in the order in which the nodes are connected.
+ *
+ * During a crossfade, the native effect which was created for the
+ * outgoing player stays applied to it until the player is released, so
+ * that the effect does not cut out while the outgoing clip is still
+ * audible.  Its parameters are frozen from the start of the crossfade;
+ * changes and envelopes apply only to the incoming player.
+ *
+ * Clients only reach the effect through its metaobject, so the functions
+ * beyond EffectInterface are slots or invokable, and take types which
+ * QVariant can hold.
  */
 class AbstractAudioEffect : public MediaNode
                           , public EffectInterface
+                          , public TickScheduler::Target
+                          , public AudioProcessor
 {
     Q_OBJECT
     Q_INTERFACES(Phonon::EffectInterface)
 public:
     AbstractAudioEffect(QObject *parent,
-                        const QList<EffectParameter> &params);
+                        const EffectDescriptorPointer &descriptor);
+    ~AbstractAudioEffect();
 
     // Phonon::EffectInterface
     virtual QList<Phonon::EffectParameter> parameters() const;
@@ -71,6 +117,25 @@ public:
     virtual void setParameterValue(const Phonon::EffectParameter &,
                                    const QVariant &newValue);
 
+    /**
+     * Number of times parameter changes have been applied to the native
+     * effect or processor since this object was created.  Used to check
+     * that parameter changes are batched.
+     */
+    Q_INVOKABLE int applyCount() const;
+
+    /**
+     * Names of the presets which the EffectFactory holds for this type of
+     * effect.
+     */
+    Q_INVOKABLE QStringList presetNames() const;
+
+    // MediaNode
+    virtual AudioProcessor *audioProcessor();
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
     // Parameters which are shared by all effects
     enum CommonParameters
     {
@@ -79,9 +144,51 @@ public:
     };
 
 public Q_SLOTS:
+    /**
+     * Changes several parameters at once.  values is keyed on parameter
+     * ID, in decimal.  The new values are applied to the native effect
+     * together, in the same flush.  Returns false, changing nothing, if
+     * any key is not the ID of a parameter.
+     */
+    bool setParameterValues(const QVariantMap &values);
+
+    /**
+     * Sets all parameters to the values held by the named preset, and
+     * applies them to the native effect in a single commit.  The preset's
+     * values are already in internal units, so no conversion or
+     * allocation is required.  Returns false if there is no such preset.
+     */
+    bool applyPreset(const QString &name);
+
+    /**
+     * Automates the parameter with the specified ID.  Each point is a
+     * QPointF, whose x is the position in ms and whose y is the value.
+     * Any existing envelope for the parameter is replaced.  While an
+     * envelope is set, it overrides values set via setParameterValue().
+     * Returns false, changing nothing, if the ID is unknown, the
+     * parameter is toggled, or any point is not a QPointF.
+     */
+    bool setEnvelope(int parameterId, const QVariantList &points);
+    void clearEnvelope(int parameterId);
+    void clearEnvelopes();
+
+    /**
+     * Applies any pending parameter changes immediately.
+     */
+    void flush();
+
     void abstractPlayerChanged(AbstractPlayer *player);
+    void crossfadeStarted();
+    void outgoingPlayerReleased();
     void stateChanged(Phonon::State newState,
                       Phonon::State oldState);
+    void seeked(qint64 position);
+
+    /**
+     * Called when the volume of the AudioOutput changes, and on connection
+     * to a MediaObject.  The default implementation does nothing.
+     */
+    virtual void outputVolumeChanged(qreal volume);
 
 protected:
     // MediaNode
@@ -90,51 +197,121 @@ protected:
 
     virtual void createEffect(AudioPlayer::NativePlayer *player) = 0;
 
-    // Effect-specific parameter changed
+    // Effect-specific parameter changed.  internalLevel is in the units of
+    // the native effect.  The value must only be staged on the native
+    // effect: it is applied by the caller.
     virtual int effectParameterChanged(const EffectParameter &param,
-                                  const QVariant &value);
+                                  qint32 internalLevel);
+
+    // In-process implementation.  Effects which do not have one return
+    // null, and pass audio through unchanged.
+    virtual AudioProcessor *createProcessor(int sampleRate, int channelCount);
+
+    // As effectParameterChanged(), for the processor
+    virtual void processorParameterChanged(const EffectParameter &param,
+                                           qint32 internalLevel);
+
+    const EffectDescriptorPointer &descriptor() const;
 
 private:
+    friend class EffectFactory;
+
+    void applyPresetValues(const EffectPreset &preset);
     void createEffect();
+    bool hasImplementation() const;
     void setEnabled(bool enabled);
     const EffectParameter& internalParameter(int id) const;
-    int parameterChanged(const EffectParameter &param,
+    void setValue(int id, const QVariant &value);
+    int stageParameter(const EffectParameter &param,
             const QVariant &value);
+    int stageInternalParameter(const EffectParameter &param,
+            qint32 internalLevel);
+    int applyParameters();
+    void scheduleFlush();
+
+    bool hasEnvelopesAfter(qint64 position) const;
+    bool updateEnvelopeValues(qint64 position);
+    void updateEnvelopeTimer();
+
+    // TickScheduler::Target
+    virtual void scheduledTick(int channel);
+
+    enum TickChannel {
+        EnvelopeTickChannel
+    };
 
 protected:
     QScopedPointer<CAudioEffect>    m_effect;
+    QScopedPointer<AudioProcessor>  m_processor;
 
 private:
-    const QList<EffectParameter>    m_params;
+    // Native effect of the outgoing player of a crossfade
+    QScopedPointer<CAudioEffect>    m_outgoingEffect;
+
+    // Shared by all effects of the same type
+    const EffectDescriptorPointer   m_descriptor;
+
+    // Not owned.  Set by the factory which created this effect, and used
+    // to look up presets.
+    QPointer<EffectFactory>         m_factory;
+    EffectFactory::Type             m_type;
+
     AbstractMediaPlayer *           m_player;
-    QHash<int, QVariant>            m_values;
-};
 
-}
-}
+    // Current values, indexed in the same way as the parameters in
+    // m_descriptor.  Values which have not been set are null.
+    QVector<QVariant>               m_values;
+    int                             m_applyCount;
 
+    // Parameters whose values have not yet been applied
+    QBitArray                       m_dirty;
+    QScopedPointer<QTimer>          m_flushTimer;
+    QElapsedTimer                   m_lastFlush;
 
-// Macro for defining functions which depend on the native class name
-// for each of the effects.  Using this reduces repetition of boilerplate
-// in the implementations of the backend effect nodes.
+    // Indexed in the same way as m_values.  Parameters which are not
+    // automated have empty envelopes.
+    QVector<EffectEnvelope>         m_envelopes;
 
-#ifdef Q_CC_NOKIAX86
-#   pragma warn_illtokenpasting off
-#endif
+    bool                            m_processorEnabled;
+
+    // Not owned.  Set when the effect is connected to a media object.
+    TickScheduler *                 m_tickScheduler;
+    AudioGraph *                    m_audioGraph;
+};
+
+/**
+ * @short Binds an effect node to its native effect class
+ *
+ * Effect nodes derive from this template, rather than directly from
+ * AbstractAudioEffect, in order to share the functions which only depend
+ * on the native class.
+ */
+template<typename NativeEffect>
+class NativeAudioEffect : public AbstractAudioEffect
+{
+protected:
+    NativeAudioEffect(QObject *parent,
+                      const EffectDescriptorPointer &descriptor)
+        :   AbstractAudioEffect(parent, descriptor)
+    { }
+
+    // AbstractAudioEffect
+    virtual void createEffect(AudioPlayer::NativePlayer *player)
+    {
+        NativeEffect *ptr = 0;
+        QT_TRAP_THROWING(ptr = NativeEffect::NewL(*player));
+        m_effect.reset(ptr);
+    }
+
+    NativeEffect *concreteEffect()
+    {
+        return static_cast<NativeEffect *>(m_effect.data());
+    }
+};
 
-#define PHONON_MMF_DEFINE_EFFECT_FUNCTIONS(Effect)                      \
-                                                                        \
-void Effect##::createEffect(AudioPlayer::NativePlayer *player)          \
-{                                                                       \
-    C##Effect *ptr = 0;                                                 \
-    QT_TRAP_THROWING(ptr = C##Effect::NewL(*player));                   \
-    m_effect.reset(ptr);                                                \
-}                                                                       \
-                                                                        \
-C##Effect* Effect::concreteEffect()                                     \
-{                                                                       \
-    return static_cast<C##Effect *>(m_effect.data());                   \
 }
+}
+
 
 QT_END_NAMESPACE
 
@@ -20,6 +20,7 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include <QUrl>
 
 #include "abstractmediaplayer.h"
+#include "backend.h"
 #include "defs.h"
 #include "mediaobject.h"
 #include "utils.h"
@@ -38,8 +39,22 @@ using namespace Phonon::MMF;
 //-----------------------------------------------------------------------------
 
 const int       NullMaxVolume = -1;
+const int       NullDeviceVolume = -1;
 const int       BufferStatusTimerInterval = 100; // ms
 
+// Interval at which the volume is updated during a fade.
+const int       FadeTimerInterval = 20; // ms
+
+// Time before the end of the clip, or before the start of the transition to
+// the next clip, at which standbyMarkReached() is emitted.  This leaves
+// MediaObject time to open the next source in a standby player, and does
+// not depend on the tick interval.
+const qint64    StandbyMark = 2000; // ms
+
+// Marks which are due within this time are emitted immediately, rather than
+// re-arming the mark timer.
+const qint64    MarkTolerance = 2; // ms
+
 
 //-----------------------------------------------------------------------------
 // Constructor / destructor
@@ -50,19 +65,64 @@ MMF::AbstractMediaPlayer::AbstractMediaPlayer
         :   AbstractPlayer(player)
         ,   m_parent(parent)
         ,   m_pending(NothingPending)
-        ,   m_positionTimer(new QTimer(this))
+        ,   m_tickScheduler(parent->backend()->tickScheduler())
         ,   m_position(0)
-        ,   m_bufferStatusTimer(new QTimer(this))
+        ,   m_tickCount(0)
+        ,   m_positionQueryCount(0)
         ,   m_mmfMaxVolume(NullMaxVolume)
+        ,   m_deviceVolume(NullDeviceVolume)
+        ,   m_fadeLevel(1.0)
+        ,   m_fadeFrom(1.0)
+        ,   m_fadeTo(1.0)
+        ,   m_fadeStart(0)
+        ,   m_fadeDuration(0)
+        ,   m_faderLevel(1.0)
+        ,   m_markTimer(new QTimer(this))
         ,   m_prefinishMarkSent(false)
+        ,   m_standbyMarkSent(false)
         ,   m_aboutToFinishSent(false)
+        ,   m_transitionMarkSent(false)
 #ifdef PHONON_MMF_PROGRESSIVE_DOWNLOAD
         ,   m_download(0)
         ,   m_downloadStalled(false)
 #endif
 {
-    connect(m_positionTimer.data(), SIGNAL(timeout()), this, SLOT(positionTick()));
-    connect(m_bufferStatusTimer.data(), SIGNAL(timeout()), this, SLOT(bufferStatusTick()));
+    m_markTimer->setSingleShot(true);
+    connect(m_markTimer.data(), SIGNAL(timeout()), this, SLOT(markTimerExpired()));
+}
+
+MMF::AbstractMediaPlayer::~AbstractMediaPlayer()
+{
+    m_tickScheduler->unRegisterTarget(this);
+}
+
+void MMF::AbstractMediaPlayer::reuse(MediaObject *parent, const AbstractPlayer *player)
+{
+    Q_ASSERT_X(parent->backend()->tickScheduler() == m_tickScheduler,
+               Q_FUNC_INFO, "Player reused by a different backend");
+
+    stopTimers();
+    reinitialize(player);
+
+    m_parent = parent;
+    m_pending = NothingPending;
+    m_position = 0;
+    m_clock = PlaybackClock();
+    m_tickCount = 0;
+    m_positionQueryCount = 0;
+    m_mmfMaxVolume = NullMaxVolume;
+    m_deviceVolume = NullDeviceVolume;
+    m_fadeLevel = 1.0;
+    m_fadeFrom = 1.0;
+    m_fadeTo = 1.0;
+    m_fadeStart = 0;
+    m_fadeDuration = 0;
+    m_faderLevel = 1.0;
+    m_prefinishMarkSent = false;
+    m_standbyMarkSent = false;
+    m_aboutToFinishSent = false;
+    m_transitionMarkSent = false;
+    m_metaData.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -123,7 +183,10 @@ void MMF::AbstractMediaPlayer::pause()
     case PlayingState:
     case BufferingState:
         changeState(PausedState);
-        // Fall through
+        doPause();
+        stopClock();
+        break;
+
     case ErrorState:
         doPause();
         break;
@@ -156,6 +219,8 @@ void MMF::AbstractMediaPlayer::stop()
     case BufferingState:
     case PausedState:
         doStop();
+        m_clock.stop(m_position);
+        traceClockStatistics();
         changeState(StoppedState);
         break;
 
@@ -189,11 +254,15 @@ void MMF::AbstractMediaPlayer::seek(qint64 ms)
 
         doSeek(ms);
         m_position = ms;
+        m_clock.stop(m_position);
         resetMarksIfRewound();
 
         if(wasPlaying && state() != ErrorState) {
             doPlay();
+            m_clock.start(m_position);
             startPositionTimer();
+            startFadeTimer();
+            scheduleMarks();
         }
 
         break;
@@ -215,7 +284,19 @@ bool MMF::AbstractMediaPlayer::isSeekable() const
 
 qint64 MMF::AbstractMediaPlayer::currentTime() const
 {
-    return m_position;
+    qint64 result = m_position;
+
+    // Between ticks, the interpolated clock gives a more recent value than
+    // the last position which was reported, without querying the native
+    // player.
+    if (m_clock.isRunning()) {
+        const qint64 total = totalTime();
+        const qint64 interpolated = total > 0
+            ? qMin(m_clock.position(), total) : m_clock.position();
+        result = qMax(result, interpolated);
+    }
+
+    return result;
 }
 
 void MMF::AbstractMediaPlayer::doSetTickInterval(qint32 interval)
@@ -223,11 +304,21 @@ void MMF::AbstractMediaPlayer::doSetTickInterval(qint32 interval)
     TRACE_CONTEXT(AbstractMediaPlayer::doSetTickInterval, EAudioApi);
     TRACE_ENTRY("state %d m_interval %d interval %d", privateState(), tickInterval(), interval);
 
-    m_positionTimer->setInterval(interval);
+    if (PlayingState == privateState())
+        startPositionTimer();
+
+    // The aboutToFinish mark is one tick interval before the end
+    marksChanged();
 
     TRACE_EXIT_0();
 }
 
+void MMF::AbstractMediaPlayer::marksChanged()
+{
+    resetMarksIfRewound();
+    scheduleMarks();
+}
+
 void MMF::AbstractMediaPlayer::open()
 {
     TRACE_CONTEXT(AbstractMediaPlayer::open, EAudioApi);
@@ -313,12 +404,15 @@ void MMF::AbstractMediaPlayer::open()
 
 void MMF::AbstractMediaPlayer::close()
 {
+    stopTimers();
     doClose();
 #ifdef PHONON_MMF_PROGRESSIVE_DOWNLOAD
     delete m_download;
     m_download = 0;
 #endif
     m_position = 0;
+    m_clock.stop(m_position);
+    m_deviceVolume = NullDeviceVolume;
 }
 
 void MMF::AbstractMediaPlayer::volumeChanged(qreal volume)
@@ -332,34 +426,86 @@ void MMF::AbstractMediaPlayer::volumeChanged(qreal volume)
     TRACE_EXIT_0();
 }
 
+QMultiMap<QString, QString> MMF::AbstractMediaPlayer::metaData() const
+{
+    return m_metaData;
+}
+
+void MMF::AbstractMediaPlayer::fade(qreal from, qreal to, qint64 duration)
+{
+    if (duration > 0) {
+        m_fadeFrom = from;
+        m_fadeTo = to;
+        m_fadeStart = currentTime();
+        m_fadeDuration = duration;
+        m_fadeLevel = from;
+        doVolumeChanged();
+        if (PlayingState == privateState())
+            startFadeTimer();
+    } else {
+        setFadeLevel(to);
+    }
+}
+
+void MMF::AbstractMediaPlayer::setFadeLevel(qreal level)
+{
+    stopFadeTimer();
+    m_fadeDuration = 0;
+    m_fadeLevel = level;
+    doVolumeChanged();
+}
+
+void MMF::AbstractMediaPlayer::setFaderLevel(qreal level)
+{
+    m_faderLevel = level;
+    doVolumeChanged();
+}
+
 //-----------------------------------------------------------------------------
 // Private functions
 //-----------------------------------------------------------------------------
 
 void MMF::AbstractMediaPlayer::startPositionTimer()
 {
-    m_positionTimer->start(tickInterval());
+    // A tick interval of zero disables the tick() signal
+    if (tickInterval() > 0)
+        m_tickScheduler->registerTarget(this, PositionTickChannel, tickInterval());
+    else
+        stopPositionTimer();
 }
 
 void MMF::AbstractMediaPlayer::stopPositionTimer()
 {
-    m_positionTimer->stop();
+    m_tickScheduler->unRegisterTarget(this, PositionTickChannel);
 }
 
 void MMF::AbstractMediaPlayer::startBufferStatusTimer()
 {
-    m_bufferStatusTimer->start(BufferStatusTimerInterval);
+    m_tickScheduler->registerTarget(this, BufferStatusTickChannel, BufferStatusTimerInterval);
 }
 
 void MMF::AbstractMediaPlayer::stopBufferStatusTimer()
 {
-    m_bufferStatusTimer->stop();
+    m_tickScheduler->unRegisterTarget(this, BufferStatusTickChannel);
+}
+
+void MMF::AbstractMediaPlayer::startFadeTimer()
+{
+    if (m_fadeDuration > 0)
+        m_tickScheduler->registerTarget(this, FadeTickChannel, FadeTimerInterval);
+}
+
+void MMF::AbstractMediaPlayer::stopFadeTimer()
+{
+    m_tickScheduler->unRegisterTarget(this, FadeTickChannel);
 }
 
 void MMF::AbstractMediaPlayer::stopTimers()
 {
     stopPositionTimer();
     stopBufferStatusTimer();
+    stopFadeTimer();
+    m_markTimer->stop();
 }
 
 void MMF::AbstractMediaPlayer::doVolumeChanged()
@@ -375,11 +521,18 @@ void MMF::AbstractMediaPlayer::doVolumeChanged()
     case PausedState:
     case PlayingState:
     case BufferingState: {
-        const qreal volume = (m_volume * m_mmfMaxVolume) + 0.5;
-        const int err = setDeviceVolume(volume);
+        const int volume = (m_volume * m_fadeLevel * m_faderLevel * m_mmfMaxVolume) + 0.5;
+
+        // During fades this is called on every fade tick, so the device is
+        // only updated when the volume actually changes.
+        if (volume != m_deviceVolume) {
+            const int err = setDeviceVolume(volume);
 
-        if (KErrNone != err) {
-            setError(tr("Setting volume failed"), err);
+            if (KErrNone == err) {
+                m_deviceVolume = volume;
+            } else {
+                setError(tr("Setting volume failed"), err);
+            }
         }
         break;
     }
@@ -398,6 +551,7 @@ void MMF::AbstractMediaPlayer::doVolumeChanged()
 void MMF::AbstractMediaPlayer::bufferingStarted()
 {
     m_stateBeforeBuffering = privateState();
+    stopClock();
     changeState(BufferingState);
     bufferStatusTick();
     startBufferStatusTimer();
@@ -407,8 +561,14 @@ void MMF::AbstractMediaPlayer::bufferingComplete()
 {
     stopBufferStatusTimer();
     emit MMF::AbstractPlayer::bufferStatus(100);
-    if (!progressiveDownloadStalled())
+    if (!progressiveDownloadStalled()) {
+        if (PlayingState == m_stateBeforeBuffering) {
+            m_clock.start(queryPosition());
+            startFadeTimer();
+            scheduleMarks();
+        }
         changeState(m_stateBeforeBuffering);
+    }
 }
 
 void MMF::AbstractMediaPlayer::maxVolumeChanged(int mmfMaxVolume)
@@ -449,6 +609,8 @@ void MMF::AbstractMediaPlayer::loadingComplete(int error)
 void MMF::AbstractMediaPlayer::playbackComplete(int error)
 {
     stopTimers();
+    m_clock.stop(KErrNone == error ? totalTime() : m_position);
+    traceClockStatistics();
 
     if (KErrNone == error && !m_aboutToFinishSent) {
         const qint64 total = totalTime();
@@ -460,10 +622,9 @@ void MMF::AbstractMediaPlayer::playbackComplete(int error)
     if (KErrNone == error) {
         changeState(PausedState);
 
-        // MediaObject::switchToNextSource deletes the current player, so we
-        // call it via delayed slot invokation to ensure that this object does
-        // not get deleted during execution of a member function.
-        QMetaObject::invokeMethod(m_parent, "switchToNextSource", Qt::QueuedConnection);
+        // Either swaps in the standby player, deleting this object later, or
+        // opens the next source via a queued call.
+        m_parent->handlePlaybackComplete(this);
     }
     else {
         if (isProgressiveDownload() && KErrCorrupt == error) {
@@ -499,52 +660,183 @@ bool MMF::AbstractMediaPlayer::progressiveDownloadStalled() const
 }
 
 //-----------------------------------------------------------------------------
-// Slots
+// Ticks
 //-----------------------------------------------------------------------------
 
+void MMF::AbstractMediaPlayer::scheduledTick(int channel)
+{
+    switch (channel) {
+    case PositionTickChannel:
+        positionTick();
+        break;
+    case BufferStatusTickChannel:
+        bufferStatusTick();
+        break;
+    case FadeTickChannel:
+        fadeTick();
+        break;
+    default:
+        Q_ASSERT_X(false, Q_FUNC_INFO, "Unknown tick channel");
+    }
+}
+
 void MMF::AbstractMediaPlayer::positionTick()
 {
-    const qint64 pos = getCurrentTime();
+    ++m_tickCount;
+
+    qint64 pos = 0;
+    if (m_clock.syncDue()) {
+        pos = queryPosition();
+        m_clock.sync(pos);
+    } else {
+        pos = m_clock.position();
+        const qint64 total = totalTime();
+        if (total > 0)
+            pos = qMin(pos, total);
+    }
+
     if (pos > m_position) {
         m_position = pos;
-        emitMarksIfReached(m_position);
         emit MMF::AbstractPlayer::tick(m_position);
     }
 }
 
+void MMF::AbstractMediaPlayer::fadeTick()
+{
+    // The ramp is a function of the playback position rather than of wall
+    // clock time, so that it stays in step with the audio.
+    const qint64 elapsed = qMax(qint64(0), currentTime() - m_fadeStart);
+
+    if (elapsed >= m_fadeDuration) {
+        setFadeLevel(m_fadeTo);
+    } else {
+        m_fadeLevel = m_fadeFrom + (m_fadeTo - m_fadeFrom) * elapsed / m_fadeDuration;
+        doVolumeChanged();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Marks
+//-----------------------------------------------------------------------------
+
+// aboutToFinish() is emitted when less than one tick interval remains before
+// the end of the clip, or before the start of the transition to the next
+// clip.  With a tick interval of zero, it is emitted when the clip ends.
+qint64 MMF::AbstractMediaPlayer::aboutToFinishMark() const
+{
+    return tickInterval() + qMax(qint32(0), transitionTime());
+}
+
+qint64 MMF::AbstractMediaPlayer::standbyMark() const
+{
+    return StandbyMark + qMax(qint32(0), transitionTime());
+}
+
+qint64 MMF::AbstractMediaPlayer::nextMark() const
+{
+    const qint64 total = totalTime();
+    qint64 result = -1;
+
+    if (total > 0) {
+        if (prefinishMark() && !m_prefinishMarkSent)
+            result = qMax(qint64(0), total - prefinishMark());
+
+        if (!m_standbyMarkSent) {
+            const qint64 mark = qMax(qint64(0), total - standbyMark());
+            result = (result < 0) ? mark : qMin(result, mark);
+        }
+
+        if (!m_aboutToFinishSent) {
+            const qint64 mark = qMax(qint64(0), total - aboutToFinishMark());
+            result = (result < 0) ? mark : qMin(result, mark);
+        }
+
+        if (transitionTime() > 0 && !m_transitionMarkSent) {
+            const qint64 mark = qMax(qint64(0), total - transitionTime());
+            result = (result < 0) ? mark : qMin(result, mark);
+        }
+    }
+
+    return result;
+}
+
+void MMF::AbstractMediaPlayer::scheduleMarks()
+{
+    m_markTimer->stop();
+
+    // Marks are scheduled as deadlines from the playback clock, so their
+    // accuracy does not depend on the tick interval.
+    const qint64 mark = nextMark();
+    if (m_clock.isRunning() && mark >= 0)
+        m_markTimer->start(m_clock.timeUntil(mark));
+}
+
+void MMF::AbstractMediaPlayer::markTimerExpired()
+{
+    // Re-anchor the clock, so that any drift since the last sync does not
+    // cause the mark to be emitted early.
+    const qint64 pos = queryPosition();
+    m_clock.sync(pos);
+
+    emitMarksIfReached(pos);
+    scheduleMarks();
+}
+
 void MMF::AbstractMediaPlayer::emitMarksIfReached(qint64 current)
 {
     const qint64 total = totalTime();
     const qint64 remaining = total - current;
 
     if (prefinishMark() && !m_prefinishMarkSent) {
-        if (remaining < (prefinishMark() + tickInterval()/2)) {
+        if (remaining <= (prefinishMark() + MarkTolerance)) {
             m_prefinishMarkSent = true;
             emit prefinishMarkReached(remaining);
         }
     }
 
+    if (!m_standbyMarkSent) {
+        if (remaining <= (standbyMark() + MarkTolerance)) {
+            m_standbyMarkSent = true;
+            emit standbyMarkReached();
+        }
+    }
+
     if (!m_aboutToFinishSent) {
-        if (remaining < tickInterval()) {
+        if (remaining <= (aboutToFinishMark() + MarkTolerance)) {
             m_aboutToFinishSent = true;
             emit aboutToFinish();
         }
     }
+
+    if (transitionTime() > 0 && !m_transitionMarkSent) {
+        if (remaining <= (transitionTime() + MarkTolerance)) {
+            m_transitionMarkSent = true;
+            emit transitionMarkReached();
+        }
+    }
 }
 
 void MMF::AbstractMediaPlayer::resetMarksIfRewound()
 {
-    const qint64 current = getCurrentTime();
+    const qint64 current = m_position;
     const qint64 total = totalTime();
     const qint64 remaining = total - current;
 
     if (prefinishMark() && m_prefinishMarkSent)
-        if (remaining >= (prefinishMark() + tickInterval()/2))
+        if (remaining > (prefinishMark() + MarkTolerance))
             m_prefinishMarkSent = false;
 
+    if (m_standbyMarkSent)
+        if (remaining > (standbyMark() + MarkTolerance))
+            m_standbyMarkSent = false;
+
     if (m_aboutToFinishSent)
-        if (remaining >= tickInterval())
+        if (remaining > (aboutToFinishMark() + MarkTolerance))
             m_aboutToFinishSent = false;
+
+    if (m_transitionMarkSent)
+        if (remaining > (transitionTime() + MarkTolerance))
+            m_transitionMarkSent = false;
 }
 
 void MMF::AbstractMediaPlayer::setPending(Pending pending)
@@ -559,10 +851,46 @@ void MMF::AbstractMediaPlayer::setPending(Pending pending)
 void MMF::AbstractMediaPlayer::startPlayback()
 {
     doPlay();
+    m_clock.start(m_position);
     startPositionTimer();
+    startFadeTimer();
+    scheduleMarks();
     changeState(PlayingState);
 }
 
+qint64 MMF::AbstractMediaPlayer::queryPosition()
+{
+    ++m_positionQueryCount;
+    return getCurrentTime();
+}
+
+void MMF::AbstractMediaPlayer::stopClock()
+{
+    if (m_clock.isRunning()) {
+        const qint64 pos = queryPosition();
+        if (pos > m_position)
+            m_position = pos;
+        m_clock.stop(m_position);
+    }
+    m_markTimer->stop();
+}
+
+void MMF::AbstractMediaPlayer::traceClockStatistics()
+{
+    TRACE_CONTEXT(AbstractMediaPlayer::traceClockStatistics, EAudioInternal);
+
+    // Prior to the introduction of PlaybackClock, each tick resulted in one
+    // native position query, so the tick rate gives the baseline against
+    // which the query rate can be compared.
+    const qint64 runningTime = m_clock.runningTime();
+    if (runningTime > 0) {
+        TRACE("playback %Ld ms ticks %d (%d/s) native position queries %d (%d/s)",
+              runningTime,
+              m_tickCount, int(qint64(m_tickCount) * 1000 / runningTime),
+              m_positionQueryCount, int(qint64(m_positionQueryCount) * 1000 / runningTime));
+    }
+}
+
 void MMF::AbstractMediaPlayer::setProgressiveDownloadStalled()
 {
 #ifdef PHONON_MMF_PROGRESSIVE_DOWNLOAD
@@ -570,6 +898,7 @@ void MMF::AbstractMediaPlayer::setProgressiveDownloadStalled()
     TRACE_ENTRY("state %d", state());
     Q_ASSERT(isProgressiveDownload());
     m_downloadStalled = true;
+    stopClock();
     doClose();
     bufferingStarted();
     // Video player loses window handle when closed - need to reapply it here
@@ -655,6 +984,7 @@ void MMF::AbstractMediaPlayer::changeState(PrivateState newState)
         switch (m_pending) {
         case NothingPending:
             AbstractPlayer::changeState(newState);
+            doVolumeChanged();
             break;
 
         case PlayPending:
@@ -665,6 +995,7 @@ void MMF::AbstractMediaPlayer::changeState(PrivateState newState)
 
         case PausePending:
             AbstractPlayer::changeState(PausedState);
+            doVolumeChanged();
             break;
         }
 
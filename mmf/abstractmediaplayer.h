@@ -19,10 +19,12 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PHONON_MMF_ABSTRACTMEDIAPLAYER_H
 #define PHONON_MMF_ABSTRACTMEDIAPLAYER_H
 
-#include <QTimer>
 #include <QScopedPointer>
+#include <QTimer>
 #include <e32std.h>
 #include "abstractplayer.h"
+#include "playbackclock.h"
+#include "tickscheduler.h"
 #ifdef PHONON_MMF_PROGRESSIVE_DOWNLOAD
 #   include "download.h"
 #endif
@@ -43,6 +45,7 @@ class MediaObject;
  * accessed.
  */
 class AbstractMediaPlayer : public AbstractPlayer
+                          , public TickScheduler::Target
 {
     Q_OBJECT
 
@@ -50,6 +53,14 @@ protected:
     AbstractMediaPlayer(MediaObject *parent, const AbstractPlayer *player);
 
 public:
+    ~AbstractMediaPlayer();
+
+    /**
+     * Rebinds a closed player to parent, and resets it to the state of a
+     * newly constructed player.  Used by PlayerPool.
+     */
+    virtual void reuse(MediaObject *parent, const AbstractPlayer *player);
+
     virtual void open();
     virtual void close();
 
@@ -62,9 +73,30 @@ public:
     virtual qint64 currentTime() const;
     virtual void volumeChanged(qreal volume);
 
+    QMultiMap<QString, QString> metaData() const;
+
+    /**
+     * Ramps the fade level, which scales the volume, linearly from @p from
+     * to @p to over the next @p duration ms of playback.  The ramp follows
+     * the playback clock, so it is suspended while playback is paused.
+     */
+    void fade(qreal from, qreal to, qint64 duration);
+
+    /**
+     * Sets the fade level, cancelling any ramp which is in progress.
+     */
+    void setFadeLevel(qreal level);
+
+    /**
+     * Sets the level applied by a VolumeFader on the native path.  Like
+     * the fade level, it scales the volume; the two are independent.
+     */
+    void setFaderLevel(qreal level);
+
 protected:
     // AbstractPlayer
     virtual void doSetTickInterval(qint32 interval);
+    virtual void marksChanged();
     virtual Phonon::State phononState(PrivateState state) const;
     virtual void changeState(PrivateState newState);
 
@@ -102,12 +134,21 @@ private:
     void stopPositionTimer();
     void startBufferStatusTimer();
     void stopBufferStatusTimer();
+    void startFadeTimer();
+    void stopFadeTimer();
     void stopTimers();
     void doVolumeChanged();
+    qint64 aboutToFinishMark() const;
+    qint64 standbyMark() const;
+    qint64 nextMark() const;
+    void scheduleMarks();
     void emitMarksIfReached(qint64 position);
     void resetMarksIfRewound();
     void startPlayback();
     void setProgressiveDownloadStalled();
+    qint64 queryPosition();
+    void stopClock();
+    void traceClockStatistics();
 
     enum Pending {
         NothingPending,
@@ -117,29 +158,65 @@ private:
 
     void setPending(Pending pending);
 
-private Q_SLOTS:
+    // TickScheduler::Target
+    virtual void scheduledTick(int channel);
+
+    enum TickChannel {
+        PositionTickChannel,
+        BufferStatusTickChannel,
+        FadeTickChannel
+    };
+
     void positionTick();
     void bufferStatusTick();
+    void fadeTick();
+
+private Q_SLOTS:
+    void markTimerExpired();
 #ifdef PHONON_MMF_PROGRESSIVE_DOWNLOAD
     void downloadLengthChanged(qint64);
     void downloadStateChanged(Download::State);
 #endif
 
 private:
-    MediaObject *const          m_parent;
+    MediaObject                 *m_parent;
 
     Pending                     m_pending;
 
-    QScopedPointer<QTimer>      m_positionTimer;
+    // Not owned
+    TickScheduler *const        m_tickScheduler;
+
     qint64                      m_position;
 
-    QScopedPointer<QTimer>      m_bufferStatusTimer;
+    // Interpolates the position between native position queries
+    PlaybackClock               m_clock;
+    int                         m_tickCount;
+    int                         m_positionQueryCount;
+
     PrivateState                m_stateBeforeBuffering;
 
     int                         m_mmfMaxVolume;
 
+    // Last value passed to setDeviceVolume()
+    int                         m_deviceVolume;
+
+    // Scales m_volume during crossfades
+    qreal                       m_fadeLevel;
+    qreal                       m_fadeFrom;
+    qreal                       m_fadeTo;
+    qint64                      m_fadeStart;
+    qint64                      m_fadeDuration;
+
+    // Scales m_volume, as set by a VolumeFader
+    qreal                       m_faderLevel;
+
+    // Single-shot timer which expires when the next of the prefinish,
+    // standby, aboutToFinish and transition marks is due
+    QScopedPointer<QTimer>      m_markTimer;
     bool                        m_prefinishMarkSent;
+    bool                        m_standbyMarkSent;
     bool                        m_aboutToFinishSent;
+    bool                        m_transitionMarkSent;
 
     // Used for playback of resource files
     TPtrC8                      m_buffer;
@@ -41,6 +41,25 @@ MMF::AbstractPlayer::AbstractPlayer(const AbstractPlayer *player)
         ,   m_tickInterval(DefaultTickInterval)
         ,   m_transitionTime(0)
         ,   m_prefinishMark(0)
+{
+    copyParameters(player);
+}
+
+void MMF::AbstractPlayer::reinitialize(const AbstractPlayer *player)
+{
+    m_videoOutput = 0;
+    m_volume = InitialVolume;
+    m_state = GroundState;
+    m_error = NoError;
+    m_errorString.clear();
+    m_tickInterval = DefaultTickInterval;
+    m_transitionTime = 0;
+    m_prefinishMark = 0;
+
+    copyParameters(player);
+}
+
+void MMF::AbstractPlayer::copyParameters(const AbstractPlayer *player)
 {
     if(player) {
         m_videoOutput = player->m_videoOutput;
@@ -51,7 +70,10 @@ MMF::AbstractPlayer::AbstractPlayer(const AbstractPlayer *player)
 
         // This is to prevent unwanted state transitions occurring as a result
         // of MediaObject::switchToNextSource() during playlist playback.
-        if (StoppedState == player->m_state)
+        // The Phonon state is tested, rather than the private state, so that
+        // the state of the placeholder which MediaObject installs while a
+        // source is being opened (which reports LoadingState) is not copied.
+        if (StoppedState == player->m_state && Phonon::StoppedState == player->state())
             m_state = player->m_state;
     }
 }
@@ -79,6 +101,7 @@ qint32 MMF::AbstractPlayer::prefinishMark() const
 void MMF::AbstractPlayer::setPrefinishMark(qint32 mark)
 {
     m_prefinishMark = mark;
+    marksChanged();
 }
 
 qint32 MMF::AbstractPlayer::transitionTime() const
@@ -89,6 +112,7 @@ qint32 MMF::AbstractPlayer::transitionTime() const
 void MMF::AbstractPlayer::setTransitionTime(qint32 time)
 {
     m_transitionTime = time;
+    marksChanged();
 }
 
 void MMF::AbstractPlayer::volumeChanged(qreal volume)
@@ -112,6 +136,11 @@ void MMF::AbstractPlayer::videoOutputChanged()
     // Default behaviour is empty - overridden by VideoPlayer
 }
 
+void MMF::AbstractPlayer::marksChanged()
+{
+    // Default behaviour is empty - overridden by AbstractMediaPlayer
+}
+
 void MMF::AbstractPlayer::setError(const QString &errorMessage)
 {
     TRACE_CONTEXT(AbstractPlayer::setError, EAudioInternal);
@@ -110,6 +110,20 @@ Q_SIGNALS:
     void aboutToFinish();
     void prefinishMarkReached(qint32 remaining);
 
+    /**
+     * Emitted a fixed time before the end of the clip, or before the
+     * transition to the next clip, so that the next source can be opened
+     * in advance.  Unlike aboutToFinish(), this does not depend on the
+     * tick interval.
+     */
+    void standbyMarkReached();
+
+    /**
+     * Emitted transitionTime() before the end of the clip, if
+     * transitionTime() is positive
+     */
+    void transitionMarkReached();
+
 protected:
     /**
      * Defined private state enumeration in order to add GroundState
@@ -149,8 +163,17 @@ protected:
      */
     void setState(PrivateState newState);
 
+    /**
+     * Returns the player to its initial state, and copies parameters from
+     * player as the constructor does.  Used when a player is reused.
+     */
+    void reinitialize(const AbstractPlayer *player);
+
 private:
+    void copyParameters(const AbstractPlayer *player);
+
     virtual void doSetTickInterval(qint32 interval) = 0;
+    virtual void marksChanged();
 
 protected:
     // Not owned
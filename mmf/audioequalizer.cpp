@@ -16,8 +16,8 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-#include <AudioEqualizerBase.h>
 #include "audioequalizer.h"
+#include "biquadequalizer.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -28,27 +28,45 @@ using namespace Phonon::MMF;
   \internal
 */
 
-// Define functions which depend on concrete native effect class name
-PHONON_MMF_DEFINE_EFFECT_FUNCTIONS(AudioEqualizer)
-
-AudioEqualizer::AudioEqualizer(QObject *parent, const QList<EffectParameter>& parameters)
-    :   AbstractAudioEffect::AbstractAudioEffect(parent, parameters)
+AudioEqualizer::AudioEqualizer(QObject *parent, const EffectDescriptorPointer &descriptor)
+    :   NativeAudioEffect<CAudioEqualizer>(parent, descriptor)
 {
 
 }
 
 int AudioEqualizer::effectParameterChanged(const EffectParameter &param,
-                                      const QVariant &value)
+                                      qint32 internalLevel)
 {
     const int band = param.id() - ParameterBase + 1;
 
-    const qreal externalLevel = value.toReal();
-    const int internalLevel = param.toInternalValue(externalLevel);
-
     TRAPD(err, concreteEffect()->SetBandLevelL(band, internalLevel));
     return err;
 }
 
+AudioProcessor *AudioEqualizer::createProcessor(int sampleRate, int channelCount)
+{
+    if (channelCount > BiquadEqualizer::MaxChannelCount)
+        return 0;
+
+    // The bands have the same center frequencies as those of the native
+    // equalizer; the native bandwidths are not known, so the default of
+    // one octave is used.
+    QVector<BiquadEqualizer::Band> bands;
+    const EffectDescriptor &parameters = *descriptor();
+    for (int i = 0; i < parameters.count(); ++i)
+        if (parameters.parameter(i).id() >= ParameterBase)
+            bands.append(BiquadEqualizer::Band(parameters.parameter(i).frequency()));
+
+    return new BiquadEqualizer(sampleRate, channelCount, bands);
+}
+
+void AudioEqualizer::processorParameterChanged(const EffectParameter &param,
+                                               qint32 internalLevel)
+{
+    BiquadEqualizer *const equalizer = static_cast<BiquadEqualizer *>(m_processor.data());
+    equalizer->setBandLevel(param.id() - ParameterBase, internalLevel);
+}
+
 
 //-----------------------------------------------------------------------------
 // Static functions
@@ -96,6 +114,7 @@ bool AudioEqualizer::getParameters(CMdaAudioOutputStream *stream,
                  /* maximumValue */       QVariant(qreal(+1.0)));
 
             param.setInternalRange(dbMin, dbMax);
+            param.setFrequency(hz);
             parameters.append(param);
         }
     }
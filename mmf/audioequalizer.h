@@ -19,9 +19,9 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PHONON_MMF_AUDIOEQUALIZER_H
 #define PHONON_MMF_AUDIOEQUALIZER_H
 
-#include "abstractaudioeffect.h"
+#include <AudioEqualizerBase.h>
 
-class CAudioEqualizer;
+#include "abstractaudioeffect.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -37,11 +37,11 @@ namespace MMF
  * Phonon::EffectParameter, where Phonon::EffectParameter::id() is the band
  * number, and the setting is the volume level.
  */
-class AudioEqualizer : public AbstractAudioEffect
+class AudioEqualizer : public NativeAudioEffect<CAudioEqualizer>
 {
     Q_OBJECT
 public:
-    AudioEqualizer(QObject *parent, const QList<EffectParameter> &parameters);
+    AudioEqualizer(QObject *parent, const EffectDescriptorPointer &descriptor);
 
     // Static interface required by EffectFactory
     static const char* description();
@@ -50,13 +50,11 @@ public:
 
 protected:
     // AbstractAudioEffect
-    virtual void createEffect(AudioPlayer::NativePlayer *player);
     virtual int effectParameterChanged(const EffectParameter &param,
-                                       const QVariant &value);
-
-private:
-    CAudioEqualizer *concreteEffect();
-
+                                       qint32 internalLevel);
+    virtual AudioProcessor *createProcessor(int sampleRate, int channelCount);
+    virtual void processorParameterChanged(const EffectParameter &param,
+                                           qint32 internalLevel);
 };
 }
 }
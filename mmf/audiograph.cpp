@@ -0,0 +1,268 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "audiograph.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::AudioGraph
+  \internal
+*/
+
+/*! \class MMF::AudioSource
+  \internal
+*/
+
+/*! \class MMF::AudioProcessor
+  \internal
+*/
+
+/*! \class MMF::AudioSink
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+AudioGraph::AudioGraph(int sampleRate, int channelCount, int blockFrames)
+    :   m_sampleRate(sampleRate)
+    ,   m_channelCount(channelCount)
+    ,   m_blockFrames(blockFrames)
+    ,   m_sink(0)
+    ,   m_nextRouteId(0)
+    ,   m_input(blockFrames * channelCount)
+    ,   m_source(blockFrames * channelCount)
+    ,   m_output(blockFrames * channelCount)
+{
+    Q_ASSERT_X(sampleRate > 0 && channelCount > 0 && blockFrames > 0,
+               Q_FUNC_INFO, "Invalid format");
+}
+
+AudioGraph::~AudioGraph()
+{
+
+}
+
+AudioGraph::Stage::Stage(AudioProcessor *processor, int parent, bool output)
+    :   m_processor(processor)
+    ,   m_parent(parent)
+    ,   m_output(output)
+{
+
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+int AudioGraph::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+int AudioGraph::channelCount() const
+{
+    return m_channelCount;
+}
+
+int AudioGraph::blockFrames() const
+{
+    return m_blockFrames;
+}
+
+void AudioGraph::setSink(AudioSink *sink)
+{
+    m_sink = sink;
+}
+
+AudioSink *AudioGraph::sink() const
+{
+    return m_sink;
+}
+
+int AudioGraph::createRoute()
+{
+    Route route;
+    route.m_id = m_nextRouteId++;
+    m_routes.append(route);
+    return route.m_id;
+}
+
+void AudioGraph::destroyRoute(int id)
+{
+    for (int i = 0; i < m_routes.count(); ++i) {
+        if (m_routes[i].m_id == id) {
+            m_routes.removeAt(i);
+            updateStageBuffers();
+            break;
+        }
+    }
+}
+
+void AudioGraph::setStages(int id, const QList<Stage> &stages)
+{
+    Route *const r = route(id);
+    if (!r)
+        return;
+
+    r->m_stages = stages;
+    r->m_depths.resize(stages.count());
+    for (int i = 0; i < stages.count(); ++i) {
+        const int parent = stages.at(i).m_parent;
+        Q_ASSERT_X(parent < i, Q_FUNC_INFO, "Stage precedes its parent");
+        r->m_depths[i] = parent < 0 ? 1 : r->m_depths[parent] + 1;
+    }
+
+    updateStageBuffers();
+}
+
+void AudioGraph::addSource(int id, AudioSource *source)
+{
+    Route *const r = route(id);
+    if (r && !r->m_sources.contains(source))
+        r->m_sources.append(source);
+}
+
+void AudioGraph::removeSource(int id, AudioSource *source)
+{
+    if (Route *const r = route(id))
+        r->m_sources.removeAll(source);
+}
+
+void AudioGraph::start()
+{
+    if (m_sink)
+        m_sink->start(this);
+}
+
+bool AudioGraph::isPlaying() const
+{
+    foreach (const Route &route, m_routes)
+        foreach (AudioSource *source, route.m_sources)
+            if (source->isPlaying())
+                return true;
+    return false;
+}
+
+bool AudioGraph::renderBlock()
+{
+    const bool playing = mixBlock();
+    if (playing && m_sink)
+        m_sink->writeAudio(m_output.constData(), m_blockFrames);
+    return playing;
+}
+
+void AudioGraph::render(int frameCount)
+{
+    for (int rendered = 0; rendered < frameCount; rendered += m_blockFrames) {
+        mixBlock();
+        if (m_sink)
+            m_sink->writeAudio(m_output.constData(), m_blockFrames);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+AudioGraph::Route *AudioGraph::route(int id)
+{
+    for (int i = 0; i < m_routes.count(); ++i)
+        if (m_routes[i].m_id == id)
+            return &m_routes[i];
+    return 0;
+}
+
+/**
+ * Allocates one buffer for each level of the deepest route.
+ */
+void AudioGraph::updateStageBuffers()
+{
+    int maxDepth = 0;
+    foreach (const Route &route, m_routes)
+        foreach (int depth, route.m_depths)
+            maxDepth = qMax(maxDepth, depth);
+
+    m_stageOutputs.resize(maxDepth * m_blockFrames * m_channelCount);
+}
+
+/**
+ * Renders a block into m_output.  Returns true if any source is playing.
+ */
+bool AudioGraph::mixBlock()
+{
+    const int sampleCount = m_blockFrames * m_channelCount;
+    float *const input = m_input.data();
+    float *const source = m_source.data();
+    float *const output = m_output.data();
+
+    bool playing = false;
+    m_output.fill(0.0f);
+
+    for (int r = 0; r < m_routes.count(); ++r) {
+        const Route &route = m_routes.at(r);
+
+        // Mix the sources of the route.  Sources which are not playing
+        // are skipped, as are routes with no playing sources.
+        bool routePlaying = false;
+        foreach (AudioSource *audioSource, route.m_sources) {
+            float *const samples = routePlaying ? source : input;
+            const int frames = audioSource->readAudio(samples, m_blockFrames);
+            if (frames) {
+                for (int i = frames * m_channelCount; i < sampleCount; ++i)
+                    samples[i] = 0.0f;
+                if (routePlaying)
+                    for (int i = 0; i < sampleCount; ++i)
+                        input[i] += source[i];
+                routePlaying = true;
+            }
+        }
+
+        if (!routePlaying)
+            continue;
+        playing = true;
+
+        // Because the stages are in depth-first order, the output of the
+        // parent of each stage is the most recent output one level up.
+        for (int i = 0; i < route.m_stages.count(); ++i) {
+            const Stage &stage = route.m_stages.at(i);
+            const int depth = route.m_depths.at(i);
+            const float *const in = depth > 1
+                ? m_stageOutputs.constData() + (depth - 2) * sampleCount : input;
+            float *const out = m_stageOutputs.data() + (depth - 1) * sampleCount;
+
+            qCopy(in, in + sampleCount, out);
+            if (stage.m_processor)
+                stage.m_processor->process(out, m_blockFrames);
+            if (stage.m_output)
+                for (int j = 0; j < sampleCount; ++j)
+                    output[j] += out[j];
+        }
+    }
+
+    return playing;
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,218 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_AUDIOGRAPH_H
+#define PHONON_MMF_AUDIOGRAPH_H
+
+#include <QList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Supplies PCM to an AudioGraph
+ */
+class AudioSource
+{
+public:
+    virtual ~AudioSource() { }
+
+    /**
+     * Reads up to frameCount frames of interleaved samples, in the format
+     * of the graph.  Returns the number of frames read, which is zero
+     * unless the source is playing.
+     */
+    virtual int readAudio(float *samples, int frameCount) = 0;
+
+    virtual bool isPlaying() const = 0;
+};
+
+/**
+ * @short Processes PCM in place, as a stage of an AudioGraph route
+ */
+class AudioProcessor
+{
+public:
+    virtual ~AudioProcessor() { }
+
+    virtual void process(float *samples, int frameCount) = 0;
+};
+
+class AudioGraph;
+
+/**
+ * @short Consumes the output of an AudioGraph
+ *
+ * The sink determines when blocks are rendered: either it pulls them by
+ * calling AudioGraph::renderBlock(), or, for offline rendering, the
+ * client calls AudioGraph::render().
+ */
+class AudioSink
+{
+public:
+    virtual ~AudioSink() { }
+
+    /**
+     * Called when a source starts playing.  Sinks which pull blocks should
+     * start doing so if they have stopped.
+     */
+    virtual void start(AudioGraph *graph) = 0;
+
+    virtual void writeAudio(const float *samples, int frameCount) = 0;
+};
+
+/**
+ * @short Renders PCM through trees of in-process effects
+ *
+ * A graph contains a number of routes, each of which corresponds to a
+ * MediaObject.  The sources of a route are mixed, and then passed through
+ * the route's stages, which form a tree corresponding to the nodes
+ * connected to the MediaObject.  Each stage processes the output of its
+ * parent, so a stage which feeds several others is applied once per
+ * block.  The outputs of the output stages of all routes are mixed, and
+ * written to a single sink.
+ *
+ * All sources, processors and the sink use the format of the graph, and
+ * audio is processed in blocks of blockFrames() frames.  Working storage
+ * is allocated on construction and by setStages(), so rendering does not
+ * allocate.
+ *
+ * The graph does not depend on the native multimedia framework, so the
+ * same graph can be rendered to a WavFileSink, for example in a host
+ * build.  It is not thread-safe: rendering must take place in the thread
+ * which modifies the graph.
+ */
+class AudioGraph
+{
+public:
+    AudioGraph(int sampleRate, int channelCount, int blockFrames);
+    ~AudioGraph();
+
+    /**
+     * A stage of a route.  Stages without a parent process the mix of the
+     * route's sources.  The output of an output stage is mixed into the
+     * output of the graph; other leaf stages, such as a Visualization,
+     * only observe the audio.
+     */
+    struct Stage
+    {
+        Stage(AudioProcessor *processor, int parent, bool output);
+
+        // May be null, in which case the stage passes its input through
+        AudioProcessor *        m_processor;
+
+        // Index of the parent stage, or -1
+        int                     m_parent;
+
+        bool                    m_output;
+    };
+
+    int sampleRate() const;
+    int channelCount() const;
+    int blockFrames() const;
+
+    /**
+     * Not owned.
+     */
+    void setSink(AudioSink *sink);
+    AudioSink *sink() const;
+
+    /**
+     * Returns an identifier for a new route, which has no sources and no
+     * stages.
+     */
+    int createRoute();
+    void destroyRoute(int route);
+
+    /**
+     * Each stage must follow its parent, and the stages which descend from
+     * a stage must follow it without interruption, i.e. the stages are in
+     * depth-first order.
+     */
+    void setStages(int route, const QList<Stage> &stages);
+
+    void addSource(int route, AudioSource *source);
+    void removeSource(int route, AudioSource *source);
+
+    /**
+     * Asks the sink to start pulling blocks.  Called when a source starts
+     * playing.
+     */
+    void start();
+
+    /**
+     * Returns true if any source is playing.
+     */
+    bool isPlaying() const;
+
+    /**
+     * Renders a block and writes it to the sink.  Returns false, without
+     * writing anything, if no source is playing.
+     */
+    bool renderBlock();
+
+    /**
+     * Renders at least frameCount frames, in whole blocks, regardless of
+     * whether any source is playing.  Used for offline rendering.
+     */
+    void render(int frameCount);
+
+private:
+    struct Route
+    {
+        int                     m_id;
+        QList<AudioSource *>    m_sources;
+        QList<Stage>            m_stages;
+
+        // Depth of each stage; stages without a parent have a depth of 1
+        QVector<int>            m_depths;
+    };
+
+    Route *route(int id);
+    void updateStageBuffers();
+    bool mixBlock();
+
+private:
+    const int                   m_sampleRate;
+    const int                   m_channelCount;
+    const int                   m_blockFrames;
+
+    AudioSink *                 m_sink;
+
+    QList<Route>                m_routes;
+    int                         m_nextRouteId;
+
+    QVector<float>              m_input;
+    QVector<float>              m_source;
+    QVector<float>              m_output;
+
+    // Output of the most recent stage at each depth, starting at 1
+    QVector<float>              m_stageOutputs;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
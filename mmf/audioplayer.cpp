@@ -20,6 +20,9 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include <QUrl>
 
 #include "audioplayer.h"
+#include "backend.h"
+#include "mediaobject.h"
+#include "playerpool.h"
 #include "utils.h"
 
 QT_BEGIN_NAMESPACE
@@ -39,16 +42,25 @@ MMF::AudioPlayer::AudioPlayer(MediaObject *parent, const AbstractPlayer *player)
         :   AbstractMediaPlayer(parent, player)
         ,   m_totalTime(0)
 {
-    construct();
+    construct(parent);
 }
 
-void MMF::AudioPlayer::construct()
+void MMF::AudioPlayer::construct(MediaObject *parent)
 {
     TRACE_CONTEXT(AudioPlayer::AudioPlayer, EAudioApi);
     TRACE_ENTRY_0();
 
     NativePlayer *player = 0;
-    QT_TRAP_THROWING(player = NativePlayer::NewL(*this, 0, EMdaPriorityPreferenceNone));
+    TRAPD(err, player = NativePlayer::NewL(*this, 0, EMdaPriorityPreferenceNone));
+
+    if (KErrNoMemory == err) {
+        // Free the native players which are held for reuse, and try again
+        TRACE_0("Out of memory - purging player pool");
+        parent->backend()->playerPool()->purge();
+        TRAP(err, player = NativePlayer::NewL(*this, 0, EMdaPriorityPreferenceNone));
+    }
+
+    QT_TRAP_THROWING(User::LeaveIfError(err));
     m_player.reset(player);
     m_player->RegisterForAudioLoadingNotification(*this);
 
@@ -68,6 +80,15 @@ MMF::AudioPlayer::NativePlayer *MMF::AudioPlayer::nativePlayer() const
     return m_player.data();
 }
 
+void MMF::AudioPlayer::reuse(MediaObject *parent, const AbstractPlayer *player)
+{
+    AbstractMediaPlayer::reuse(parent, player);
+    m_totalTime = 0;
+
+    // As in construct(), in case the registration did not survive Close()
+    m_player->RegisterForAudioLoadingNotification(*this);
+}
+
 //-----------------------------------------------------------------------------
 // Public API
 //-----------------------------------------------------------------------------
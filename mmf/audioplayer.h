@@ -59,6 +59,9 @@ typedef CMdaAudioPlayerUtility NativePlayer;
 
     NativePlayer *nativePlayer() const;
 
+    // AbstractMediaPlayer
+    virtual void reuse(MediaObject *parent, const AbstractPlayer *player);
+
     // AbstractMediaPlayer
     virtual void doPlay();
     virtual void doPause();
@@ -87,7 +90,7 @@ typedef CMdaAudioPlayerUtility NativePlayer;
     NativePlayer *player() const;
 
 private:
-    void construct();
+    void construct(MediaObject *parent);
 
 private:
 #ifdef QT_PHONON_MMF_AUDIO_DRM
@@ -16,13 +16,10 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
+#include <QDynamicPropertyChangeEvent>
 #include <QStringList>
 #include <QtPlugin>
 
-#include <apgcli.h> // for RApaLsSession
-#include <apmrec.h> // for CDataTypeArray
-#include <apmstd.h> // for TDataType
-
 #include "abstractaudioeffect.h"
 #include "audiooutput.h"
 #include "audioplayer.h"
@@ -31,6 +28,8 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "mediaobject.h"
 #include "utils.h"
 #include "videowidget.h"
+#include "visualization.h"
+#include "volumefader.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -41,12 +40,29 @@ using namespace Phonon::MMF;
   \internal
 */
 
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Defaults for the in-process rendering properties
+const int       DefaultSoftwareSampleRate = 44100;
+const int       DefaultSoftwareBlockSize = 1024;    // frames
+const int       DefaultSoftwareLatency = 100;       // ms
+
+// In-process rendering is always in stereo
+const int       SoftwareChannelCount = 2;
+
+
 Backend::Backend(QObject *parent)
     : QObject(parent)
 #ifndef PHONON_MMF_VIDEO_SURFACES
     , m_ancestorMoveMonitor(new AncestorMoveMonitor(this))
 #endif
     , m_effectFactory(new EffectFactory(this))
+    , m_tickScheduler(new TickScheduler(this))
+    , m_recognizerCache(new RecognizerCache)
+    , m_mimeTypeCache(new MimeTypeCache)
+    , m_playerPool(new PlayerPool(this))
 {
     TRACE_CONTEXT(Backend::Backend, EBackend);
     TRACE_ENTRY_0();
@@ -57,6 +73,32 @@ Backend::Backend(QObject *parent)
     setProperty("backendVersion", QLatin1String("0.1"));
     setProperty("backendWebsite", QLatin1String("http://qt.nokia.com/"));
 
+    // Clients may change this property in order to resize the player pool
+    setProperty("playerPoolSize", m_playerPool->capacity());
+
+    // Setting softwareRendering to true causes audio to be decoded and
+    // processed in process, and written to a native output stream, rather
+    // than being played by the native audio player.  This allows effects
+    // to be applied in the order in which they are connected.  The other
+    // properties take effect when softwareRendering is set, and none of
+    // them affects MediaObjects which already exist.  If the output stream
+    // does not support softwareSampleRate, softwareRendering is reset to
+    // false.
+    setProperty("softwareRendering", false);
+    setProperty("softwareSampleRate", DefaultSoftwareSampleRate);
+    setProperty("softwareBlockSize", DefaultSoftwareBlockSize);
+    setProperty("softwareLatency", DefaultSoftwareLatency);
+
+    // Maximum number of device volume updates made by a VolumeFader during
+    // a fade, if the player does not render in process
+    setProperty("faderStepBudget", VolumeFader::DefaultStepBudget);
+
+    // Setting effectPresetFile adds the effect presets stored in that file,
+    // which can then be applied via AbstractAudioEffect::applyPreset().
+    // Presets in phonon_mmf_effects.presets, in the application's private
+    // directory, are loaded by default.
+    setProperty("effectPresetFile", QString());
+
     TRACE_EXIT_0();
 }
 
@@ -73,11 +115,17 @@ QObject *Backend::createObject(BackendInterface::Class c, QObject *parent, const
         break;
 
     case MediaObjectClass:
-        result = new MediaObject(parent);
+        result = new MediaObject(this, parent);
         break;
 
     case VolumeFaderEffectClass:
+        result = new VolumeFader(this, parent);
+        break;
+
     case VisualizationClass:
+        result = new Visualization(this, parent);
+        break;
+
     case VideoDataOutputClass:
     case EffectClass:
     {
@@ -176,45 +224,105 @@ bool Backend::disconnectNodes(QObject *sourceObject, QObject *targetObject)
     return source->disconnectOutput(target);
 }
 
-bool Backend::endConnectionChange(QSet<QObject *>)
+bool Backend::endConnectionChange(QSet<QObject *> objects)
 {
+    // The in-process routes follow the connections between nodes
+    if (m_audioGraph) {
+        QSet<MediaObject *> mediaObjects;
+        foreach (QObject *object, objects) {
+            MediaNode *const node = qobject_cast<MediaNode *>(object);
+            if (node && node->mediaObject())
+                mediaObjects.insert(node->mediaObject());
+        }
+
+        foreach (MediaObject *mediaObject, mediaObjects)
+            mediaObject->updateAudioRoute();
+    }
+
     return true;
 }
 
-void getAvailableMimeTypesL(QStringList& result)
+QStringList Backend::availableMimeTypes() const
 {
-    RApaLsSession apaSession;
-    User::LeaveIfError(apaSession.Connect());
-    CleanupClosePushL(apaSession);
+    return m_mimeTypeCache->mimeTypes();
+}
 
-    static const TInt DataTypeArrayGranularity = 8;
-    CDataTypeArray* array = new(ELeave) CDataTypeArray(DataTypeArrayGranularity);
-    CleanupStack::PushL(array);
+EffectFactory *Backend::effectFactory() const
+{
+    return m_effectFactory.data();
+}
 
-    apaSession.GetSupportedDataTypesL(*array);
+TickScheduler *Backend::tickScheduler() const
+{
+    return m_tickScheduler.data();
+}
 
-    for (TInt i = 0; i < array->Count(); ++i) {
-        const TPtrC mimeType = array->At(i).Des();
-        const MediaType mediaType = Utils::mimeTypeToMediaType(mimeType);
-        if (MediaTypeAudio == mediaType or MediaTypeVideo == mediaType) {
-            result.append(qt_TDesC2QString(mimeType));
+PlayerPool *Backend::playerPool() const
+{
+    return m_playerPool.data();
+}
+
+RecognizerCache *Backend::recognizerCache() const
+{
+    return m_recognizerCache.data();
+}
+
+MimeTypeCache *Backend::mimeTypeCache() const
+{
+    return m_mimeTypeCache.data();
+}
+
+AudioGraph *Backend::audioGraph() const
+{
+    return m_audioGraph.data();
+}
+
+bool Backend::event(QEvent *event)
+{
+    if (QEvent::DynamicPropertyChange == event->type()) {
+        const QByteArray name =
+            static_cast<QDynamicPropertyChangeEvent *>(event)->propertyName();
+        if (name == "playerPoolSize")
+            m_playerPool->setCapacity(property(name.constData()).toInt());
+        if (name == "softwareRendering" && property(name.constData()).toBool())
+            enableSoftwareRendering();
+        if (name == "effectPresetFile") {
+            const QString fileName = property(name.constData()).toString();
+            if (!fileName.isEmpty())
+                m_effectFactory->loadPresets(fileName);
         }
     }
 
-    CleanupStack::PopAndDestroy(2); // apaSession, array
+    return QObject::event(event);
 }
 
-QStringList Backend::availableMimeTypes() const
+void Backend::enableSoftwareRendering()
 {
-    QStringList result;
-
-    // There is no way to return an error from this function, so we just
-    // have to trap and ignore exceptions...
-    TRAP_IGNORE(getAvailableMimeTypesL(result));
+    TRACE_CONTEXT(Backend::enableSoftwareRendering, EBackend);
+    TRACE_ENTRY_0();
 
-    result.sort();
+    // Once enabled, in-process rendering cannot be disabled, because
+    // existing players hold pointers to the graph.
+    if (!m_audioGraph) {
+        const int sampleRate = property("softwareSampleRate").toInt();
+        const int blockSize = property("softwareBlockSize").toInt();
+        const int latency = property("softwareLatency").toInt();
+
+        // A rate which the output stream does not support leaves
+        // in-process rendering disabled, rather than playing at the wrong
+        // pitch.
+        if (OutputStreamSink::isSampleRateSupported(sampleRate)) {
+            m_audioGraph.reset(new AudioGraph(sampleRate, SoftwareChannelCount,
+                blockSize > 0 ? blockSize : DefaultSoftwareBlockSize));
+            m_audioSink.reset(new OutputStreamSink(m_audioGraph.data(), latency));
+            m_audioGraph->setSink(m_audioSink.data());
+        } else {
+            TRACE("unsupported sample rate %d", sampleRate);
+            setProperty("softwareRendering", false);
+        }
+    }
 
-    return result;
+    TRACE_EXIT_0();
 }
 
 Q_EXPORT_PLUGIN2(phonon_mmf, Phonon::MMF::Backend);
@@ -23,7 +23,13 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "ancestormovemonitor.h"
 #endif
 
+#include "audiograph.h"
 #include "effectfactory.h"
+#include "mimetypecache.h"
+#include "outputstreamsink.h"
+#include "playerpool.h"
+#include "recognizercache.h"
+#include "tickscheduler.h"
 
 #include <phonon/mediasource.h>
 #include <phonon/backendinterface.h>
@@ -52,14 +58,43 @@ public:
     virtual bool endConnectionChange(QSet<QObject *>);
     virtual QStringList availableMimeTypes() const;
 
+    EffectFactory *effectFactory() const;
+    TickScheduler *tickScheduler() const;
+    PlayerPool *playerPool() const;
+    RecognizerCache *recognizerCache() const;
+    MimeTypeCache *mimeTypeCache() const;
+
+    /**
+     * Returns the graph via which audio is rendered in process, or null if
+     * in-process rendering is not enabled.  See the "softwareRendering"
+     * property.
+     */
+    AudioGraph *audioGraph() const;
+
+    // QObject
+    virtual bool event(QEvent *event);
+
 Q_SIGNALS:
     void objectDescriptionChanged(ObjectDescriptionType);
 
+private:
+    void enableSoftwareRendering();
+
 private:
 #ifndef PHONON_MMF_VIDEO_SURFACES
     QScopedPointer<AncestorMoveMonitor> m_ancestorMoveMonitor;
 #endif
     QScopedPointer<EffectFactory>       m_effectFactory;
+    QScopedPointer<TickScheduler>       m_tickScheduler;
+    QScopedPointer<RecognizerCache>     m_recognizerCache;
+    QScopedPointer<MimeTypeCache>       m_mimeTypeCache;
+
+    QScopedPointer<AudioGraph>          m_audioGraph;
+    QScopedPointer<OutputStreamSink>    m_audioSink;
+
+    // Declared last, so that pooled and released players are destroyed
+    // before the scheduler and the graph which they use
+    QScopedPointer<PlayerPool>          m_playerPool;
 
 };
 }
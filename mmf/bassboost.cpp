@@ -16,25 +16,38 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-#include <BassBoostBase.h>
 #include "bassboost.h"
+#include "shelffilter.h"
 
 QT_BEGIN_NAMESPACE
 
 using namespace Phonon;
 using namespace Phonon::MMF;
 
-// Define functions which depend on concrete native effect class name
-PHONON_MMF_DEFINE_EFFECT_FUNCTIONS(BassBoost)
-
 /*! \class MMF::BassBoost
   \internal
 */
 
-BassBoost::BassBoost(QObject *parent, const QList<EffectParameter> &parameters)
-    :   AbstractAudioEffect::AbstractAudioEffect(parent, parameters)
+// The native effect has no parameters, so the in-process implementation
+// applies a fixed low shelf.
+const qreal     BassBoostFrequency = 100.0;    // Hz
+const qint32    BassBoostLevel = 800;           // mB
+
+BassBoost::BassBoost(QObject *parent, const EffectDescriptorPointer &descriptor)
+    :   NativeAudioEffect<CBassBoost>(parent, descriptor)
+{
+
+}
+
+AudioProcessor *BassBoost::createProcessor(int sampleRate, int channelCount)
 {
+    if (channelCount > ShelfFilter::MaxChannelCount)
+        return 0;
 
+    ShelfFilter *const filter = new ShelfFilter(channelCount, 1);
+    filter->setCoefficients(0, ShelfFilter::design(ShelfFilter::LowShelf,
+        BassBoostFrequency, BassBoostLevel, sampleRate));
+    return filter;
 }
 
 //-----------------------------------------------------------------------------
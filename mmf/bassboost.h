@@ -19,9 +19,9 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PHONON_MMF_BASSBOOST_H
 #define PHONON_MMF_BASSBOOST_H
 
-#include "abstractaudioeffect.h"
+#include <BassBoostBase.h>
 
-class CBassBoost;
+#include "abstractaudioeffect.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -32,11 +32,11 @@ namespace MMF
 /**
  * @short A "bass boost" effect.
  */
-class BassBoost : public AbstractAudioEffect
+class BassBoost : public NativeAudioEffect<CBassBoost>
 {
     Q_OBJECT
 public:
-    BassBoost(QObject *parent, const QList<EffectParameter> &parameters);
+    BassBoost(QObject *parent, const EffectDescriptorPointer &descriptor);
 
     // Static interface required by EffectFactory
     static const char* description();
@@ -45,10 +45,7 @@ public:
 
 protected:
     // AbstractAudioEffect
-    virtual void createEffect(AudioPlayer::NativePlayer *player);
-
-private:
-    CBassBoost *concreteEffect();
+    virtual AudioProcessor *createProcessor(int sampleRate, int channelCount);
 
 };
 }
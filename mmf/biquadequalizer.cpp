@@ -0,0 +1,420 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+
+#include "biquadequalizer.h"
+#include "dspkernel.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::BiquadEqualizer
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Number of frames filtered between successive updates of the coefficients
+// of ramping bands
+const int       BlockFrames = 32;
+
+// Once a band is flat, its filter state is discarded when it falls below
+// this level, relative to full scale, after which the band is bypassed.
+const float     StateThreshold = 1.0e-7f;
+
+// State values below this level are flushed to zero, in order to avoid
+// the cost of denormal arithmetic as the filters decay.
+const float     DenormalThreshold = 1.0e-20f;
+
+#ifdef PHONON_MMF_DSP_SIMD
+const int       SimdLanes = SimdKernel::Lanes;
+
+// Signals with up to this many channels are filtered two bands at a time,
+// one in each pair of lanes, by filterBandPairs(); wider signals are
+// filtered SimdLanes channels at a time, by filterBlock().
+const int       PairLanes = SimdLanes / 2;
+#else
+const int       SimdLanes = 1;
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+BiquadEqualizer::Band::Band(qint32 centerFrequency, qint32 bandwidth)
+    :   m_centerFrequency(centerFrequency)
+    ,   m_bandwidth(bandwidth)
+{
+
+}
+
+BiquadEqualizer::BiquadEqualizer(int sampleRate, int channelCount,
+                                 const QVector<Band> &bands)
+    :   m_sampleRate(sampleRate)
+    ,   m_channelCount(channelCount)
+    ,   m_simd(laneCount(channelCount) > 1)
+    ,   m_lanes(laneCount(channelCount))
+    ,   m_groupCount((channelCount + m_lanes - 1) / m_lanes)
+    ,   m_bands(bands)
+    ,   m_cosOmega(bands.count())
+    ,   m_alpha(bands.count())
+    ,   m_targetLevels(bands.count())
+    ,   m_currentLevels(bands.count())
+    ,   m_levelSteps(bands.count())
+    ,   m_rampBlocks(bands.count())
+    ,   m_rampBlockCount(qMax(1, (RampDuration * sampleRate / 1000 + BlockFrames - 1) / BlockFrames))
+    ,   m_coefficients(bands.count())
+    ,   m_stateClear(bands.count())
+    ,   m_state1(bands.count() * m_groupCount * m_lanes)
+    ,   m_state2(bands.count() * m_groupCount * m_lanes)
+    ,   m_block(m_groupCount * BlockFrames * m_lanes)
+{
+    Q_ASSERT_X(channelCount > 0 && channelCount <= MaxChannelCount,
+               Q_FUNC_INFO, "Invalid channel count");
+    Q_ASSERT_X(sampleRate > 0, Q_FUNC_INFO, "Invalid sample rate");
+
+    m_activeBands.reserve(bands.count());
+
+    for (int i = 0; i < bands.count(); ++i) {
+        const qreal frequency = bands[i].m_centerFrequency;
+
+        // Bands which cannot be represented at this sample rate have an
+        // alpha of zero, which makes them flat at any level.
+        if (frequency > 0 && frequency < 0.5 * sampleRate) {
+            const qreal bandwidth = bands[i].m_bandwidth > 0
+                ? qreal(bands[i].m_bandwidth)
+                : frequency * (M_SQRT2 - M_SQRT1_2);
+            const qreal omega = 2.0 * M_PI * frequency / sampleRate;
+            const qreal q = frequency / bandwidth;
+            m_cosOmega[i] = qCos(omega);
+            m_alpha[i] = qSin(omega) / (2.0 * q);
+        }
+    }
+
+    reset();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+int BiquadEqualizer::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+int BiquadEqualizer::channelCount() const
+{
+    return m_channelCount;
+}
+
+int BiquadEqualizer::bandCount() const
+{
+    return m_bands.count();
+}
+
+BiquadEqualizer::Band BiquadEqualizer::band(int index) const
+{
+    return m_bands.at(index);
+}
+
+void BiquadEqualizer::setBandLevel(int index, qint32 millibels)
+{
+    Q_ASSERT_X(index >= 0 && index < m_bands.count(), Q_FUNC_INFO,
+               "Invalid band index");
+
+    if (millibels != m_targetLevels[index]) {
+        m_targetLevels[index] = millibels;
+        m_levelSteps[index] = (millibels - m_currentLevels[index]) / m_rampBlockCount;
+        m_rampBlocks[index] = m_rampBlockCount;
+    }
+}
+
+qint32 BiquadEqualizer::bandLevel(int index) const
+{
+    return m_targetLevels.at(index);
+}
+
+void BiquadEqualizer::reset()
+{
+    for (int i = 0; i < m_bands.count(); ++i) {
+        m_currentLevels[i] = m_targetLevels[i];
+        m_rampBlocks[i] = 0;
+        m_stateClear[i] = true;
+        updateCoefficients(i);
+    }
+
+    m_state1.fill(0.0f);
+    m_state2.fill(0.0f);
+}
+
+void BiquadEqualizer::process(qint16 *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+void BiquadEqualizer::process(float *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+const char *BiquadEqualizer::kernelName() const
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    if (m_simd)
+        return SimdKernel::name();
+#endif
+    return ScalarKernel::name();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+int BiquadEqualizer::laneCount(int channelCount)
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    return channelCount <= PairLanes ? PairLanes : SimdLanes;
+#else
+    Q_UNUSED(channelCount)
+    return 1;
+#endif
+}
+
+template<typename Sample>
+void BiquadEqualizer::processBlocks(Sample *samples, int frameCount)
+{
+    const int lanes = m_lanes;
+
+    while (frameCount > 0) {
+        const int blockFrames = qMin(frameCount, int(BlockFrames));
+
+        updateRamps();
+
+        if (!m_activeBands.isEmpty()) {
+            // Deinterleave into groups of lanes, padding unused lanes
+            for (int g = 0; g < m_groupCount; ++g) {
+                float *block = m_block.data() + g * BlockFrames * lanes;
+                for (int f = 0; f < blockFrames; ++f) {
+                    const Sample *frame = samples + f * m_channelCount;
+                    for (int l = 0; l < lanes; ++l) {
+                        const int channel = g * lanes + l;
+                        *block++ = channel < m_channelCount
+                                 ? toFloat(frame[channel]) : 0.0f;
+                    }
+                }
+            }
+
+#ifdef PHONON_MMF_DSP_SIMD
+            if (PairLanes == lanes)
+                filterBandPairs(blockFrames);
+            else if (m_simd)
+                filterBlock<SimdKernel>(blockFrames);
+            else
+#endif
+                filterBlock<ScalarKernel>(blockFrames);
+
+            for (int g = 0; g < m_groupCount; ++g) {
+                const float *block = m_block.data() + g * BlockFrames * lanes;
+                for (int f = 0; f < blockFrames; ++f) {
+                    Sample *frame = samples + f * m_channelCount;
+                    for (int l = 0; l < lanes; ++l, ++block) {
+                        const int channel = g * lanes + l;
+                        if (channel < m_channelCount)
+                            fromFloat(*block, frame[channel]);
+                    }
+                }
+            }
+
+            updateStates();
+        }
+
+        samples += blockFrames * m_channelCount;
+        frameCount -= blockFrames;
+    }
+}
+
+/**
+ * Advances any ramps in progress by one block, and rebuilds the list of
+ * bands which need to be filtered.
+ */
+void BiquadEqualizer::updateRamps()
+{
+    m_activeBands.clear();
+
+    for (int i = 0; i < m_bands.count(); ++i) {
+        if (m_rampBlocks[i]) {
+            if (--m_rampBlocks[i])
+                m_currentLevels[i] += m_levelSteps[i];
+            else
+                m_currentLevels[i] = m_targetLevels[i];
+            updateCoefficients(i);
+        }
+
+        if (m_alpha[i] > 0.0f
+            && (m_rampBlocks[i] || m_currentLevels[i] != 0.0f || !m_stateClear[i]))
+            m_activeBands.append(i);
+    }
+}
+
+/**
+ * Peaking filter, from Robert Bristow-Johnson's "Cookbook formulae for
+ * audio EQ biquad filter coefficients".
+ */
+void BiquadEqualizer::updateCoefficients(int index)
+{
+    const qreal gain = qPow(10.0, m_currentLevels[index] / 4000.0);
+    const qreal alpha = m_alpha[index];
+    const qreal a0 = 1.0 + alpha / gain;
+
+    Coefficients &c = m_coefficients[index];
+    c.m_b0 = (1.0 + alpha * gain) / a0;
+    c.m_b1 = -2.0 * m_cosOmega[index] / a0;
+    c.m_b2 = (1.0 - alpha * gain) / a0;
+    c.m_a1 = c.m_b1;
+    c.m_a2 = (1.0 - alpha / gain) / a0;
+}
+
+/**
+ * Applies the active bands to m_block, using the transposed direct form II
+ * structure.
+ */
+template<typename Kernel>
+void BiquadEqualizer::filterBlock(int frameCount)
+{
+    typedef typename Kernel::Vector Vector;
+    const int lanes = Kernel::Lanes;
+
+    foreach (int band, m_activeBands) {
+        const Coefficients &c = m_coefficients[band];
+        const Vector b0 = Kernel::set(c.m_b0);
+        const Vector b1 = Kernel::set(c.m_b1);
+        const Vector b2 = Kernel::set(c.m_b2);
+        const Vector a1 = Kernel::set(c.m_a1);
+        const Vector a2 = Kernel::set(c.m_a2);
+
+        for (int g = 0; g < m_groupCount; ++g) {
+            const int offset = (band * m_groupCount + g) * lanes;
+            Vector s1 = Kernel::load(m_state1.data() + offset);
+            Vector s2 = Kernel::load(m_state2.data() + offset);
+
+            float *block = m_block.data() + g * BlockFrames * lanes;
+            for (int f = 0; f < frameCount; ++f, block += lanes) {
+                const Vector x = Kernel::load(block);
+                const Vector y = Kernel::add(Kernel::mul(b0, x), s1);
+                s1 = Kernel::add(Kernel::sub(Kernel::mul(b1, x), Kernel::mul(a1, y)), s2);
+                s2 = Kernel::sub(Kernel::mul(b2, x), Kernel::mul(a2, y));
+                Kernel::store(block, y);
+            }
+
+            Kernel::store(m_state1.data() + offset, s1);
+            Kernel::store(m_state2.data() + offset, s2);
+        }
+    }
+}
+
+#ifdef PHONON_MMF_DSP_SIMD
+/**
+ * Applies the active bands to m_block, which holds a single group of
+ * PairLanes lanes, two bands at a time; see filterSectionPair().  With an
+ * odd number of active bands, the last is paired with a flat section.
+ */
+void BiquadEqualizer::filterBandPairs(int frameCount)
+{
+    typedef SimdKernel::Vector Vector;
+
+    const Coefficients flat = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    float *const state1 = m_state1.data();
+    float *const state2 = m_state2.data();
+
+    for (int i = 0; i < m_activeBands.count(); i += 2) {
+        float *const first1 = state1 + m_activeBands[i] * PairLanes;
+        float *const first2 = state2 + m_activeBands[i] * PairLanes;
+        const Coefficients &first = m_coefficients[m_activeBands[i]];
+
+        if (i + 1 < m_activeBands.count()) {
+            float *const second1 = state1 + m_activeBands[i + 1] * PairLanes;
+            float *const second2 = state2 + m_activeBands[i + 1] * PairLanes;
+            Vector s1 = SimdKernel::joinLowPairs(SimdKernel::loadPair(first1),
+                                                 SimdKernel::loadPair(second1));
+            Vector s2 = SimdKernel::joinLowPairs(SimdKernel::loadPair(first2),
+                                                 SimdKernel::loadPair(second2));
+
+            filterSectionPair(m_block.data(), frameCount, first,
+                              m_coefficients[m_activeBands[i + 1]], s1, s2);
+
+            SimdKernel::storeLowPair(first1, s1);
+            SimdKernel::storeLowPair(first2, s2);
+            SimdKernel::storeHighPair(second1, s1);
+            SimdKernel::storeHighPair(second2, s2);
+        } else {
+            // The state of the flat section remains zero
+            Vector s1 = SimdKernel::loadPair(first1);
+            Vector s2 = SimdKernel::loadPair(first2);
+
+            filterSectionPair(m_block.data(), frameCount, first, flat, s1, s2);
+
+            SimdKernel::storeLowPair(first1, s1);
+            SimdKernel::storeLowPair(first2, s2);
+        }
+    }
+}
+#endif
+
+/**
+ * Flushes tiny state values to zero, and discards the state of flat
+ * bands once it has decayed, so that they can be bypassed.
+ */
+void BiquadEqualizer::updateStates()
+{
+    const int stride = m_groupCount * m_lanes;
+
+    foreach (int band, m_activeBands) {
+        float *state1 = m_state1.data() + band * stride;
+        float *state2 = m_state2.data() + band * stride;
+
+        float peak = 0.0f;
+        for (int i = 0; i < stride; ++i) {
+            if (qAbs(state1[i]) < DenormalThreshold)
+                state1[i] = 0.0f;
+            if (qAbs(state2[i]) < DenormalThreshold)
+                state2[i] = 0.0f;
+            peak = qMax(peak, qMax(qAbs(state1[i]), qAbs(state2[i])));
+        }
+
+        const bool flat = !m_rampBlocks[band] && 0.0f == m_currentLevels[band];
+        m_stateClear[band] = flat && peak < StateThreshold;
+        if (m_stateClear[band]) {
+            for (int i = 0; i < stride; ++i) {
+                state1[i] = 0.0f;
+                state2[i] = 0.0f;
+            }
+        }
+    }
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,170 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_BIQUADEQUALIZER_H
+#define PHONON_MMF_BIQUADEQUALIZER_H
+
+#include <QVector>
+
+#include "audiograph.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short In-process graphic equalizer built from cascaded biquad filters
+ *
+ * The band / level model is the same as that of CAudioEqualizer, which is
+ * used by AudioEqualizer: each band has a center frequency and bandwidth in
+ * Hz, and a level in millibels.  Each band is implemented as a peaking
+ * filter.
+ *
+ * Samples are interleaved 16-bit or floating-point PCM, and are processed
+ * in place.  Where SSE2 or NEON is available, mono and stereo signals are
+ * filtered two bands at a time, and wider signals four channels at a
+ * time; otherwise a scalar implementation is used.
+ *
+ * Level changes do not take effect abruptly: each band's level ramps to
+ * its new value over RampDuration ms, with the filter coefficients being
+ * recomputed at short intervals along the way, so that changes do not
+ * cause clicks.  Bands whose level is zero, and which are not ramping,
+ * are bypassed.
+ *
+ * All memory is allocated on construction; process() does not allocate.
+ */
+class BiquadEqualizer : public AudioProcessor
+{
+public:
+    struct Band
+    {
+        Band(qint32 centerFrequency = 0, qint32 bandwidth = 0);
+
+        qint32  m_centerFrequency;  // Hz
+        qint32  m_bandwidth;        // Hz; if zero, one octave is used
+    };
+
+    BiquadEqualizer(int sampleRate, int channelCount,
+                    const QVector<Band> &bands);
+
+    enum Constants
+    {
+        MaxChannelCount = 8,
+        RampDuration = 20 // ms
+    };
+
+    int sampleRate() const;
+    int channelCount() const;
+    int bandCount() const;
+    Band band(int index) const;
+
+    /**
+     * Sets the level of the band with the specified 0-based index.
+     */
+    void setBandLevel(int index, qint32 millibels);
+    qint32 bandLevel(int index) const;
+
+    /**
+     * Clears the filter history and completes any ramps in progress.
+     * Should be called when the input is discontinuous, for example
+     * after a seek.
+     */
+    void reset();
+
+    /**
+     * Filters frameCount frames of interleaved samples in place.
+     */
+    void process(qint16 *samples, int frameCount);
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
+    /**
+     * Name of the kernel which is used, e.g. "sse2" or "scalar".
+     */
+    const char *kernelName() const;
+
+private:
+    struct Coefficients
+    {
+        float   m_b0;
+        float   m_b1;
+        float   m_b2;
+        float   m_a1;
+        float   m_a2;
+    };
+
+    static int laneCount(int channelCount);
+    template<typename Sample> void processBlocks(Sample *samples, int frameCount);
+    void updateRamps();
+    void updateCoefficients(int index);
+    template<typename Kernel> void filterBlock(int frameCount);
+    void filterBandPairs(int frameCount);
+    void updateStates();
+
+private:
+    const int                   m_sampleRate;
+    const int                   m_channelCount;
+
+    // Number of channels filtered in parallel by the selected kernel, or,
+    // when filtering two bands at a time, the number of lanes per band
+    const bool                  m_simd;
+    const int                   m_lanes;
+
+    // Number of groups of channels which are filtered in parallel
+    const int                   m_groupCount;
+
+    const QVector<Band>         m_bands;
+
+    // Precomputed for each band from its center frequency and bandwidth
+    QVector<float>              m_cosOmega;
+    QVector<float>              m_alpha;
+
+    // Levels in millibels
+    QVector<qint32>             m_targetLevels;
+    QVector<float>              m_currentLevels;
+    QVector<float>              m_levelSteps;
+    QVector<int>                m_rampBlocks;
+    int                         m_rampBlockCount;
+
+    QVector<Coefficients>       m_coefficients;
+
+    // Set for flat bands whose filter state has decayed to zero
+    QVector<bool>               m_stateClear;
+
+    // Bands which are not bypassed, rebuilt before each block
+    QVector<int>                m_activeBands;
+
+    // Filter state, indexed by band, then group, then lane
+    QVector<float>              m_state1;
+    QVector<float>              m_state2;
+
+    // Samples of the block being filtered, indexed by group, then frame,
+    // then lane
+    QVector<float>              m_block;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,248 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <string.h>
+
+#include "contentsniffer.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::ContentSniffer
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// MP4 major brands which only ever contain audio
+static const char *const AudioBrands[] = {
+    "M4A ", "M4B ", "M4P ", "F4A ", "F4B ", 0
+};
+
+// File name suffixes which are used to resolve containers which may hold
+// either audio or video
+static const char *const AudioSuffixes[] = {
+    "aac", "amr", "awb", "m4a", "m4b", "mp3", "oga", "ogg", "opus",
+    "wav", "wma", "mid", "midi", 0
+};
+
+static const char *const VideoSuffixes[] = {
+    "3g2", "3gp", "asf", "avi", "flv", "m4v", "mp4", "ogv", "wmv", 0
+};
+
+// ASF header object, and the audio and video stream type GUIDs which appear
+// in its stream properties objects, in their on-disk byte order
+static const uchar AsfHeaderGuid[] = {
+    0x30, 0x26, 0xB2, 0x75, 0x8E, 0x66, 0xCF, 0x11,
+    0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C
+};
+
+static const uchar AsfAudioMediaGuid[] = {
+    0x40, 0x9E, 0x69, 0xF8, 0x4D, 0x5B, 0xCF, 0x11,
+    0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B
+};
+
+static const uchar AsfVideoMediaGuid[] = {
+    0xC0, 0xEF, 0x19, 0xBC, 0x4D, 0x5B, 0xCF, 0x11,
+    0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B
+};
+
+static const int AsfGuidLength = 16;
+
+// Size of the fixed part of an Ogg page header, which is followed by the
+// segment table
+static const int OggPageHeaderSize = 27;
+
+static const uchar FlvVideoFlag = 0x01;
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+MediaType MMF::ContentSniffer::sniff(const uchar *data, int size, const char *suffix)
+{
+    if (matches(data, size, 0, "ID3", 3))
+        return MediaTypeAudio;
+
+    if (matches(data, size, 4, "ftyp", 4))
+        return sniffMp4(data, size, suffix);
+
+    if (matches(data, size, 0, "RIFF", 4))
+        return sniffRiff(data, size);
+
+    if (matches(data, size, 0, "OggS", 4))
+        return sniffOgg(data, size, suffix);
+
+    if (matches(data, size, 0, reinterpret_cast<const char *>(AsfHeaderGuid), AsfGuidLength))
+        return sniffAsf(data, size, suffix);
+
+    if (matches(data, size, 0, "FLV\x01", 4))
+        return sniffFlv(data, size);
+
+    // Covers both AMR-NB ("#!AMR\n") and AMR-WB ("#!AMR-WB\n")
+    if (matches(data, size, 0, "#!AMR", 5))
+        return MediaTypeAudio;
+
+    if (matches(data, size, 0, "MThd", 4))
+        return MediaTypeAudio;
+
+    // Raw MPEG and ADTS streams have no magic number, only a frame sync
+    // pattern, so they are checked last.
+    if (isAdtsFrame(data, size) || isMpegAudioFrame(data, size))
+        return MediaTypeAudio;
+
+    return MediaTypeUnknown;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+bool MMF::ContentSniffer::matches(const uchar *data, int size, int offset,
+                                  const char *magic, int length)
+{
+    return offset + length <= size
+        && 0 == memcmp(data + offset, magic, length);
+}
+
+bool MMF::ContentSniffer::contains(const uchar *data, int size,
+                                   const uchar *pattern, int length)
+{
+    for (int i = 0; i + length <= size; ++i)
+        if (0 == memcmp(data + i, pattern, length))
+            return true;
+    return false;
+}
+
+bool MMF::ContentSniffer::isMpegAudioFrame(const uchar *data, int size)
+{
+    if (size < 4 || 0xFF != data[0] || 0xE0 != (data[1] & 0xE0))
+        return false;
+
+    const int version = (data[1] >> 3) & 0x3;
+    const int layer = (data[1] >> 1) & 0x3;
+    const int bitrate = data[2] >> 4;
+    const int sampleRate = (data[2] >> 2) & 0x3;
+
+    // Reject the reserved and invalid values, which rules out most
+    // non-audio data which happens to start with a sync pattern
+    return 1 != version && 0 != layer && 0xF != bitrate && 0x3 != sampleRate;
+}
+
+bool MMF::ContentSniffer::isAdtsFrame(const uchar *data, int size)
+{
+    // 12-bit sync word followed by layer 0
+    if (size < 7 || 0xFF != data[0] || 0xF0 != (data[1] & 0xF6))
+        return false;
+
+    const int sampleRate = (data[2] >> 2) & 0xF;
+    return sampleRate < 13;
+}
+
+MediaType MMF::ContentSniffer::sniffMp4(const uchar *data, int size, const char *suffix)
+{
+    for (int i = 0; AudioBrands[i]; ++i)
+        if (matches(data, size, 8, AudioBrands[i], 4))
+            return MediaTypeAudio;
+
+    // Other brands, including the 3GPP and ISO brands, are used for both
+    // audio-only and video clips.  The track handlers are in the moov box,
+    // which is often at the end of the file, so the suffix is used instead.
+    if (MediaTypeAudio == suffixMediaType(suffix))
+        return MediaTypeAudio;
+
+    return MediaTypeVideo;
+}
+
+MediaType MMF::ContentSniffer::sniffRiff(const uchar *data, int size)
+{
+    if (matches(data, size, 8, "WAVE", 4) || matches(data, size, 8, "RMID", 4))
+        return MediaTypeAudio;
+
+    if (matches(data, size, 8, "AVI ", 4))
+        return MediaTypeVideo;
+
+    return MediaTypeUnknown;
+}
+
+MediaType MMF::ContentSniffer::sniffOgg(const uchar *data, int size, const char *suffix)
+{
+    // The first page of an Ogg stream contains only the identification
+    // header of the first logical stream.
+    if (size > OggPageHeaderSize - 1) {
+        const int packet = OggPageHeaderSize + data[OggPageHeaderSize - 1];
+
+        if (matches(data, size, packet, "\x80theora", 7))
+            return MediaTypeVideo;
+
+        if (matches(data, size, packet, "\x01vorbis", 7)
+            || matches(data, size, packet, "OpusHead", 8)
+            || matches(data, size, packet, "Speex   ", 8)
+            || matches(data, size, packet, "\x7f" "FLAC", 5))
+            return MediaTypeAudio;
+    }
+
+    return (MediaTypeVideo == suffixMediaType(suffix))
+        ? MediaTypeVideo : MediaTypeAudio;
+}
+
+MediaType MMF::ContentSniffer::sniffAsf(const uchar *data, int size, const char *suffix)
+{
+    // Stream properties objects usually fall within the first few hundred
+    // bytes of the header object.
+    if (contains(data, size, AsfVideoMediaGuid, AsfGuidLength))
+        return MediaTypeVideo;
+
+    if (contains(data, size, AsfAudioMediaGuid, AsfGuidLength))
+        return MediaTypeAudio;
+
+    return (MediaTypeAudio == suffixMediaType(suffix))
+        ? MediaTypeAudio : MediaTypeVideo;
+}
+
+MediaType MMF::ContentSniffer::sniffFlv(const uchar *data, int size)
+{
+    // The flags byte indicates whether video and / or audio tags are present
+    if (size > 4 && !(data[4] & FlvVideoFlag))
+        return MediaTypeAudio;
+
+    return MediaTypeVideo;
+}
+
+MediaType MMF::ContentSniffer::suffixMediaType(const char *suffix)
+{
+    if (suffix) {
+        for (int i = 0; AudioSuffixes[i]; ++i)
+            if (0 == strcmp(suffix, AudioSuffixes[i]))
+                return MediaTypeAudio;
+
+        for (int i = 0; VideoSuffixes[i]; ++i)
+            if (0 == strcmp(suffix, VideoSuffixes[i]))
+                return MediaTypeVideo;
+    }
+
+    return MediaTypeUnknown;
+}
+
+QT_END_NAMESPACE
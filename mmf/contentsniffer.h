@@ -0,0 +1,82 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_CONTENTSNIFFER_H
+#define PHONON_MMF_CONTENTSNIFFER_H
+
+#include "defs.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Classifies media data as audio or video from its leading bytes
+ *
+ * Recognizes the containers which are commonly played through this
+ * backend from their magic numbers: MP3 (with or without an ID3 tag), ADTS
+ * AAC, MP4 / 3GP / M4A, AMR, WAV / AVI, Ogg, ASF, FLV and MIDI.  Where a
+ * container may hold either audio or video, the header is inspected
+ * further, and the file name suffix is used to break ties.
+ *
+ * Sniffing does not allocate memory, and does not depend on any Symbian
+ * APIs, so that it can be built and exercised on other platforms.  Data
+ * which is not recognized yields MediaTypeUnknown, in which case the
+ * caller falls back to the platform recognizer.
+ */
+class ContentSniffer
+{
+public:
+    /**
+     * Number of leading bytes which sniff() needs in order to make a
+     * reliable decision.  Fewer may be supplied.
+     */
+    enum { HeaderSize = 512 };
+
+    /**
+     * @param data      Leading bytes of the clip
+     * @param size      Number of bytes available
+     * @param suffix    Lower-case file name suffix, without the leading
+     *                  dot, or 0 if not known
+     */
+    static MediaType sniff(const uchar *data, int size, const char *suffix = 0);
+
+private:
+    static bool matches(const uchar *data, int size, int offset,
+                        const char *magic, int length);
+    static bool contains(const uchar *data, int size,
+                         const uchar *pattern, int length);
+    static bool isMpegAudioFrame(const uchar *data, int size);
+    static bool isAdtsFrame(const uchar *data, int size);
+    static MediaType sniffMp4(const uchar *data, int size, const char *suffix);
+    static MediaType sniffRiff(const uchar *data, int size);
+    static MediaType sniffOgg(const uchar *data, int size, const char *suffix);
+    static MediaType sniffAsf(const uchar *data, int size, const char *suffix);
+    static MediaType sniffFlv(const uchar *data, int size);
+    static MediaType suffixMediaType(const char *suffix);
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
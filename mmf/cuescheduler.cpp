@@ -0,0 +1,223 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "cuescheduler.h"
+#include "mediaobject.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::CueScheduler
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Cue points which are due within this time are emitted immediately, rather
+// than re-arming the timer.
+const qint64    CueTolerance = 2; // ms
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::CueScheduler::CueScheduler(MediaObject *parent)
+    :   QObject(parent)
+    ,   m_mediaObject(parent)
+    ,   m_threshold(0)
+    ,   m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer.data(), SIGNAL(timeout()), this, SLOT(timerExpired()));
+}
+
+MMF::CueScheduler::~CueScheduler()
+{
+
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+void MMF::CueScheduler::addCuePoint(int id, qint64 position)
+{
+    CuePoint cue;
+    cue.m_position = position;
+    cue.m_id = id;
+    m_cuePoints.append(cue);
+
+    if (position >= m_threshold) {
+        push(cue);
+        arm();
+    }
+}
+
+void MMF::CueScheduler::removeCuePoint(int id)
+{
+    QVector<CuePoint>::iterator i = m_cuePoints.begin();
+    while (i != m_cuePoints.end()) {
+        if (i->m_id == id)
+            i = m_cuePoints.erase(i);
+        else
+            ++i;
+    }
+
+    rebuild(m_threshold);
+}
+
+void MMF::CueScheduler::clear()
+{
+    m_cuePoints.clear();
+    m_heap.clear();
+    m_threshold = 0;
+    m_timer->stop();
+}
+
+void MMF::CueScheduler::seek(qint64 position)
+{
+    rebuild(position);
+}
+
+
+//-----------------------------------------------------------------------------
+// Public slots
+//-----------------------------------------------------------------------------
+
+void MMF::CueScheduler::stateChanged(Phonon::State newState,
+                                     Phonon::State oldState)
+{
+    Q_UNUSED(oldState)
+
+    if (Phonon::PlayingState == newState)
+        arm();
+    else
+        m_timer->stop();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private slots
+//-----------------------------------------------------------------------------
+
+void MMF::CueScheduler::timerExpired()
+{
+    const qint64 limit = m_mediaObject->currentTime() + CueTolerance;
+
+    // Remove all due cue points from the heap before emitting any signals,
+    // because receivers may add or remove cue points, or seek.
+    QVector<CuePoint> due;
+    while (!m_heap.isEmpty() && m_heap.first().m_position <= limit)
+        due.append(pop());
+    m_threshold = qMax(m_threshold, limit + 1);
+
+    arm();
+
+    foreach (const CuePoint &cue, due)
+        emit cueReached(cue.m_id, cue.m_position);
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::CueScheduler::rebuild(qint64 position)
+{
+    m_threshold = position;
+
+    m_heap.clear();
+    foreach (const CuePoint &cue, m_cuePoints)
+        if (cue.m_position >= position)
+            m_heap.append(cue);
+
+    // Bottom-up heap construction, which is O(n)
+    for (int i = m_heap.count() / 2 - 1; i >= 0; --i)
+        siftDown(i);
+
+    arm();
+}
+
+void MMF::CueScheduler::push(const CuePoint &cue)
+{
+    m_heap.append(cue);
+    siftUp(m_heap.count() - 1);
+}
+
+MMF::CueScheduler::CuePoint MMF::CueScheduler::pop()
+{
+    Q_ASSERT_X(!m_heap.isEmpty(), Q_FUNC_INFO, "Heap is empty");
+    const CuePoint result = m_heap.first();
+    m_heap.first() = m_heap.last();
+    m_heap.resize(m_heap.count() - 1);
+    if (!m_heap.isEmpty())
+        siftDown(0);
+    return result;
+}
+
+void MMF::CueScheduler::siftUp(int index)
+{
+    CuePoint *const heap = m_heap.data();
+    const CuePoint cue = heap[index];
+    while (index > 0) {
+        const int parent = (index - 1) / 2;
+        if (heap[parent].m_position <= cue.m_position)
+            break;
+        heap[index] = heap[parent];
+        index = parent;
+    }
+    heap[index] = cue;
+}
+
+void MMF::CueScheduler::siftDown(int index)
+{
+    CuePoint *const heap = m_heap.data();
+    const int count = m_heap.count();
+    const CuePoint cue = heap[index];
+    for (;;) {
+        int child = 2 * index + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && heap[child + 1].m_position < heap[child].m_position)
+            ++child;
+        if (cue.m_position <= heap[child].m_position)
+            break;
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = cue;
+}
+
+void MMF::CueScheduler::arm()
+{
+    m_timer->stop();
+
+    if (!m_heap.isEmpty() && Phonon::PlayingState == m_mediaObject->state()) {
+        const qint64 delay = m_heap.first().m_position - m_mediaObject->currentTime();
+        m_timer->start(qMax(qint64(0), delay));
+    }
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,113 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_CUESCHEDULER_H
+#define PHONON_MMF_CUESCHEDULER_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QTimer>
+#include <QVector>
+
+#include <phonon/phononnamespace.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+class MediaObject;
+
+/**
+ * @short Emits time-based callbacks at cue points within the current clip
+ *
+ * Pending cue points are held in a binary min-heap keyed on media
+ * position, and a single deadline timer is armed for the cue at the top
+ * of the heap.  No work is done on position ticks.  When the position
+ * jumps, the heap is rebuilt in linear time from the full set of cue
+ * points.
+ */
+class CueScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CueScheduler(MediaObject *parent);
+    ~CueScheduler();
+
+    void addCuePoint(int id, qint64 position);
+
+    /**
+     * Removes all cue points with the specified ID.
+     */
+    void removeCuePoint(int id);
+
+    void clear();
+
+    /**
+     * Must be called when the playback position jumps.  Cue points at or
+     * after @p position become pending.
+     */
+    void seek(qint64 position);
+
+public Q_SLOTS:
+    void stateChanged(Phonon::State newState,
+                      Phonon::State oldState);
+
+Q_SIGNALS:
+    void cueReached(int id, qint64 position);
+
+private Q_SLOTS:
+    void timerExpired();
+
+private:
+    struct CuePoint
+    {
+        qint64  m_position;
+        int     m_id;
+    };
+
+    void rebuild(qint64 position);
+    void push(const CuePoint &cue);
+    CuePoint pop();
+    void siftUp(int index);
+    void siftDown(int index);
+    void arm();
+
+private:
+    MediaObject *const          m_mediaObject;
+
+    // All cue points, in insertion order
+    QVector<CuePoint>           m_cuePoints;
+
+    // Cue points which have not yet been reached, as a min-heap
+    QVector<CuePoint>           m_heap;
+
+    // Cue points before this position have been emitted or skipped
+    qint64                      m_threshold;
+
+    QScopedPointer<QTimer>      m_timer;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,241 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_DSPKERNEL_H
+#define PHONON_MMF_DSPKERNEL_H
+
+#include <QtGlobal>
+
+#if defined(PHONON_MMF_DSP_NO_SIMD)
+    // Only the scalar kernel is used
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define PHONON_MMF_DSP_SSE2
+#   define PHONON_MMF_DSP_SIMD
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#   include <arm_neon.h>
+#   define PHONON_MMF_DSP_NEON
+#   define PHONON_MMF_DSP_SIMD
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Vector operations used by the in-process DSP engines
+ *
+ * Each kernel provides the same set of operations on a vector of Lanes
+ * floats, so that the engines' inner loops can be written once, as
+ * templates, and instantiated for whichever kernels are available.
+ * SimdKernel is only defined if PHONON_MMF_DSP_SIMD is defined, i.e. if
+ * SSE2 or NEON is available at compile time, and PHONON_MMF_DSP_NO_SIMD
+ * is not defined; ScalarKernel is always available.
+ *
+ * SimdKernel additionally provides operations on pairs of lanes, i.e. on
+ * interleaved stereo frames: swapPairs() exchanges adjacent lanes, and the
+ * remaining pair operations treat the vector as a low pair (lanes 0 and 1)
+ * and a high pair (lanes 2 and 3).
+ */
+
+#if defined(PHONON_MMF_DSP_SSE2)
+
+struct SimdKernel
+{
+    enum { Lanes = 4 };
+    typedef __m128 Vector;
+
+    static const char *name()                   { return "sse2"; }
+    static Vector load(const float *p)          { return _mm_loadu_ps(p); }
+    static void store(float *p, Vector v)       { _mm_storeu_ps(p, v); }
+    static Vector set(float x)                  { return _mm_set1_ps(x); }
+    static Vector add(Vector a, Vector b)       { return _mm_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b)       { return _mm_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b)       { return _mm_mul_ps(a, b); }
+    static Vector swapPairs(Vector v)           { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+    // Loads the low pair, and clears the high pair
+    static Vector loadPair(const float *p)          { return _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64 *>(p)); }
+    static void storeLowPair(float *p, Vector v)    { _mm_storel_pi(reinterpret_cast<__m64 *>(p), v); }
+    static void storeHighPair(float *p, Vector v)   { _mm_storeh_pi(reinterpret_cast<__m64 *>(p), v); }
+    static Vector setPairs(float low, float high)   { return _mm_setr_ps(low, low, high, high); }
+
+    // Returns the low pair of a followed by the low pair of b
+    static Vector joinLowPairs(Vector a, Vector b)  { return _mm_movelh_ps(a, b); }
+
+    // Returns the low pair of a followed by the high pair of b
+    static Vector joinPairs(Vector a, Vector b)     { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 1, 0)); }
+
+    static float sum(Vector v)
+    {
+        const __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+#elif defined(PHONON_MMF_DSP_NEON)
+
+struct SimdKernel
+{
+    enum { Lanes = 4 };
+    typedef float32x4_t Vector;
+
+    static const char *name()                   { return "neon"; }
+    static Vector load(const float *p)          { return vld1q_f32(p); }
+    static void store(float *p, Vector v)       { vst1q_f32(p, v); }
+    static Vector set(float x)                  { return vdupq_n_f32(x); }
+    static Vector add(Vector a, Vector b)       { return vaddq_f32(a, b); }
+    static Vector sub(Vector a, Vector b)       { return vsubq_f32(a, b); }
+    static Vector mul(Vector a, Vector b)       { return vmulq_f32(a, b); }
+    static Vector swapPairs(Vector v)           { return vrev64q_f32(v); }
+
+    // Loads the low pair, and clears the high pair
+    static Vector loadPair(const float *p)          { return vcombine_f32(vld1_f32(p), vdup_n_f32(0.0f)); }
+    static void storeLowPair(float *p, Vector v)    { vst1_f32(p, vget_low_f32(v)); }
+    static void storeHighPair(float *p, Vector v)   { vst1_f32(p, vget_high_f32(v)); }
+    static Vector setPairs(float low, float high)   { return vcombine_f32(vdup_n_f32(low), vdup_n_f32(high)); }
+
+    // Returns the low pair of a followed by the low pair of b
+    static Vector joinLowPairs(Vector a, Vector b)  { return vcombine_f32(vget_low_f32(a), vget_low_f32(b)); }
+
+    // Returns the low pair of a followed by the high pair of b
+    static Vector joinPairs(Vector a, Vector b)     { return vcombine_f32(vget_low_f32(a), vget_high_f32(b)); }
+
+    static float sum(Vector v)
+    {
+        const float32x2_t pairs = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+    }
+};
+
+#endif
+
+struct ScalarKernel
+{
+    enum { Lanes = 1 };
+    typedef float Vector;
+
+    static const char *name()                   { return "scalar"; }
+    static Vector load(const float *p)          { return *p; }
+    static void store(float *p, Vector v)       { *p = v; }
+    static Vector set(float x)                  { return x; }
+    static Vector add(Vector a, Vector b)       { return a + b; }
+    static Vector sub(Vector a, Vector b)       { return a - b; }
+    static Vector mul(Vector a, Vector b)       { return a * b; }
+    static float sum(Vector v)                  { return v; }
+};
+
+#ifdef PHONON_MMF_DSP_SIMD
+
+/**
+ * Applies two cascaded biquad sections, in transposed direct form II, to
+ * frameCount interleaved stereo frames in place.  Coefficients may be of
+ * any type with members m_b0, m_b1, m_b2, m_a1 and m_a2.
+ *
+ * The first section runs in the low pair of lanes, and the second in the
+ * high pair; s1 and s2 hold the state of both, in the same layout.  Since
+ * the input of the second section is the output of the first, the second
+ * runs one frame behind: each step filters frame f through the first
+ * section and frame f - 1 through the second.  The first and last steps
+ * therefore advance only one of the sections.
+ *
+ * This lets mono and stereo signals, which would leave most lanes idle if
+ * filtered a frame at a time, make full use of the vector.
+ */
+template<typename Coefficients>
+inline void filterSectionPair(float *frames, int frameCount,
+                              const Coefficients &first,
+                              const Coefficients &second,
+                              SimdKernel::Vector &s1, SimdKernel::Vector &s2)
+{
+    typedef SimdKernel K;
+    typedef K::Vector Vector;
+
+    const Vector b0 = K::setPairs(first.m_b0, second.m_b0);
+    const Vector b1 = K::setPairs(first.m_b1, second.m_b1);
+    const Vector b2 = K::setPairs(first.m_b2, second.m_b2);
+    const Vector a1 = K::setPairs(first.m_a1, second.m_a1);
+    const Vector a2 = K::setPairs(first.m_a2, second.m_a2);
+
+    // First frame, through the first section only
+    Vector x = K::loadPair(frames);
+    Vector y = K::add(K::mul(b0, x), s1);
+    Vector t1 = K::add(K::sub(K::mul(b1, x), K::mul(a1, y)), s2);
+    Vector t2 = K::sub(K::mul(b2, x), K::mul(a2, y));
+    s1 = K::joinPairs(t1, s1);
+    s2 = K::joinPairs(t2, s2);
+
+    for (int f = 1; f < frameCount; ++f) {
+        x = K::joinLowPairs(K::loadPair(frames + 2 * f), y);
+        y = K::add(K::mul(b0, x), s1);
+        s1 = K::add(K::sub(K::mul(b1, x), K::mul(a1, y)), s2);
+        s2 = K::sub(K::mul(b2, x), K::mul(a2, y));
+        K::storeHighPair(frames + 2 * (f - 1), y);
+    }
+
+    // Last frame, through the second section only
+    x = K::joinLowPairs(K::set(0.0f), y);
+    y = K::add(K::mul(b0, x), s1);
+    t1 = K::add(K::sub(K::mul(b1, x), K::mul(a1, y)), s2);
+    t2 = K::sub(K::mul(b2, x), K::mul(a2, y));
+    K::storeHighPair(frames + 2 * (frameCount - 1), y);
+    s1 = K::joinPairs(s1, t1);
+    s2 = K::joinPairs(s2, t2);
+}
+
+#endif
+
+/**
+ * Conversions between PCM samples and floating-point values in the range
+ * -1.0 to +1.0.
+ */
+inline float toFloat(qint16 sample)
+{
+    return sample * (1.0f / 32768.0f);
+}
+
+inline float toFloat(float sample)
+{
+    return sample;
+}
+
+inline void fromFloat(float value, qint16 &sample)
+{
+    const float scaled = value * 32768.0f;
+    if (scaled >= 32767.0f)
+        sample = 32767;
+    else if (scaled <= -32768.0f)
+        sample = -32768;
+    else
+        sample = qint16(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+inline void fromFloat(float value, float &sample)
+{
+    sample = value;
+}
+
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,73 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QSet>
+
+#include "effectdescriptor.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::EffectDescriptor
+  \internal
+*/
+
+MMF::EffectDescriptor::EffectDescriptor(const QList<EffectParameter> &parameters)
+    :   m_parameters(parameters.toVector())
+{
+    // Parameter IDs are small, non-negative integers (see
+    // AbstractAudioEffect::CommonParameters), so a flat table is used.
+    int maxId = -1;
+    foreach (const EffectParameter &param, m_parameters) {
+        Q_ASSERT_X(param.id() >= 0 && param.id() <= MaxParameterId,
+                   Q_FUNC_INFO, "Invalid parameter ID");
+        maxId = qMax(maxId, param.id());
+    }
+
+    m_indexes.fill(-1, maxId + 1);
+    for (int i = 0; i < m_parameters.count(); ++i) {
+        const int id = m_parameters[i].id();
+        if (id >= 0) {
+            Q_ASSERT_X(-1 == m_indexes[id], Q_FUNC_INFO,
+                "Parameter list contains duplicates");
+            m_indexes[id] = i;
+        }
+    }
+}
+
+bool MMF::EffectDescriptor::isValid(const QList<EffectParameter> &parameters)
+{
+    QSet<int> ids;
+    foreach (const EffectParameter &param, parameters) {
+        if (param.id() < 0 || param.id() > MaxParameterId
+            || ids.contains(param.id()))
+            return false;
+        ids.insert(param.id());
+    }
+    return true;
+}
+
+QList<EffectParameter> MMF::EffectDescriptor::parameters() const
+{
+    return m_parameters.toList();
+}
+
+QT_END_NAMESPACE
+
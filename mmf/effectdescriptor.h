@@ -0,0 +1,106 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_EFFECTDESCRIPTOR_H
+#define PHONON_MMF_EFFECTDESCRIPTOR_H
+
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "effectparameter.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Immutable table of the parameters of one type of effect
+ *
+ * Each parameter has an index, which is its position in the table.  Effect
+ * nodes store their current parameter values in flat arrays, indexed in
+ * the same way, and indexOf() maps parameter IDs to indices in constant
+ * time.
+ *
+ * A single descriptor is created by the EffectFactory for each type of
+ * effect, and is shared by all effect nodes of that type.
+ */
+class EffectDescriptor
+{
+public:
+    explicit EffectDescriptor(const QList<EffectParameter> &parameters);
+
+    /**
+     * Returns true if the parameter IDs are unique, and lie in the range
+     * [0, MaxParameterId], as required by the constructor.
+     */
+    static bool isValid(const QList<EffectParameter> &parameters);
+
+    enum Constants
+    {
+        // Bounds the size of the table which maps IDs to indices.  This
+        // allows for the common parameters (see
+        // AbstractAudioEffect::CommonParameters) and far more parameters
+        // than any native effect reports.
+        MaxParameterId = 255
+    };
+
+    int count() const;
+    const EffectParameter &parameter(int index) const;
+    QList<EffectParameter> parameters() const;
+
+    /**
+     * Returns the index of the parameter with the specified ID, or -1 if
+     * there is no such parameter.
+     */
+    int indexOf(int id) const;
+
+private:
+    QVector<EffectParameter>    m_parameters;
+
+    // Maps parameter ID to index
+    QVector<int>                m_indexes;
+
+};
+
+typedef QSharedPointer<const EffectDescriptor> EffectDescriptorPointer;
+
+inline int EffectDescriptor::count() const
+{
+    return m_parameters.count();
+}
+
+inline const EffectParameter &EffectDescriptor::parameter(int index) const
+{
+    return m_parameters.at(index);
+}
+
+inline int EffectDescriptor::indexOf(int id) const
+{
+    return (id >= 0 && id < m_indexes.count()) ? m_indexes.at(id) : -1;
+}
+
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,100 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "effectenvelope.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::EffectEnvelope
+  \internal
+*/
+
+MMF::EffectEnvelope::EffectEnvelope()
+{
+
+}
+
+void MMF::EffectEnvelope::addPoint(qint64 position, qreal value)
+{
+    Point point;
+    point.m_position = position;
+    point.m_value = value;
+
+    QVector<Point>::iterator i = m_points.begin();
+    while (i != m_points.end() && lessThan(*i, position))
+        ++i;
+
+    if (i != m_points.end() && i->m_position == position)
+        *i = point;
+    else
+        m_points.insert(i, point);
+}
+
+void MMF::EffectEnvelope::clear()
+{
+    m_points.clear();
+}
+
+bool MMF::EffectEnvelope::isEmpty() const
+{
+    return m_points.isEmpty();
+}
+
+qint64 MMF::EffectEnvelope::endPosition() const
+{
+    Q_ASSERT_X(!m_points.isEmpty(), Q_FUNC_INFO, "Envelope is empty");
+    return m_points.last().m_position;
+}
+
+qreal MMF::EffectEnvelope::valueAt(qint64 position) const
+{
+    Q_ASSERT_X(!m_points.isEmpty(), Q_FUNC_INFO, "Envelope is empty");
+
+    // Binary search for the first breakpoint at or after position
+    int low = 0;
+    int high = m_points.count();
+    while (low < high) {
+        const int mid = (low + high) / 2;
+        if (lessThan(m_points[mid], position))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == 0)
+        return m_points.first().m_value;
+    if (low == m_points.count())
+        return m_points.last().m_value;
+
+    const Point &before = m_points[low - 1];
+    const Point &after = m_points[low];
+    const qreal fraction = qreal(position - before.m_position)
+                         / (after.m_position - before.m_position);
+    return before.m_value + fraction * (after.m_value - before.m_value);
+}
+
+bool MMF::EffectEnvelope::lessThan(const Point &point, qint64 position)
+{
+    return point.m_position < position;
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,84 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_EFFECTENVELOPE_H
+#define PHONON_MMF_EFFECTENVELOPE_H
+
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Breakpoint envelope which automates an effect parameter
+ *
+ * An envelope is a list of (position, value) breakpoints, where positions
+ * are in ms of media time, and values are in the same units as the
+ * parameter (i.e. the external range reported by EffectParameter).
+ * Between breakpoints, the value is interpolated linearly; before the
+ * first breakpoint and after the last, it is held constant.
+ *
+ * Evaluation does not depend on previous evaluations, so the value after
+ * a seek is simply the value at the new position.
+ */
+class EffectEnvelope
+{
+public:
+    EffectEnvelope();
+
+    /**
+     * Adds a breakpoint.  A breakpoint at the same position as an
+     * existing one replaces it.
+     */
+    void addPoint(qint64 position, qreal value);
+
+    void clear();
+    bool isEmpty() const;
+
+    /**
+     * Position of the last breakpoint, after which the value no longer
+     * changes.  The envelope must not be empty.
+     */
+    qint64 endPosition() const;
+
+    qreal valueAt(qint64 position) const;
+
+private:
+    struct Point
+    {
+        qint64  m_position;
+        qreal   m_value;
+    };
+
+    static bool lessThan(const Point &point, qint64 position);
+
+private:
+    // Sorted by position
+    QVector<Point>  m_points;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
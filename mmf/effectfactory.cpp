@@ -18,6 +18,10 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QLocale>
+#include <QStringList>
 
 #include <mdaaudiooutputstream.h>
 
@@ -28,6 +32,7 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "stereowidening.h"
 
 #include "effectfactory.h"
+#include "utils.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -38,6 +43,14 @@ using namespace Phonon::MMF;
   \internal
 */
 
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+const quint32   CacheFileMagic = 0x50454331; // "PEC1"
+const quint32   CacheFileVersion = 2;
+
+
 EffectFactory::EffectFactory(QObject *parent)
     :   QObject(parent)
     ,   m_initialized(false)
@@ -63,26 +76,26 @@ AbstractAudioEffect *EffectFactory::createAudioEffect(Type type,
 
     Q_ASSERT(parent);
 
-    const QList<EffectParameter>& parameters = data(type).m_parameters;
+    const EffectDescriptorPointer &descriptor = data(type).m_descriptor;
 
     AbstractAudioEffect *effect = 0;
 
     switch (type)
     {
     case TypeBassBoost:
-        effect = new BassBoost(parent, parameters);
+        effect = new BassBoost(parent, descriptor);
         break;
     case TypeAudioEqualizer:
-        effect = new AudioEqualizer(parent, parameters);
+        effect = new AudioEqualizer(parent, descriptor);
         break;
     case TypeEnvironmentalReverb:
-        effect = new EnvironmentalReverb(parent, parameters);
+        effect = new EnvironmentalReverb(parent, descriptor);
         break;
     case TypeLoudness:
-        effect = new Loudness(parent, parameters);
+        effect = new Loudness(parent, descriptor);
         break;
     case TypeStereoWidening:
-        effect = new StereoWidening(parent, parameters);
+        effect = new StereoWidening(parent, descriptor);
         break;
 
     // Not implemented
@@ -94,6 +107,11 @@ AbstractAudioEffect *EffectFactory::createAudioEffect(Type type,
         Q_ASSERT_X(false, Q_FUNC_INFO, "Unknown effect");
     }
 
+    if (effect) {
+        effect->m_factory = this;
+        effect->m_type = type;
+    }
+
     return effect;
 }
 
@@ -122,29 +140,51 @@ QList<int> EffectFactory::effectIndexes()
     return result;
 }
 
-//-----------------------------------------------------------------------------
-// Private functions
-//-----------------------------------------------------------------------------
+bool EffectFactory::addPreset(Type type, const QString &name,
+                              const QMap<int, qint32> &values)
+{
+    // Lazily initialize
+    if (!m_initialized)
+        initialize();
 
-#define INITIALIZE_EFFECT(Effect) \
-    { \
-    EffectData data = getData<Effect>(); \
-    m_effectData.insert(Type##Effect, data); \
-    }
+    QHash<Type, EffectData>::const_iterator i = m_effectData.find(type);
+    if (i == m_effectData.end() || !i.value().m_supported)
+        return false;
 
-void EffectFactory::initialize()
+    return m_presets.add(type, i.value().m_descriptor, name, values);
+}
+
+bool EffectFactory::loadPresets(const QString &fileName)
 {
-    Q_ASSERT_X(!m_initialized, Q_FUNC_INFO, "Already initialized");
+    // Lazily initialize
+    if (!m_initialized)
+        initialize();
 
-    INITIALIZE_EFFECT(AudioEqualizer)
-    INITIALIZE_EFFECT(BassBoost)
-    INITIALIZE_EFFECT(EnvironmentalReverb)
-    INITIALIZE_EFFECT(Loudness)
-    INITIALIZE_EFFECT(StereoWidening)
+    return loadPresetFile(fileName);
+}
 
-    m_initialized = true;
+QStringList EffectFactory::presetNames(Type type)
+{
+    // Lazily initialize
+    if (!m_initialized)
+        initialize();
+
+    return m_presets.names(type);
 }
 
+const EffectPreset *EffectFactory::preset(Type type, const QString &name)
+{
+    // Lazily initialize
+    if (!m_initialized)
+        initialize();
+
+    return m_presets.preset(type, name);
+}
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
 // This class is just a wrapper which allows us to instantiate a
 // CMdaAudioOutputStream object.  This is done in order to allow the
 // effects API to query the DevSound implementation, to discover
@@ -166,25 +206,51 @@ private:
     void MaoscPlayComplete(TInt /*aError*/) { }
 };
 
+#define INITIALIZE_EFFECT(Effect) \
+    { \
+    EffectData data = getData<Effect>(stream.data()); \
+    m_effectData.insert(Type##Effect, data); \
+    }
+
+void EffectFactory::initialize()
+{
+    Q_ASSERT_X(!m_initialized, Q_FUNC_INFO, "Already initialized");
+
+    if (!load()) {
+        // All effects are queried using a single CMdaAudioOutputStream
+        // object.
+        OutputStreamFactory streamFactory;
+        QScopedPointer<CMdaAudioOutputStream> stream(streamFactory.create());
+
+        INITIALIZE_EFFECT(AudioEqualizer)
+        INITIALIZE_EFFECT(BassBoost)
+        INITIALIZE_EFFECT(EnvironmentalReverb)
+        INITIALIZE_EFFECT(Loudness)
+        INITIALIZE_EFFECT(StereoWidening)
+
+        save();
+    }
+
+    m_initialized = true;
+
+    // The default bank is optional
+    loadPresetFile(presetFileName());
+}
+
 template<typename BackendNode>
-EffectFactory::EffectData EffectFactory::getData()
+EffectFactory::EffectData EffectFactory::getData(CMdaAudioOutputStream *stream)
 {
     EffectData data;
-
-    // Create a temporary CMdaAudioOutputStream object, so that the effects
-    // API can query DevSound to discover which effects are supported.
-    OutputStreamFactory streamFactory;
-    QScopedPointer<CMdaAudioOutputStream> stream(streamFactory.create());
+    QList<EffectParameter> parameters;
 
     EffectParameter param(
          /* parameterId */        AbstractAudioEffect::ParameterEnable,
          /* name */               tr("Enabled"),
          /* hints */              EffectParameter::ToggledHint,
          /* defaultValue */       QVariant(bool(true)));
-    data.m_parameters.append(param);
+    parameters.append(param);
 
-    data.m_supported = BackendNode::getParameters(stream.data(),
-                                                  data.m_parameters);
+    data.m_supported = BackendNode::getParameters(stream, parameters);
     if (data.m_supported) {
         const QString description = QCoreApplication::translate
             ("Phonon::MMF::EffectFactory", BackendNode::description());
@@ -193,13 +259,8 @@ EffectFactory::EffectData EffectFactory::getData()
         data.m_descriptions.insert("available", true);
     }
 
-    // Sanity check to ensure that all parameter IDs are unique
-    QSet<int> ids;
-    foreach (param, data.m_parameters) {
-        Q_ASSERT_X(ids.find(param.id()) == ids.end(), Q_FUNC_INFO,
-            "Parameter list contains duplicates");
-        ids.insert(param.id());
-    }
+    // The descriptor checks that all parameter IDs are unique
+    data.m_descriptor = EffectDescriptorPointer(new EffectDescriptor(parameters));
 
     return data;
 }
@@ -211,5 +272,121 @@ const EffectFactory::EffectData& EffectFactory::data(Type type) const
     return i.value();
 }
 
+/**
+ * Loads the effect data saved by a previous run.  Returns false if there
+ * is no saved data, if it is corrupt, or if it was saved by a different
+ * version of this code, on a different platform version, or in a
+ * different locale (the descriptions and parameter names are translated).
+ */
+bool EffectFactory::load()
+{
+    TRACE_CONTEXT(EffectFactory::load, EAudioInternal);
+
+    QFile file(fileName());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString platform;
+    stream >> magic >> version >> platform;
+    if (CacheFileMagic != magic || CacheFileVersion != version
+        || platformId() != platform)
+        return false;
+
+    QHash<Type, EffectData> effectData;
+    qint32 count = 0;
+    stream >> count;
+    for (qint32 i = 0; i < count && QDataStream::Ok == stream.status(); ++i) {
+        qint32 type = 0;
+        EffectData data;
+        QList<EffectParameter> parameters;
+        stream >> type >> data.m_supported >> data.m_descriptions
+               >> parameters;
+        if (type < TypeAudioEqualizer || type > TypeStereoWidening
+            || !EffectDescriptor::isValid(parameters))
+            return false;
+        data.m_descriptor = EffectDescriptorPointer(new EffectDescriptor(parameters));
+        effectData.insert(Type(type), data);
+    }
+
+    if (QDataStream::Ok != stream.status())
+        return false;
+
+    static const Type implementedTypes[] = {
+        TypeAudioEqualizer, TypeBassBoost, TypeEnvironmentalReverb,
+        TypeLoudness, TypeStereoWidening
+    };
+    for (unsigned i = 0; i < sizeof(implementedTypes) / sizeof(Type); ++i)
+        if (!effectData.contains(implementedTypes[i]))
+            return false;
+
+    m_effectData = effectData;
+    TRACE("loaded %d effects", m_effectData.count());
+    return true;
+}
+
+void EffectFactory::save() const
+{
+    TRACE_CONTEXT(EffectFactory::save, EAudioInternal);
+
+    QFile file(fileName());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_4_6);
+        stream << CacheFileMagic << CacheFileVersion << platformId();
+
+        stream << qint32(m_effectData.count());
+        QHash<Type, EffectData>::const_iterator i = m_effectData.begin();
+        for ( ; i != m_effectData.end(); ++i)
+            stream << qint32(i.key()) << i.value().m_supported
+                   << i.value().m_descriptions
+                   << i.value().m_descriptor->parameters();
+
+        TRACE("saved %d effects", m_effectData.count());
+    }
+}
+
+QString EffectFactory::fileName()
+{
+    // On Symbian, this is the application's private directory
+    return QCoreApplication::applicationDirPath()
+        + QLatin1String("/phonon_mmf_effects.cache");
+}
+
+QString EffectFactory::presetFileName()
+{
+    return QCoreApplication::applicationDirPath()
+        + QLatin1String("/phonon_mmf_effects.presets");
+}
+
+/**
+ * Adds the presets in fileName for the supported effects.  The factory
+ * must already be initialized.
+ */
+bool EffectFactory::loadPresetFile(const QString &fileName)
+{
+    TRACE_CONTEXT(EffectFactory::loadPresetFile, EAudioInternal);
+
+    QHash<int, EffectDescriptorPointer> descriptors;
+    QHash<Type, EffectData>::const_iterator i = m_effectData.begin();
+    for ( ; i != m_effectData.end(); ++i)
+        if (i.value().m_supported)
+            descriptors.insert(i.key(), i.value().m_descriptor);
+
+    const bool loaded = m_presets.load(fileName, descriptors);
+    TRACE("presets loaded %d", loaded);
+    return loaded;
+}
+
+QString EffectFactory::platformId()
+{
+    return QString::fromLatin1("%1|%2")
+        .arg(QSysInfo::s60Version()).arg(QLocale::system().name());
+}
+
 QT_END_NAMESPACE
 
@@ -19,8 +19,11 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PHONON_MMF_EFFECTFACTORY_H
 #define PHONON_MMF_EFFECTFACTORY_H
 
-#include "abstractaudioeffect.h"
+#include "effectdescriptor.h"
 #include "effectparameter.h"
+#include "effectpresetbank.h"
+
+class CMdaAudioOutputStream;
 
 QT_BEGIN_NAMESPACE
 
@@ -28,9 +31,20 @@ namespace Phonon
 {
 namespace MMF
 {
+class AbstractAudioEffect;
 
 /**
  * @short Contains utility functions related to effects.
+ *
+ * The supported effects, and their parameters, are discovered by querying
+ * the platform the first time they are needed.  The results are saved to
+ * a file in the application's private directory, so that subsequent runs
+ * of the application do not need to query the platform again.
+ *
+ * The factory also holds a bank of presets for each type of effect.
+ * Presets are validated against the probed parameter ranges when they are
+ * added, so that they can later be applied to an effect without any
+ * further checking or conversion.
  */
 class EffectFactory : public QObject
 {
@@ -73,6 +87,32 @@ public:
      */
     QList<int> effectIndexes();
 
+    /**
+     * Adds a preset for effects of @p type, replacing any existing preset
+     * with the same name.  @p values are in internal units, keyed on
+     * parameter ID.  Parameters which are not specified take their default
+     * values.  Returns false if any ID is unknown, or any value lies
+     * outside the range supported by the platform.
+     */
+    bool addPreset(Type type, const QString &name,
+                   const QMap<int, qint32> &values);
+
+    /**
+     * Adds the presets stored in @p fileName.  Presets which are not valid
+     * on this platform are skipped.  Returns false if the file cannot be
+     * read.  The presets in phonon_mmf_effects.presets, in the same
+     * directory as the effect cache, are loaded on initialization.
+     */
+    bool loadPresets(const QString &fileName);
+
+    QStringList presetNames(Type type);
+
+    /**
+     * Returns the preset with the specified name, or null if there is no
+     * such preset.  The pointer is invalidated if presets are added.
+     */
+    const EffectPreset *preset(Type type, const QString &name);
+
 private:
     void initialize();
 
@@ -80,15 +120,23 @@ private:
     {
         bool                            m_supported;
         QHash<QByteArray, QVariant>     m_descriptions;
-        QList<EffectParameter>          m_parameters;
+        EffectDescriptorPointer         m_descriptor;
     };
 
-    template<typename BackendNode> EffectData getData();
+    template<typename BackendNode> EffectData getData(CMdaAudioOutputStream *stream);
     const EffectData& data(Type type) const;
 
+    bool load();
+    void save() const;
+    static QString fileName();
+    static QString presetFileName();
+    bool loadPresetFile(const QString &fileName);
+    static QString platformId();
+
 private:
     bool                                m_initialized;
     QHash<Type, EffectData>             m_effectData;
+    EffectPresetBank                    m_presets;
 
 };
 
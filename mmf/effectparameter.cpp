@@ -16,6 +16,8 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
+#include <QDataStream>
+
 #include "effectparameter.h"
 
 QT_BEGIN_NAMESPACE
@@ -28,7 +30,9 @@ using namespace Phonon::MMF;
 */
 
 MMF::EffectParameter::EffectParameter()
-    :   m_hasInternalRange(false)
+    :   m_hints(0)
+    ,   m_hasInternalRange(false)
+    ,   m_frequency(0)
 {
 
 }
@@ -40,7 +44,9 @@ MMF::EffectParameter::EffectParameter(
             const QString &description)
     :   Phonon::EffectParameter(parameterId, name, hints, defaultValue,
             min, max, values, description)
+    ,   m_hints(hints)
     ,   m_hasInternalRange(false)
+    ,   m_frequency(0)
 {
 
 }
@@ -52,6 +58,21 @@ void MMF::EffectParameter::setInternalRange(qint32 min, qint32 max)
     m_hasInternalRange = true;
 }
 
+bool MMF::EffectParameter::hasInternalRange() const
+{
+    return m_hasInternalRange;
+}
+
+qint32 MMF::EffectParameter::internalMinimum() const
+{
+    return m_internalRange.first;
+}
+
+qint32 MMF::EffectParameter::internalMaximum() const
+{
+    return m_internalRange.second;
+}
+
 qint32 MMF::EffectParameter::toInternalValue(qreal external) const
 {
     Q_ASSERT_X(m_hasInternalRange, Q_FUNC_INFO, "Does not have internal range");
@@ -64,7 +85,56 @@ qreal MMF::EffectParameter::toExternalValue
 {
     Q_ASSERT_X(max >= min, Q_FUNC_INFO, "Invalid range");
     const qint32 range = max - min;
-    return range == 0 ? 0.0 : ((2.0 * value - min) / range) - 1.0;
+    return range == 0 ? 0.0 : ((2.0 * (value - min)) / range) - 1.0;
+}
+
+void MMF::EffectParameter::setFrequency(qint32 hz)
+{
+    m_frequency = hz;
+}
+
+qint32 MMF::EffectParameter::frequency() const
+{
+    return m_frequency;
+}
+
+QDataStream &MMF::operator<<(QDataStream &stream, const EffectParameter &param)
+{
+    stream << qint32(param.id()) << param.name() << qint32(param.m_hints)
+           << param.defaultValue() << param.minimumValue()
+           << param.maximumValue() << param.possibleValues()
+           << param.description() << param.m_hasInternalRange
+           << param.m_internalRange.first << param.m_internalRange.second
+           << param.m_frequency;
+    return stream;
+}
+
+QDataStream &MMF::operator>>(QDataStream &stream, EffectParameter &param)
+{
+    qint32 id = 0;
+    QString name;
+    qint32 hints = 0;
+    QVariant defaultValue;
+    QVariant min;
+    QVariant max;
+    QVariantList values;
+    QString description;
+    bool hasInternalRange = false;
+    qint32 internalMin = 0;
+    qint32 internalMax = 0;
+    qint32 frequency = 0;
+
+    stream >> id >> name >> hints >> defaultValue >> min >> max >> values
+           >> description >> hasInternalRange >> internalMin >> internalMax
+           >> frequency;
+
+    param = EffectParameter(id, name, EffectParameter::Hints(hints),
+                            defaultValue, min, max, values, description);
+    if (hasInternalRange && internalMax >= internalMin)
+        param.setInternalRange(internalMin, internalMax);
+    param.setFrequency(frequency);
+
+    return stream;
 }
 
 QT_END_NAMESPACE
@@ -23,6 +23,8 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 QT_BEGIN_NAMESPACE
 
+class QDataStream;
+
 namespace Phonon
 {
 namespace MMF
@@ -55,16 +57,43 @@ public:
                     const QString &description = QString());
 
     void setInternalRange(qint32 min, qint32 max);
+    bool hasInternalRange() const;
+    qint32 internalMinimum() const;
+    qint32 internalMaximum() const;
     qint32 toInternalValue(qreal external) const;
 
     static qreal toExternalValue(qint32 value, qint32 min, qint32 max);
 
+    /**
+     * For parameters which control a frequency band, such as those of the
+     * audio equalizer, the center frequency of the band in Hz.  Zero for
+     * other parameters.
+     */
+    void setFrequency(qint32 hz);
+    qint32 frequency() const;
+
 private:
+    friend QDataStream &operator<<(QDataStream &stream, const EffectParameter &param);
+    friend QDataStream &operator>>(QDataStream &stream, EffectParameter &param);
+
+private:
+    // The base class does not provide access to the hints
+    Hints                   m_hints;
+
     bool                    m_hasInternalRange;
     QPair<qint32, qint32>   m_internalRange;
 
+    qint32                  m_frequency;
+
 };
 
+/**
+ * Serialization, used by EffectFactory to cache the parameters which are
+ * discovered by querying the platform.
+ */
+QDataStream &operator<<(QDataStream &stream, const EffectParameter &param);
+QDataStream &operator>>(QDataStream &stream, EffectParameter &param);
+
 }
 }
 
@@ -0,0 +1,92 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "effectpreset.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::EffectPreset
+  \internal
+*/
+
+MMF::EffectPreset::EffectPreset()
+{
+
+}
+
+bool MMF::EffectPreset::create(const QString &name,
+                               const EffectDescriptorPointer &descriptor,
+                               const QMap<int, qint32> &values,
+                               EffectPreset &preset)
+{
+    const int count = descriptor->count();
+    QVector<qint32> internalValues(count);
+    QVector<QVariant> externalValues(count);
+
+    QMap<int, qint32>::const_iterator value = values.begin();
+    for ( ; value != values.end(); ++value)
+        if (-1 == descriptor->indexOf(value.key()))
+            return false;
+
+    for (int i = 0; i < count; ++i) {
+        const EffectParameter &param = descriptor->parameter(i);
+        const bool specified = values.contains(param.id());
+
+        // Parameters without an internal range are toggles
+        if (param.hasInternalRange()) {
+            const qint32 internal = specified
+                ? values.value(param.id())
+                : param.toInternalValue(param.defaultValue().toReal());
+            if (internal < param.internalMinimum() || internal > param.internalMaximum())
+                return false;
+            internalValues[i] = internal;
+            externalValues[i] = QVariant(EffectParameter::toExternalValue
+                (internal, param.internalMinimum(), param.internalMaximum()));
+        } else {
+            const qint32 internal = specified
+                ? values.value(param.id())
+                : qint32(param.defaultValue().toBool());
+            if (internal != 0 && internal != 1)
+                return false;
+            internalValues[i] = internal;
+            externalValues[i] = QVariant(bool(internal));
+        }
+    }
+
+    preset.m_name = name;
+    preset.m_descriptor = descriptor;
+    preset.m_internalValues = internalValues;
+    preset.m_externalValues = externalValues;
+    return true;
+}
+
+QString MMF::EffectPreset::name() const
+{
+    return m_name;
+}
+
+const EffectDescriptorPointer &MMF::EffectPreset::descriptor() const
+{
+    return m_descriptor;
+}
+
+QT_END_NAMESPACE
+
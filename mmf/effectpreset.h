@@ -0,0 +1,93 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_EFFECTPRESET_H
+#define PHONON_MMF_EFFECTPRESET_H
+
+#include <QMap>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+#include "effectdescriptor.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Complete set of parameter values for one type of effect
+ *
+ * Values are held in internal units, i.e. those of the native effect, so
+ * that applying a preset does not require any conversion.  The
+ * corresponding external values, which are reported to the client via
+ * AbstractAudioEffect::parameterValue(), are computed when the preset is
+ * created.  Both are indexed in the same way as the parameters of the
+ * descriptor.
+ *
+ * Presets are held by the EffectFactory, and applied via
+ * AbstractAudioEffect::applyPreset().
+ */
+class EffectPreset
+{
+public:
+    EffectPreset();
+
+    /**
+     * Creates a preset from values keyed on parameter ID.  Parameters
+     * which are not specified take their default values.  Returns false,
+     * leaving preset unchanged, if any ID is unknown or any value is out
+     * of range.
+     */
+    static bool create(const QString &name,
+                       const EffectDescriptorPointer &descriptor,
+                       const QMap<int, qint32> &values,
+                       EffectPreset &preset);
+
+    QString name() const;
+    const EffectDescriptorPointer &descriptor() const;
+    qint32 internalValue(int index) const;
+    const QVariant &externalValue(int index) const;
+
+private:
+    QString                     m_name;
+    EffectDescriptorPointer     m_descriptor;
+    QVector<qint32>             m_internalValues;
+    QVector<QVariant>           m_externalValues;
+
+};
+
+inline qint32 EffectPreset::internalValue(int index) const
+{
+    return m_internalValues.at(index);
+}
+
+inline const QVariant &EffectPreset::externalValue(int index) const
+{
+    return m_externalValues.at(index);
+}
+
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,123 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QDataStream>
+#include <QFile>
+
+#include "effectpresetbank.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::EffectPresetBank
+  \internal
+*/
+
+MMF::EffectPresetBank::EffectPresetBank()
+{
+
+}
+
+bool MMF::EffectPresetBank::add(int type,
+                                const EffectDescriptorPointer &descriptor,
+                                const QString &name,
+                                const QMap<int, qint32> &values)
+{
+    EffectPreset preset;
+    if (!EffectPreset::create(name, descriptor, values, preset))
+        return false;
+
+    QList<EffectPreset> &presets = m_presets[type];
+    for (int i = 0; i < presets.count(); ++i) {
+        if (presets.at(i).name() == name) {
+            presets[i] = preset;
+            return true;
+        }
+    }
+
+    presets.append(preset);
+    return true;
+}
+
+/**
+ * The file consists of a header, followed by a count of presets.  Each
+ * preset comprises its effect type, name and a count of values, followed
+ * by that many pairs of parameter ID and internal value.
+ */
+bool MMF::EffectPresetBank::load(const QString &fileName,
+                                 const QHash<int, EffectDescriptorPointer> &descriptors)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (quint32(FileMagic) != magic || quint32(FileVersion) != version)
+        return false;
+
+    qint32 count = 0;
+    stream >> count;
+    for (qint32 i = 0; i < count && QDataStream::Ok == stream.status(); ++i) {
+        qint32 type = 0;
+        QString name;
+        qint32 valueCount = 0;
+        stream >> type >> name >> valueCount;
+
+        QMap<int, qint32> values;
+        for (qint32 j = 0; j < valueCount && QDataStream::Ok == stream.status(); ++j) {
+            qint32 id = 0;
+            qint32 value = 0;
+            stream >> id >> value;
+            values.insert(id, value);
+        }
+
+        // Presets which are not valid on this platform are skipped
+        if (QDataStream::Ok == stream.status() && descriptors.contains(type))
+            add(type, descriptors.value(type), name, values);
+    }
+
+    return QDataStream::Ok == stream.status();
+}
+
+QStringList MMF::EffectPresetBank::names(int type) const
+{
+    QStringList result;
+    foreach (const EffectPreset &preset, m_presets.value(type))
+        result.append(preset.name());
+    return result;
+}
+
+const EffectPreset *MMF::EffectPresetBank::preset(int type, const QString &name) const
+{
+    QHash<int, QList<EffectPreset> >::const_iterator i = m_presets.find(type);
+    if (i != m_presets.end())
+        for (int j = 0; j < i.value().count(); ++j)
+            if (i.value().at(j).name() == name)
+                return &i.value().at(j);
+    return 0;
+}
+
+QT_END_NAMESPACE
+
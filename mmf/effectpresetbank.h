@@ -0,0 +1,87 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_EFFECTPRESETBANK_H
+#define PHONON_MMF_EFFECTPRESETBANK_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+
+#include "effectpreset.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Presets for each type of effect
+ *
+ * Types are identified by EffectFactory::Type.  The bank does not depend
+ * on the platform: the EffectFactory supplies the descriptor for each
+ * type which is supported, and presets are validated against it.
+ */
+class EffectPresetBank
+{
+public:
+    EffectPresetBank();
+
+    /**
+     * Adds a preset, replacing any existing preset for the same type with
+     * the same name.  Returns false if the values are not valid for the
+     * descriptor.
+     */
+    bool add(int type, const EffectDescriptorPointer &descriptor,
+             const QString &name, const QMap<int, qint32> &values);
+
+    /**
+     * Adds the presets stored in @p fileName.  Presets for types which
+     * are not in @p descriptors, or which are not valid for the
+     * descriptor, are skipped.  Returns false if the file cannot be read.
+     */
+    bool load(const QString &fileName,
+              const QHash<int, EffectDescriptorPointer> &descriptors);
+
+    QStringList names(int type) const;
+
+    /**
+     * Returns the preset with the specified name, or null if there is no
+     * such preset.  The pointer is invalidated if presets are added.
+     */
+    const EffectPreset *preset(int type, const QString &name) const;
+
+    enum Constants
+    {
+        FileMagic = 0x50455031, // "PEP1"
+        FileVersion = 1
+    };
+
+private:
+    QHash<int, QList<EffectPreset> >    m_presets;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -16,8 +16,8 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-#include <EnvironmentalReverbBase.h>
 #include "environmentalreverb.h"
+#include "fdnreverb.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -28,9 +28,6 @@ using namespace Phonon::MMF;
   \internal
 */
 
-// Define functions which depend on concrete native effect class name
-PHONON_MMF_DEFINE_EFFECT_FUNCTIONS(EnvironmentalReverb)
-
 enum Parameters
 {
     DecayHFRatio = AbstractAudioEffect::ParameterBase,
@@ -45,18 +42,15 @@ enum Parameters
     RoomLevel
 };
 
-EnvironmentalReverb::EnvironmentalReverb(QObject *parent, const QList<EffectParameter>& parameters)
-    :   AbstractAudioEffect::AbstractAudioEffect(parent, parameters)
+EnvironmentalReverb::EnvironmentalReverb(QObject *parent, const EffectDescriptorPointer &descriptor)
+    :   NativeAudioEffect<CEnvironmentalReverb>(parent, descriptor)
 {
 
 }
 
 int EnvironmentalReverb::effectParameterChanged(const EffectParameter &param,
-                                      const QVariant &value)
+                                      qint32 internalLevel)
 {
-    const qreal externalLevel = value.toReal();
-    const int internalLevel = param.toInternalValue(externalLevel);
-
     TInt err = 0;
 
     switch(param.id()) {
@@ -97,6 +91,36 @@ int EnvironmentalReverb::effectParameterChanged(const EffectParameter &param,
     return err;
 }
 
+AudioProcessor *EnvironmentalReverb::createProcessor(int sampleRate, int channelCount)
+{
+    if (channelCount > FdnReverb::MaxChannelCount)
+        return 0;
+
+    // The delay lines are sized for the maximum delays supported by the
+    // native effect, so that the parameters have the same ranges.
+    const EffectDescriptor &parameters = *descriptor();
+    const int reflectionsDelay = parameters.indexOf(ReflectionsDelay);
+    const int reverbDelay = parameters.indexOf(ReverbDelay);
+    const qint32 maxReflectionsDelay = (-1 == reflectionsDelay)
+        ? FdnReverb::DefaultMaxReflectionsDelay
+        : parameters.parameter(reflectionsDelay).internalMaximum();
+    const qint32 maxReverbDelay = (-1 == reverbDelay)
+        ? FdnReverb::DefaultMaxReverbDelay
+        : parameters.parameter(reverbDelay).internalMaximum();
+
+    return new FdnReverb(sampleRate, channelCount,
+                         maxReflectionsDelay, maxReverbDelay);
+}
+
+void EnvironmentalReverb::processorParameterChanged(const EffectParameter &param,
+                                                    qint32 internalLevel)
+{
+    // The order of FdnReverb::Parameter matches that of the parameter IDs
+    FdnReverb *const reverb = static_cast<FdnReverb *>(m_processor.data());
+    reverb->setParameter(FdnReverb::Parameter(param.id() - ParameterBase),
+                         internalLevel);
+}
+
 
 //-----------------------------------------------------------------------------
 // Static functions
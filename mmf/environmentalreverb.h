@@ -19,9 +19,9 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PHONON_MMF_ENVIRONMENTALREVERB_H
 #define PHONON_MMF_ENVIRONMENTALREVERB_H
 
-#include "abstractaudioeffect.h"
+#include <EnvironmentalReverbBase.h>
 
-class CEnvironmentalReverb;
+#include "abstractaudioeffect.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -32,11 +32,11 @@ namespace MMF
 /**
  * @short A reverb effect.
  */
-class EnvironmentalReverb : public AbstractAudioEffect
+class EnvironmentalReverb : public NativeAudioEffect<CEnvironmentalReverb>
 {
     Q_OBJECT
 public:
-    EnvironmentalReverb(QObject *parent, const QList<EffectParameter>& parameters);
+    EnvironmentalReverb(QObject *parent, const EffectDescriptorPointer &descriptor);
 
     // Static interface required by EffectFactory
     static const char* description();
@@ -45,13 +45,11 @@ public:
 
 protected:
     // AbstractAudioEffect
-    virtual void createEffect(AudioPlayer::NativePlayer *player);
     virtual int effectParameterChanged(const EffectParameter &param,
-                                       const QVariant &value);
-
-private:
-    CEnvironmentalReverb *concreteEffect();
-
+                                       qint32 internalLevel);
+    virtual AudioProcessor *createProcessor(int sampleRate, int channelCount);
+    virtual void processorParameterChanged(const EffectParameter &param,
+                                           qint32 internalLevel);
 };
 }
 }
@@ -0,0 +1,491 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+
+#include "dspkernel.h"
+#include "fdnreverb.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::FdnReverb
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Number of frames processed between parameter updates.  This must be
+// shorter than the shortest line in the network.
+const int       BlockFrames = 32;
+
+// Lengths of the lines in the network at 100% density.  Lower densities
+// scale these down, to a minimum of MinDensityScale.
+const qreal     LineDelays[FdnReverb::LineCount] =
+    { 29.7, 37.1, 41.1, 43.7, 53.3, 59.9, 67.7, 73.3 }; // ms
+const qreal     MinDensityScale = 0.4;
+
+// Signs with which the late reverb input is fed into each line, and with
+// which each line contributes to the left and right outputs.  The output
+// patterns are orthogonal, so that the two channels are decorrelated.
+const float     InputSigns[FdnReverb::LineCount] =
+    { 1, -1, 1, -1, 1, -1, 1, -1 };
+const float     LeftSigns[FdnReverb::LineCount] =
+    { 1, 1, 1, 1, -1, -1, -1, -1 };
+const float     RightSigns[FdnReverb::LineCount] =
+    { 1, -1, -1, 1, 1, -1, -1, 1 };
+
+// Positions of the early reflection taps, relative to ReflectionsDelay.
+// Even taps feed the left channel, and odd taps the right.
+const qreal     ReflectionTaps[4] = { 0.0, 3.7, 8.3, 13.1 }; // ms
+const qreal     MaxReflectionTap = 13.1; // ms
+
+const qreal     AllpassDelays[] = { 4.7, 3.6, 2.1 }; // ms
+const int       AllpassCount = sizeof(AllpassDelays) / sizeof(AllpassDelays[0]);
+const qreal     MaxAllpassGain = 0.7;
+
+// Frequency at which RoomHFLevel is specified
+const qreal     RoomHFReference = 5000.0; // Hz
+
+const float     ReflectionsScale = 0.5f;
+const float     ReverbScale = 0.353553f; // 1 / sqrt(LineCount)
+
+// Added to the input, so that the filters and the network never decay into
+// denormal values
+const float     AntiDenormal = 1.0e-20f;
+
+struct ParameterRange
+{
+    qint32  m_minimum;
+    qint32  m_maximum;
+    qint32  m_default;
+};
+
+// The defaults are those of the I3DL2 "generic" environment.  The maxima
+// of the delays are set on construction.
+const ParameterRange ParameterRanges[FdnReverb::ParameterCount] =
+{
+    {     10,   200,    83 },   // DecayHFRatio
+    {    100, 20000,  1490 },   // DecayTime
+    {      0,   100,   100 },   // Density
+    {      0,   100,   100 },   // Diffusion
+    {      0,     0,     7 },   // ReflectionsDelay
+    { -10000,  1000, -2602 },   // ReflectionsLevel
+    {      0,     0,    11 },   // ReverbDelay
+    { -10000,  2000,   200 },   // ReverbLevel
+    { -10000,     0,  -100 },   // RoomHFLevel
+    { -10000,     0, -1000 }    // RoomLevel
+};
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+FdnReverb::FdnReverb(int sampleRate, int channelCount,
+                     qint32 maxReflectionsDelay, qint32 maxReverbDelay)
+    :   m_sampleRate(sampleRate)
+    ,   m_channelCount(channelCount)
+    ,   m_maxReflectionsDelay(maxReflectionsDelay)
+    ,   m_maxReverbDelay(maxReverbDelay)
+    ,   m_parameters(ParameterCount)
+    ,   m_parametersChanged(true)
+    ,   m_bufferSize(0)
+    ,   m_lateTap(0)
+    ,   m_allpasses(AllpassCount)
+    ,   m_allpassGain(0.0f)
+    ,   m_position(0)
+    ,   m_roomFilterCoefficient(0.0f)
+    ,   m_roomFilterState(0.0f)
+    ,   m_reflectionsGain(0.0f)
+    ,   m_reverbGain(0.0f)
+    ,   m_targetReflectionsGain(0.0f)
+    ,   m_targetReverbGain(0.0f)
+    ,   m_late(BlockFrames)
+    ,   m_early(BlockFrames * 2)
+    ,   m_network(BlockFrames * LineCount)
+    ,   m_wet(BlockFrames * 2)
+{
+    Q_ASSERT_X(channelCount > 0 && channelCount <= MaxChannelCount,
+               Q_FUNC_INFO, "Invalid channel count");
+    Q_ASSERT_X(frames(LineDelays[0] * MinDensityScale) >= BlockFrames,
+               Q_FUNC_INFO, "Sample rate too low");
+
+    for (int i = 0; i < ParameterCount; ++i)
+        m_parameters[i] = qBound(minimum(Parameter(i)),
+                                 ParameterRanges[i].m_default,
+                                 maximum(Parameter(i)));
+
+    m_preDelay = allocateLine(frames(maxReflectionsDelay + maxReverbDelay
+                                     + MaxReflectionTap));
+    for (int i = 0; i < AllpassCount; ++i) {
+        m_allpasses[i] = allocateLine(frames(AllpassDelays[i]));
+        m_allpasses[i].m_delay = frames(AllpassDelays[i]);
+    }
+    for (int i = 0; i < LineCount; ++i)
+        m_lines[i] = allocateLine(frames(LineDelays[i]));
+
+    m_buffer.resize(m_bufferSize);
+
+    reset();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+int FdnReverb::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+int FdnReverb::channelCount() const
+{
+    return m_channelCount;
+}
+
+void FdnReverb::setParameter(Parameter parameter, qint32 value)
+{
+    Q_ASSERT_X(parameter >= 0 && parameter < ParameterCount, Q_FUNC_INFO,
+               "Invalid parameter");
+
+    value = qBound(minimum(parameter), value, maximum(parameter));
+    if (value != m_parameters[parameter]) {
+        m_parameters[parameter] = value;
+        m_parametersChanged = true;
+    }
+}
+
+qint32 FdnReverb::parameter(Parameter parameter) const
+{
+    return m_parameters.at(parameter);
+}
+
+void FdnReverb::reset()
+{
+    m_buffer.fill(0.0f);
+    m_roomFilterState = 0.0f;
+    for (int i = 0; i < LineCount; ++i)
+        m_dampingState[i] = 0.0f;
+
+    updateParameters();
+    m_reflectionsGain = m_targetReflectionsGain;
+    m_reverbGain = m_targetReverbGain;
+}
+
+void FdnReverb::process(qint16 *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+void FdnReverb::process(float *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+int FdnReverb::memoryFootprint() const
+{
+    return (m_buffer.count() + m_late.count() + m_early.count()
+            + m_network.count() + m_wet.count()) * sizeof(float);
+}
+
+const char *FdnReverb::kernelName()
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    return SimdKernel::name();
+#else
+    return ScalarKernel::name();
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+template<typename Sample>
+void FdnReverb::processBlocks(Sample *samples, int frameCount)
+{
+    const float inputScale = 1.0f / m_channelCount;
+
+    while (frameCount > 0) {
+        const int blockFrames = qMin(frameCount, BlockFrames);
+
+        if (m_parametersChanged)
+            updateParameters();
+
+        // The pre-delay, early reflections and diffusion are processed one
+        // frame at a time, because the allpass filters are recursive.
+        float *const buffer = m_buffer.data();
+        float *const preDelay = buffer + m_preDelay.m_offset;
+        const quint32 preDelayMask = m_preDelay.m_mask;
+        float *const early = m_early.data();
+        float *const lateInput = m_late.data();
+
+        for (int f = 0; f < blockFrames; ++f) {
+            const Sample *frame = samples + f * m_channelCount;
+            float input = 0.0f;
+            for (int c = 0; c < m_channelCount; ++c)
+                input += toFloat(frame[c]);
+            input *= inputScale;
+
+            m_roomFilterState = input
+                + m_roomFilterCoefficient * (m_roomFilterState - input);
+
+            const quint32 position = m_position + f;
+            preDelay[position & preDelayMask] = m_roomFilterState + AntiDenormal;
+
+            early[2 * f] =
+                  preDelay[(position - m_reflectionTaps[0]) & preDelayMask]
+                + preDelay[(position - m_reflectionTaps[2]) & preDelayMask];
+            early[2 * f + 1] =
+                  preDelay[(position - m_reflectionTaps[1]) & preDelayMask]
+                + preDelay[(position - m_reflectionTaps[3]) & preDelayMask];
+
+            float late = preDelay[(position - m_lateTap) & preDelayMask];
+            for (int i = 0; i < AllpassCount; ++i) {
+                const DelayLine &allpass = m_allpasses[i];
+                float *const line = buffer + allpass.m_offset;
+                const float delayed = line[(position - allpass.m_delay) & allpass.m_mask];
+                const float v = late + m_allpassGain * delayed;
+                line[position & allpass.m_mask] = v;
+                late = delayed - m_allpassGain * v;
+            }
+            lateInput[f] = late;
+        }
+
+#ifdef PHONON_MMF_DSP_SIMD
+        processNetwork<SimdKernel>(blockFrames);
+#else
+        processNetwork<ScalarKernel>(blockFrames);
+#endif
+
+        // Mix the wet signal into the output, ramping the gains
+        const float *const wet = m_wet.data();
+        const float reflectionsStep =
+            (m_targetReflectionsGain - m_reflectionsGain) / blockFrames;
+        const float reverbStep = (m_targetReverbGain - m_reverbGain) / blockFrames;
+
+        for (int f = 0; f < blockFrames; ++f) {
+            m_reflectionsGain += reflectionsStep;
+            m_reverbGain += reverbStep;
+
+            const float left = m_reflectionsGain * early[2 * f]
+                             + m_reverbGain * wet[2 * f];
+            const float right = m_reflectionsGain * early[2 * f + 1]
+                              + m_reverbGain * wet[2 * f + 1];
+
+            Sample *frame = samples + f * m_channelCount;
+            if (1 == m_channelCount) {
+                fromFloat(toFloat(frame[0]) + 0.5f * (left + right), frame[0]);
+            } else {
+                fromFloat(toFloat(frame[0]) + left, frame[0]);
+                fromFloat(toFloat(frame[1]) + right, frame[1]);
+            }
+        }
+
+        m_reflectionsGain = m_targetReflectionsGain;
+        m_reverbGain = m_targetReverbGain;
+
+        m_position += blockFrames;
+        samples += blockFrames * m_channelCount;
+        frameCount -= blockFrames;
+    }
+}
+
+/**
+ * Runs the feedback delay network for one block.  Because every line is
+ * longer than a block, the outputs of each line for the whole block are
+ * read before any of its inputs are written, so each line is accessed as
+ * a contiguous run.  m_network holds the values of all lines for each
+ * frame, so that the per-frame arithmetic operates on all lines at once.
+ */
+template<typename Kernel>
+void FdnReverb::processNetwork(int frameCount)
+{
+    typedef typename Kernel::Vector Vector;
+    const int lanes = Kernel::Lanes;
+    const int vectors = LineCount / lanes;
+
+    float *const buffer = m_buffer.data();
+    float *const network = m_network.data();
+    const float *const lateInput = m_late.data();
+    float *const wet = m_wet.data();
+
+    for (int i = 0; i < LineCount; ++i) {
+        const DelayLine &line = m_lines[i];
+        const float *const data = buffer + line.m_offset;
+        const quint32 start = m_position - line.m_delay;
+        for (int f = 0; f < frameCount; ++f)
+            network[f * LineCount + i] = data[(start + f) & line.m_mask];
+    }
+
+    Vector b[vectors], a[vectors], state[vectors];
+    Vector inputSigns[vectors], leftSigns[vectors], rightSigns[vectors];
+    for (int v = 0; v < vectors; ++v) {
+        b[v] = Kernel::load(m_dampingB + v * lanes);
+        a[v] = Kernel::load(m_dampingA + v * lanes);
+        state[v] = Kernel::load(m_dampingState + v * lanes);
+        inputSigns[v] = Kernel::load(InputSigns + v * lanes);
+        leftSigns[v] = Kernel::load(LeftSigns + v * lanes);
+        rightSigns[v] = Kernel::load(RightSigns + v * lanes);
+    }
+
+    const float feedbackScale = 2.0f / LineCount;
+
+    for (int f = 0; f < frameCount; ++f) {
+        float *const values = network + f * LineCount;
+
+        // Damping, which also applies the decay gain
+        Vector total = Kernel::set(0.0f);
+        Vector left = Kernel::set(0.0f);
+        Vector right = Kernel::set(0.0f);
+        for (int v = 0; v < vectors; ++v) {
+            const Vector x = Kernel::load(values + v * lanes);
+            state[v] = Kernel::add(Kernel::mul(b[v], x), Kernel::mul(a[v], state[v]));
+            total = Kernel::add(total, state[v]);
+            left = Kernel::add(left, Kernel::mul(leftSigns[v], state[v]));
+            right = Kernel::add(right, Kernel::mul(rightSigns[v], state[v]));
+        }
+
+        wet[2 * f] = Kernel::sum(left);
+        wet[2 * f + 1] = Kernel::sum(right);
+
+        // Householder feedback matrix: I - (2 / N) * ones
+        const Vector feedback = Kernel::set(feedbackScale * Kernel::sum(total));
+        const Vector input = Kernel::set(lateInput[f]);
+        for (int v = 0; v < vectors; ++v)
+            Kernel::store(values + v * lanes,
+                Kernel::add(Kernel::sub(state[v], feedback),
+                            Kernel::mul(inputSigns[v], input)));
+    }
+
+    for (int v = 0; v < vectors; ++v)
+        Kernel::store(m_dampingState + v * lanes, state[v]);
+
+    for (int i = 0; i < LineCount; ++i) {
+        const DelayLine &line = m_lines[i];
+        float *const data = buffer + line.m_offset;
+        for (int f = 0; f < frameCount; ++f)
+            data[(m_position + f) & line.m_mask] = network[f * LineCount + i];
+    }
+}
+
+void FdnReverb::updateParameters()
+{
+    const qreal decayTime = m_parameters[DecayTime] / 1000.0;
+
+    // A one-pole damping filter cannot boost high frequencies, so ratios
+    // above 1.0 are treated as 1.0.
+    const qreal hfRatio = qMin(m_parameters[DecayHFRatio] / 100.0, 1.0);
+
+    const qreal densityScale = MinDensityScale
+        + (1.0 - MinDensityScale) * m_parameters[Density] / 100.0;
+
+    for (int i = 0; i < LineCount; ++i) {
+        const int delay = qMax(int(BlockFrames), frames(LineDelays[i] * densityScale));
+        m_lines[i].m_delay = delay;
+
+        // Gains per pass through the line, for a 60 dB decay over the
+        // decay time at DC, and over the decay time * ratio at Nyquist
+        const qreal gain = qPow(10.0, -3.0 * delay / (decayTime * m_sampleRate));
+        const qreal hfGain = qPow(10.0, -3.0 * delay / (decayTime * hfRatio * m_sampleRate));
+        const qreal a = (gain - hfGain) / (gain + hfGain);
+        m_dampingA[i] = a;
+        m_dampingB[i] = gain * (1.0 - a);
+    }
+
+    m_allpassGain = MaxAllpassGain * m_parameters[Diffusion] / 100.0;
+
+    const qint32 reflectionsDelay = m_parameters[ReflectionsDelay];
+    for (int i = 0; i < 4; ++i)
+        m_reflectionTaps[i] = frames(reflectionsDelay + ReflectionTaps[i]);
+    m_lateTap = frames(reflectionsDelay + m_parameters[ReverbDelay]);
+
+    // One-pole lowpass y = (1 - c) * x + c * y', with the specified gain at
+    // the reference frequency
+    const qreal hfLevel = qPow(10.0, m_parameters[RoomHFLevel] / 2000.0);
+    if (hfLevel >= 1.0) {
+        m_roomFilterCoefficient = 0.0f;
+    } else {
+        const qreal frequency = qMin(RoomHFReference, 0.45 * m_sampleRate);
+        const qreal cosOmega = qCos(2.0 * M_PI * frequency / m_sampleRate);
+        const qreal g2 = hfLevel * hfLevel;
+        const qreal b = 1.0 - g2 * cosOmega;
+        const qreal c = 1.0 - g2;
+        m_roomFilterCoefficient = (b - qSqrt(b * b - c * c)) / c;
+    }
+
+    const qint32 roomLevel = m_parameters[RoomLevel];
+    m_targetReflectionsGain = ReflectionsScale
+        * qPow(10.0, (roomLevel + m_parameters[ReflectionsLevel]) / 2000.0);
+    m_targetReverbGain = ReverbScale
+        * qPow(10.0, (roomLevel + m_parameters[ReverbLevel]) / 2000.0);
+
+    m_parametersChanged = false;
+}
+
+int FdnReverb::frames(qreal ms) const
+{
+    return qRound(ms * m_sampleRate / 1000.0);
+}
+
+/**
+ * Reserves a region of m_buffer for a delay line of up to maxDelay frames.
+ * The line's capacity is rounded up to a power of two, so that positions
+ * can be wrapped with a mask.
+ */
+FdnReverb::DelayLine FdnReverb::allocateLine(int maxDelay)
+{
+    int capacity = 1;
+    while (capacity < maxDelay + BlockFrames + 1)
+        capacity <<= 1;
+
+    DelayLine line;
+    line.m_offset = m_bufferSize;
+    line.m_mask = capacity - 1;
+    line.m_delay = 0;
+
+    m_bufferSize += capacity;
+    return line;
+}
+
+qint32 FdnReverb::minimum(Parameter parameter) const
+{
+    return ParameterRanges[parameter].m_minimum;
+}
+
+qint32 FdnReverb::maximum(Parameter parameter) const
+{
+    switch (parameter) {
+    case ReflectionsDelay:
+        return m_maxReflectionsDelay;
+    case ReverbDelay:
+        return m_maxReverbDelay;
+    default:
+        return ParameterRanges[parameter].m_maximum;
+    }
+}
+
+QT_END_NAMESPACE
+
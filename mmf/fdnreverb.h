@@ -0,0 +1,189 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_FDNREVERB_H
+#define PHONON_MMF_FDNREVERB_H
+
+#include <QVector>
+
+#include "audiograph.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short In-process reverb based on a feedback delay network
+ *
+ * The parameters are the same as those of CEnvironmentalReverb, which is
+ * used by EnvironmentalReverb, and are expressed in the same internal
+ * units, so that they can be driven from the same EffectParameter
+ * ranges.  The order of the Parameter enumeration matches that of the
+ * EnvironmentalReverb parameter IDs.
+ *
+ * The input is mixed down to mono and filtered by the room high-frequency
+ * filter, and then passes through a pre-delay line.  Early reflections
+ * are taken from taps starting at ReflectionsDelay; the late reverb is
+ * fed from ReflectionsDelay + ReverbDelay, via a chain of diffusing
+ * allpass filters, into an 8-line feedback delay network with a
+ * Householder feedback matrix and per-line high-frequency damping.  The
+ * wet signal is added to the dry signal in place.
+ *
+ * The network is processed in blocks which are shorter than its shortest
+ * delay, so each delay line is read and written as a contiguous run of
+ * samples per block, while the per-sample arithmetic operates on all
+ * lines at once, using SSE2 or NEON where available.
+ *
+ * All memory is allocated on construction, sized for the maximum delays
+ * passed to the constructor; process() does not allocate.
+ */
+class FdnReverb : public AudioProcessor
+{
+public:
+    enum Parameter
+    {
+        DecayHFRatio = 0,       // hundredths
+        DecayTime,              // ms
+        Density,                // %
+        Diffusion,              // %
+        ReflectionsDelay,       // ms
+        ReflectionsLevel,       // mB
+        ReverbDelay,            // ms
+        ReverbLevel,            // mB
+        RoomHFLevel,            // mB
+        RoomLevel,              // mB
+        ParameterCount // must be last entry in enum
+    };
+
+    enum Constants
+    {
+        MaxChannelCount = 2,
+        DefaultMaxReflectionsDelay = 300, // ms
+        DefaultMaxReverbDelay = 100 // ms
+    };
+
+    FdnReverb(int sampleRate, int channelCount,
+              qint32 maxReflectionsDelay = DefaultMaxReflectionsDelay,
+              qint32 maxReverbDelay = DefaultMaxReverbDelay);
+
+    int sampleRate() const;
+    int channelCount() const;
+
+    /**
+     * Values are clamped to the valid range of the parameter, and take
+     * effect at the start of the next block.  Level changes are ramped
+     * across the block; changes to Density, which alter the lengths of
+     * the delay lines, are not smoothed.
+     */
+    void setParameter(Parameter parameter, qint32 value);
+    qint32 parameter(Parameter parameter) const;
+
+    /**
+     * Clears all delay lines and filter state.
+     */
+    void reset();
+
+    /**
+     * Adds reverb to frameCount frames of interleaved samples in place.
+     */
+    void process(qint16 *samples, int frameCount);
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
+    /**
+     * Size in bytes of the buffers allocated on construction.
+     */
+    int memoryFootprint() const;
+
+    /**
+     * Name of the kernel which is used, e.g. "sse2" or "scalar".
+     */
+    static const char *kernelName();
+
+    enum { LineCount = 8 };
+
+private:
+    struct DelayLine
+    {
+        int     m_offset;   // into m_buffer
+        int     m_mask;     // capacity - 1; capacity is a power of 2
+        int     m_delay;    // frames
+    };
+
+    template<typename Sample> void processBlocks(Sample *samples, int frameCount);
+    template<typename Kernel> void processNetwork(int frameCount);
+    void updateParameters();
+    int frames(qreal ms) const;
+    DelayLine allocateLine(int maxDelay);
+    qint32 minimum(Parameter parameter) const;
+    qint32 maximum(Parameter parameter) const;
+
+private:
+    const int                   m_sampleRate;
+    const int                   m_channelCount;
+    const qint32                m_maxReflectionsDelay;
+    const qint32                m_maxReverbDelay;
+
+    QVector<qint32>             m_parameters;
+    bool                        m_parametersChanged;
+
+    // All delay lines share this buffer, each occupying a contiguous
+    // region.
+    QVector<float>              m_buffer;
+    int                         m_bufferSize;
+
+    DelayLine                   m_preDelay;
+    int                         m_reflectionTaps[4];
+    int                         m_lateTap;
+    QVector<DelayLine>          m_allpasses;
+    float                       m_allpassGain;
+    DelayLine                   m_lines[LineCount];
+    quint32                     m_position;
+
+    // Room high-frequency filter
+    float                       m_roomFilterCoefficient;
+    float                       m_roomFilterState;
+
+    // Per-line damping filters: y = b * x + a * y'
+    float                       m_dampingB[LineCount];
+    float                       m_dampingA[LineCount];
+    float                       m_dampingState[LineCount];
+
+    // Output gains, ramped across each block
+    float                       m_reflectionsGain;
+    float                       m_reverbGain;
+    float                       m_targetReflectionsGain;
+    float                       m_targetReverbGain;
+
+    // Per-block working storage
+    QVector<float>              m_late;
+    QVector<float>              m_early;
+    QVector<float>              m_network;
+    QVector<float>              m_wet;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
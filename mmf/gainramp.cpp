@@ -0,0 +1,232 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+
+#include "dspkernel.h"
+#include "gainramp.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::GainRamp
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+GainRamp::GainRamp(int sampleRate, int channelCount)
+    :   m_sampleRate(sampleRate)
+    ,   m_channelCount(channelCount)
+    ,   m_simd(useSimd(channelCount))
+    ,   m_gain(1.0f)
+    ,   m_fadeFrom(1.0f)
+    ,   m_fadeTo(1.0f)
+    ,   m_curve(Fade3Decibel)
+    ,   m_fadeFrames(0)
+    ,   m_elapsedFrames(0)
+{
+    Q_ASSERT_X(sampleRate > 0 && channelCount > 0, Q_FUNC_INFO, "Invalid format");
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+float GainRamp::curveValue(Curve curve, float from, float to, float position)
+{
+    // The shapes are those of fades in from silence; fades out are their
+    // mirror images, so that the attenuation at the midpoint is the same
+    // in both directions.
+    const bool rising = to >= from;
+    const float t = qBound(0.0f, position, 1.0f);
+    const float x = rising ? t : 1.0f - t;
+
+    float shape = x;
+    switch (curve) {
+    case Fade3Decibel:
+        shape = qSin(M_PI_2 * x);
+        break;
+    case Fade6Decibel:
+        shape = x;
+        break;
+    case Fade9Decibel:
+        shape = x * qSqrt(x);
+        break;
+    case Fade12Decibel:
+        shape = x * x;
+        break;
+    }
+
+    return rising ? from + (to - from) * shape : to + (from - to) * shape;
+}
+
+void GainRamp::setGain(float gain)
+{
+    m_gain = gain;
+    m_fadeFrames = 0;
+}
+
+float GainRamp::gain() const
+{
+    return m_gain;
+}
+
+void GainRamp::fadeTo(float gain, int duration, Curve curve)
+{
+    const qint64 frames = qint64(duration) * m_sampleRate / 1000;
+
+    if (frames > 0) {
+        m_fadeFrom = m_gain;
+        m_fadeTo = gain;
+        m_curve = curve;
+        m_fadeFrames = frames;
+        m_elapsedFrames = 0;
+    } else {
+        setGain(gain);
+    }
+}
+
+bool GainRamp::isFading() const
+{
+    return m_fadeFrames > 0;
+}
+
+void GainRamp::process(qint16 *samples, int frameCount)
+{
+    processSegments(samples, frameCount);
+}
+
+void GainRamp::process(float *samples, int frameCount)
+{
+    processSegments(samples, frameCount);
+}
+
+const char *GainRamp::kernelName() const
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    if (m_simd)
+        return SimdKernel::name();
+#endif
+    return ScalarKernel::name();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+bool GainRamp::useSimd(int channelCount)
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    return 0 == SimdKernel::Lanes % channelCount;
+#else
+    Q_UNUSED(channelCount)
+    return false;
+#endif
+}
+
+/**
+ * Scales frameCount frames, the first by gain, and each subsequent one by
+ * step more than its predecessor.
+ */
+void GainRamp::scale(qint16 *samples, int frameCount, float gain, float step)
+{
+    for (int f = 0; f < frameCount; ++f) {
+        const float frameGain = gain + f * step;
+        for (int c = 0; c < m_channelCount; ++c, ++samples)
+            fromFloat(frameGain * toFloat(*samples), *samples);
+    }
+}
+
+/**
+ * As above, for floating-point samples, which are scaled in place by the
+ * SIMD kernel if possible.  Each vector holds Lanes / m_channelCount
+ * frames, and a vector of gains in which each frame's lanes have the same
+ * value.
+ */
+void GainRamp::scale(float *samples, int frameCount, float gain, float step)
+{
+    int f = 0;
+
+#ifdef PHONON_MMF_DSP_SIMD
+    if (m_simd) {
+        typedef SimdKernel::Vector Vector;
+        const int lanes = SimdKernel::Lanes;
+        const int framesPerVector = lanes / m_channelCount;
+
+        float initial[lanes];
+        for (int l = 0; l < lanes; ++l)
+            initial[l] = gain + (l / m_channelCount) * step;
+
+        Vector gains = SimdKernel::load(initial);
+        const Vector increment = SimdKernel::set(framesPerVector * step);
+
+        for ( ; f + framesPerVector <= frameCount; f += framesPerVector) {
+            SimdKernel::store(samples, SimdKernel::mul(SimdKernel::load(samples), gains));
+            gains = SimdKernel::add(gains, increment);
+            samples += lanes;
+        }
+
+    }
+#endif
+
+    for ( ; f < frameCount; ++f) {
+        const float frameGain = gain + f * step;
+        for (int c = 0; c < m_channelCount; ++c, ++samples)
+            *samples *= frameGain;
+    }
+}
+
+template<typename Sample>
+void GainRamp::processSegments(Sample *samples, int frameCount)
+{
+    while (frameCount > 0) {
+        if (!isFading()) {
+            if (1.0f != m_gain)
+                scale(samples, frameCount, m_gain, 0.0f);
+            return;
+        }
+
+        const int frames = int(qMin(qint64(qMin(frameCount, int(SegmentFrames))),
+                                    m_fadeFrames - m_elapsedFrames));
+        m_elapsedFrames += frames;
+
+        const bool complete = m_elapsedFrames >= m_fadeFrames;
+        const float end = complete ? m_fadeTo
+            : curveValue(m_curve, m_fadeFrom, m_fadeTo,
+                         float(m_elapsedFrames) / m_fadeFrames);
+
+        scale(samples, frames, m_gain, (end - m_gain) / frames);
+
+        m_gain = end;
+        if (complete)
+            m_fadeFrames = 0;
+
+        samples += frames * m_channelCount;
+        frameCount -= frames;
+    }
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,129 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_GAINRAMP_H
+#define PHONON_MMF_GAINRAMP_H
+
+#include <QtGlobal>
+
+#include "audiograph.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short In-process gain with curved fades
+ *
+ * A fade starts at the current gain, and reaches the target gain after
+ * exactly the number of frames corresponding to its duration.  The fade
+ * curve is evaluated every SegmentFrames frames, and the gain is
+ * interpolated linearly between those points, so that it changes on
+ * every sample.
+ *
+ * Samples are interleaved 16-bit or floating-point PCM, and are processed
+ * in place.  Where SSE2 or NEON is available, and the number of lanes is
+ * a multiple of the channel count, several frames are scaled per vector.
+ *
+ * The fade is advanced by processing, i.e. it is suspended while no
+ * audio is processed.
+ */
+class GainRamp : public AudioProcessor
+{
+public:
+    /**
+     * The same curves as Phonon::VolumeFaderEffect::FadeCurve.  The name
+     * gives the attenuation at the midpoint of a fade between silence and
+     * full gain.
+     */
+    enum Curve
+    {
+        Fade3Decibel,
+        Fade6Decibel,
+        Fade9Decibel,
+        Fade12Decibel
+    };
+
+    /**
+     * Gain at position, in the range 0.0 to 1.0, of a fade from one gain
+     * to another.
+     */
+    static float curveValue(Curve curve, float from, float to, float position);
+
+    GainRamp(int sampleRate, int channelCount);
+
+    enum Constants
+    {
+        SegmentFrames = 64
+    };
+
+    /**
+     * Sets the gain immediately, cancelling any fade in progress.
+     */
+    void setGain(float gain);
+
+    /**
+     * Current gain.
+     */
+    float gain() const;
+
+    void fadeTo(float gain, int duration, Curve curve);
+    bool isFading() const;
+
+    /**
+     * Scales frameCount frames of interleaved samples in place.
+     */
+    void process(qint16 *samples, int frameCount);
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
+    /**
+     * Name of the kernel which is used, e.g. "sse2" or "scalar".
+     */
+    const char *kernelName() const;
+
+private:
+    static bool useSimd(int channelCount);
+    template<typename Sample> void processSegments(Sample *samples, int frameCount);
+    void scale(qint16 *samples, int frameCount, float gain, float step);
+    void scale(float *samples, int frameCount, float gain, float step);
+
+private:
+    const int                   m_sampleRate;
+    const int                   m_channelCount;
+    const bool                  m_simd;
+
+    float                       m_gain;
+
+    float                       m_fadeFrom;
+    float                       m_fadeTo;
+    Curve                       m_curve;
+    qint64                      m_fadeFrames;
+    qint64                      m_elapsedFrames;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -16,27 +16,45 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-#include <LoudnessBase.h>
+#include "defs.h"
 #include "loudness.h"
+#include "loudnesscompensator.h"
 
 QT_BEGIN_NAMESPACE
 
 using namespace Phonon;
 using namespace Phonon::MMF;
 
-// Define functions which depend on concrete native effect class name
-PHONON_MMF_DEFINE_EFFECT_FUNCTIONS(Loudness)
-
 /*! \class MMF::Loudness
   \internal
 */
 
-Loudness::Loudness(QObject *parent, const QList<EffectParameter>& parameters)
-    :   AbstractAudioEffect::AbstractAudioEffect(parent, parameters)
+Loudness::Loudness(QObject *parent, const EffectDescriptorPointer &descriptor)
+    :   NativeAudioEffect<CLoudness>(parent, descriptor)
+    ,   m_volume(InitialVolume)
 {
 
 }
 
+void Loudness::outputVolumeChanged(qreal volume)
+{
+    m_volume = volume;
+    if (m_processor.data())
+        static_cast<LoudnessCompensator *>(m_processor.data())->setVolume(volume);
+}
+
+AudioProcessor *Loudness::createProcessor(int sampleRate, int channelCount)
+{
+    if (channelCount > LoudnessCompensator::MaxChannelCount)
+        return 0;
+
+    LoudnessCompensator *const compensator =
+        new LoudnessCompensator(sampleRate, channelCount);
+    compensator->setVolume(m_volume);
+    compensator->reset();
+    return compensator;
+}
+
 //-----------------------------------------------------------------------------
 // Static functions
 //-----------------------------------------------------------------------------
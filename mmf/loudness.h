@@ -19,9 +19,9 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PHONON_MMF_LOUDNESS_H
 #define PHONON_MMF_LOUDNESS_H
 
-#include "abstractaudioeffect.h"
+#include <LoudnessBase.h>
 
-class CLoudness;
+#include "abstractaudioeffect.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -31,24 +31,31 @@ namespace MMF
 {
 /**
  * @short A "loudness" effect.
+ *
+ * The native effect is not aware of the volume.  The in-process
+ * implementation, LoudnessCompensator, follows the volume of the
+ * AudioOutput.
  */
-class Loudness : public AbstractAudioEffect
+class Loudness : public NativeAudioEffect<CLoudness>
 {
     Q_OBJECT
 public:
-    Loudness(QObject *parent, const QList<EffectParameter>& parameters);
+    Loudness(QObject *parent, const EffectDescriptorPointer &descriptor);
 
     // Static interface required by EffectFactory
     static const char* description();
     static bool getParameters(CMdaAudioOutputStream *stream,
         QList<EffectParameter>& parameters);
 
+    // AbstractAudioEffect
+    virtual void outputVolumeChanged(qreal volume);
+
 protected:
     // AbstractAudioEffect
-    virtual void createEffect(AudioPlayer::NativePlayer *player);
+    virtual AudioProcessor *createProcessor(int sampleRate, int channelCount);
 
 private:
-    CLoudness *concreteEffect();
+    qreal m_volume;
 
 };
 }
@@ -0,0 +1,179 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+
+#include "loudnesscompensator.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::LoudnessCompensator
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Number of frames filtered between successive updates of the coefficients
+// while the volume is ramping
+const int       BlockFrames = 32;
+
+const qreal     LowShelfFrequency = 150.0;      // Hz
+const qreal     HighShelfFrequency = 8000.0;    // Hz
+
+// Boost, in dB per dB of attenuation.  These approximate the spacing of
+// the ISO 226:2003 contours between 40 and 80 phon at 100 Hz and 10 kHz,
+// relative to 1 kHz.
+const qreal     LowShelfSlope = 0.33;
+const qreal     HighShelfSlope = 0.12;
+
+// Attenuations beyond this are compensated as if they were equal to it
+const float     MaxAttenuation = 48.0f;         // dB
+const float     TableStep = 1.5f;               // dB
+const int       TableSize = int(MaxAttenuation / TableStep) + 1;
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+LoudnessCompensator::LoudnessCompensator(int sampleRate, int channelCount)
+    :   m_filter(channelCount, 2)
+    ,   m_lowShelfTable(TableSize)
+    ,   m_highShelfTable(TableSize)
+    ,   m_volume(1.0)
+    ,   m_targetAttenuation(0.0f)
+    ,   m_currentAttenuation(0.0f)
+    ,   m_attenuationStep(0.0f)
+    ,   m_rampBlocks(0)
+    ,   m_rampBlockCount(qMax(1, (RampDuration * sampleRate / 1000 + BlockFrames - 1) / BlockFrames))
+{
+    Q_ASSERT_X(sampleRate > 0, Q_FUNC_INFO, "Invalid sample rate");
+
+    for (int i = 0; i < TableSize; ++i) {
+        const qreal attenuation = i * TableStep;
+        m_lowShelfTable[i] = ShelfFilter::design(ShelfFilter::LowShelf,
+            LowShelfFrequency, qRound(100.0 * LowShelfSlope * attenuation), sampleRate);
+        m_highShelfTable[i] = ShelfFilter::design(ShelfFilter::HighShelf,
+            HighShelfFrequency, qRound(100.0 * HighShelfSlope * attenuation), sampleRate);
+    }
+
+    reset();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+void LoudnessCompensator::setVolume(qreal volume)
+{
+    m_volume = qBound(qreal(0.0), volume, qreal(1.0));
+
+    const float target = attenuation(m_volume);
+    if (target != m_targetAttenuation) {
+        m_targetAttenuation = target;
+        m_attenuationStep = (target - m_currentAttenuation) / m_rampBlockCount;
+        m_rampBlocks = m_rampBlockCount;
+    }
+}
+
+qreal LoudnessCompensator::volume() const
+{
+    return m_volume;
+}
+
+void LoudnessCompensator::reset()
+{
+    m_currentAttenuation = m_targetAttenuation;
+    m_rampBlocks = 0;
+    updateCoefficients();
+    m_filter.reset();
+}
+
+void LoudnessCompensator::process(qint16 *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+void LoudnessCompensator::process(float *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+const char *LoudnessCompensator::kernelName() const
+{
+    return m_filter.kernelName();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+float LoudnessCompensator::attenuation(qreal volume)
+{
+    if (volume <= 0.0)
+        return MaxAttenuation;
+    return qBound(0.0f, float(-20.0 * log10(volume)), MaxAttenuation);
+}
+
+template<typename Sample>
+void LoudnessCompensator::processBlocks(Sample *samples, int frameCount)
+{
+    const int channelCount = m_filter.channelCount();
+
+    while (frameCount > 0) {
+        const int blockFrames = qMin(frameCount, BlockFrames);
+
+        if (m_rampBlocks) {
+            if (--m_rampBlocks)
+                m_currentAttenuation += m_attenuationStep;
+            else
+                m_currentAttenuation = m_targetAttenuation;
+            updateCoefficients();
+        }
+
+        m_filter.process(samples, blockFrames);
+
+        samples += blockFrames * channelCount;
+        frameCount -= blockFrames;
+    }
+}
+
+/**
+ * Interpolates the coefficients for m_currentAttenuation from the tables.
+ */
+void LoudnessCompensator::updateCoefficients()
+{
+    const float position = m_currentAttenuation / TableStep;
+    const int index = qMin(int(position), TableSize - 2);
+    const float fraction = position - index;
+
+    m_filter.setCoefficients(0, ShelfFilter::interpolate(
+        m_lowShelfTable.at(index), m_lowShelfTable.at(index + 1), fraction));
+    m_filter.setCoefficients(1, ShelfFilter::interpolate(
+        m_highShelfTable.at(index), m_highShelfTable.at(index + 1), fraction));
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,109 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_LOUDNESSCOMPENSATOR_H
+#define PHONON_MMF_LOUDNESSCOMPENSATOR_H
+
+#include <QVector>
+
+#include "audiograph.h"
+#include "shelffilter.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short In-process loudness compensation which follows the volume
+ *
+ * The ear is less sensitive to low and, to a lesser extent, high
+ * frequencies at low listening levels, as described by the equal-loudness
+ * contours of ISO 226.  This processor compensates by boosting a low and
+ * a high shelf by amounts which increase with the attenuation due to the
+ * volume.  Full volume is taken to be the reference level, at which the
+ * response is flat.
+ *
+ * The shelf coefficients are designed on construction for a table of
+ * attenuations, and the coefficients for a given volume are interpolated
+ * from the table, so volume changes do not require any coefficients to be
+ * designed during processing.  Volume changes ramp over RampDuration ms.
+ */
+class LoudnessCompensator : public AudioProcessor
+{
+public:
+    LoudnessCompensator(int sampleRate, int channelCount);
+
+    enum Constants
+    {
+        MaxChannelCount = ShelfFilter::MaxChannelCount,
+        RampDuration = 20 // ms
+    };
+
+    /**
+     * Sets the volume, in the range 0.0 to 1.0, which is compensated for.
+     */
+    void setVolume(qreal volume);
+    qreal volume() const;
+
+    /**
+     * Clears the filter history and completes any ramp in progress.
+     */
+    void reset();
+
+    /**
+     * Filters frameCount frames of interleaved samples in place.
+     */
+    void process(qint16 *samples, int frameCount);
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
+    const char *kernelName() const;
+
+private:
+    static float attenuation(qreal volume);
+    template<typename Sample> void processBlocks(Sample *samples, int frameCount);
+    void updateCoefficients();
+
+private:
+    ShelfFilter                 m_filter;
+
+    // Coefficients of each shelf, indexed by attenuation in steps of
+    // TableStep dB
+    QVector<ShelfFilter::Coefficients> m_lowShelfTable;
+    QVector<ShelfFilter::Coefficients> m_highShelfTable;
+
+    qreal                       m_volume;
+
+    // Attenuations in dB
+    float                       m_targetAttenuation;
+    float                       m_currentAttenuation;
+    float                       m_attenuationStep;
+    int                         m_rampBlocks;
+    const int                   m_rampBlockCount;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -18,9 +18,17 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "audiooutput.h"
 #include "audioplayer.h"
+#include "backend.h"
+#include "contentsniffer.h"
+#include "cuescheduler.h"
 #include "defs.h"
 #include "dummyplayer.h"
+#include "playerpool.h"
+#include "recognizercache.h"
+#include "sessionmanager.h"
+#include "softwareplayer.h"
 #include "utils.h"
+#include "visualization.h"
 #include "utils.h"
 
 #ifdef PHONON_MMF_VIDEO_SURFACES
@@ -34,8 +42,10 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "mediaobject.h"
 
 #include <QDir>
+#include <QFileInfo>
 #include <QResource>
 #include <QUrl>
+#include <QtConcurrentRun>
 
 QT_BEGIN_NAMESPACE
 
@@ -50,20 +60,38 @@ using namespace Phonon::MMF;
 // Constructor / destructor
 //-----------------------------------------------------------------------------
 
-MMF::MediaObject::MediaObject(QObject *parent) : MMF::MediaNode::MediaNode(parent)
-                                               , m_recognizerOpened(false)
+MMF::MediaObject::MediaObject(Backend *backend, QObject *parent)
+                                               : MMF::MediaNode::MediaNode(parent)
+                                               , m_backend(backend)
+                                               , m_sessionManager(SessionManager::acquire())
                                                , m_nextSourceSet(false)
                                                , m_file(0)
                                                , m_resource(0)
+                                               , m_nextFile(0)
+                                               , m_nextResource(0)
+                                               , m_standbyMarkReached(false)
+                                               , m_transitionGapTimer(new QTimer(this))
+                                               , m_lastTransitionGap(-1)
+                                               , m_lastSwitchLatency(-1)
+                                               , m_cueScheduler(new CueScheduler(this))
+                                               , m_audioRoute(backend->audioGraph() ? backend->audioGraph()->createRoute() : -1)
+                                               , m_opening(false)
+                                               , m_pendingCommand(NoCommand)
+                                               , m_volume(InitialVolume)
 {
     m_player.reset(new DummyPlayer());
 
+    connect(this, SIGNAL(stateChanged(Phonon::State,Phonon::State)),
+            m_cueScheduler.data(), SLOT(stateChanged(Phonon::State,Phonon::State)));
+    connect(m_cueScheduler.data(), SIGNAL(cueReached(int,qint64)),
+            SIGNAL(cueReached(int,qint64)));
+
+    m_transitionGapTimer->setSingleShot(true);
+    connect(m_transitionGapTimer.data(), SIGNAL(timeout()), SLOT(switchToNext()));
+
     TRACE_CONTEXT(MediaObject::MediaObject, EAudioApi);
     TRACE_ENTRY_0();
 
-    const int err = m_fileServer.Connect();
-    QT_TRAP_THROWING(User::LeaveIfError(err));
-
     Q_UNUSED(parent);
 
     TRACE_EXIT_0();
@@ -74,14 +102,31 @@ MMF::MediaObject::~MediaObject()
     TRACE_CONTEXT(MediaObject::~MediaObject, EAudioApi);
     TRACE_ENTRY_0();
 
+    // Cancel any files which are still being opened, and close the handles
+    // of any which have already been opened.  This must be done before the
+    // session manager is released.
+    m_openGeneration.fetchAndAddOrdered(1);
+    foreach (OpenWatcher *watcher, m_openWatchers) {
+        watcher->waitForFinished();
+        RFile *const file = watcher->result().m_file;
+        if (file)
+            file->Close();
+        delete file;
+    }
+
     delete m_resource;
 
     if (m_file)
         m_file->Close();
     delete m_file;
 
-    m_fileServer.Close();
-    m_recognizer.Close();
+    releaseOutgoingPlayer();
+    discardNextPlayer();
+
+    if (m_backend->audioGraph())
+        m_backend->audioGraph()->destroyRoute(m_audioRoute);
+
+    m_sessionManager->release();
 
     TRACE_EXIT_0();
 }
@@ -91,58 +136,121 @@ MMF::MediaObject::~MediaObject()
 // Recognizer
 //-----------------------------------------------------------------------------
 
-bool MMF::MediaObject::openRecognizer()
+MMF::MediaType MMF::MediaObject::fileMediaType
+(const QString& fileName)
 {
-    TRACE_CONTEXT(MediaObject::openRecognizer, EAudioInternal);
-
-    if (!m_recognizerOpened) {
-        TInt err = m_recognizer.Connect();
-        if (KErrNone != err) {
-            TRACE("RApaLsSession::Connect error %d", err);
-            return false;
-        }
+    TRACE_CONTEXT(MediaObject::fileMediaType, EAudioInternal);
 
-        // This must be called in order to be able to share file handles with
-        // the recognizer server (see fileMediaType function).
-        err = m_fileServer.ShareProtected();
-        if (KErrNone != err) {
-            TRACE("RFs::ShareProtected error %d", err);
-            return false;
-        }
+    MediaType result = MediaTypeUnknown;
 
-        m_recognizerOpened = true;
+    const TInt err = openFileHandle(fileName);
+    if (KErrNone == err) {
+        result = fileMediaType(*m_file, fileName, m_sessionManager,
+                               m_backend->recognizerCache());
+    } else {
+        const QHBufC nativeFileName(QDir::toNativeSeparators(fileName));
+        TRACE("RFile::Open filename %S error %d", nativeFileName.data(), err);
     }
 
-    return true;
+    return result;
 }
 
-MMF::MediaType MMF::MediaObject::fileMediaType
-(const QString& fileName)
+/**
+ * Recognizes an open file.  This does not use any members, so that it can
+ * be called from the thread in which files are opened.
+ */
+MMF::MediaType MMF::MediaObject::fileMediaType(RFile &file, const QString &fileName,
+                                               SessionManager *sessionManager,
+                                               RecognizerCache *cache)
 {
     TRACE_CONTEXT(MediaObject::fileMediaType, EAudioInternal);
 
     MediaType result = MediaTypeUnknown;
 
-    if (openRecognizer()) {
-        TInt err = openFileHandle(fileName);
-        const QHBufC nativeFileName(QDir::toNativeSeparators(fileName));
+    // The round trip to the recognizer is skipped if the file has been
+    // recognized before, or if its header is recognized in-process.
+    const QString key = RecognizerCache::key(fileName, file);
+    if (!cache->find(key, result)) {
+        TBuf8<ContentSniffer::HeaderSize> header;
+        if (KErrNone == file.Read(0, header)) {
+            const QByteArray suffix = QFileInfo(fileName).suffix().toLower().toLatin1();
+            result = ContentSniffer::sniff(header.Ptr(), header.Length(), suffix.constData());
+            cache->insert(key, result);
+        }
+    }
+
+    if (MediaTypeUnknown == result) {
+        TDataRecognitionResult recognizerResult;
+        const TInt err = sessionManager->recognizeData(file, recognizerResult);
         if (KErrNone == err) {
-            TDataRecognitionResult recognizerResult;
-            err = m_recognizer.RecognizeData(*m_file, recognizerResult);
-            if (KErrNone == err) {
-                const TPtrC mimeType = recognizerResult.iDataType.Des();
-                result = Utils::mimeTypeToMediaType(mimeType);
-            } else {
-                TRACE("RApaLsSession::RecognizeData filename %S error %d", nativeFileName.data(), err);
-            }
+            const TPtrC mimeType = recognizerResult.iDataType.Des();
+            result = Utils::mimeTypeToMediaType(mimeType);
+            cache->insert(key, result);
         } else {
-            TRACE("RFile::Open filename %S error %d", nativeFileName.data(), err);
+            const QHBufC nativeFileName(QDir::toNativeSeparators(fileName));
+            TRACE("RApaLsSession::RecognizeData filename %S error %d", nativeFileName.data(), err);
         }
     }
 
     return result;
 }
 
+/**
+ * Returns the path of source if it is a local file, or an empty string
+ * otherwise.
+ */
+QString MMF::MediaObject::localFileName(const MediaSource &source)
+{
+    QString result;
+
+    if (MediaSource::LocalFile == source.type()) {
+        result = source.fileName();
+    } else if (MediaSource::Url == source.type()) {
+        const QUrl url(source.url());
+        if (url.scheme() == QLatin1String("file"))
+            result = url.toLocalFile();
+    }
+
+    return result;
+}
+
+/**
+ * Opens and recognizes a local file.  This is run in a worker thread by
+ * startOpen(), so it does not use any members.  If currentGeneration moves
+ * on from generation, the request has been superseded, and the remaining
+ * steps are skipped.
+ */
+MMF::MediaObject::OpenResult MMF::MediaObject::openLocalFile(SessionManager *sessionManager,
+    RecognizerCache *cache, const QString &fileName, int generation,
+    const QAtomicInt *currentGeneration)
+{
+    TRACE_CONTEXT(MediaObject::openLocalFile, EAudioInternal);
+
+    OpenResult result;
+    result.m_generation = generation;
+    result.m_file = 0;
+    result.m_mediaType = MediaTypeUnknown;
+
+    if (generation != *currentGeneration)
+        return result;
+
+    RFile *const file = new RFile;
+    const TInt err = sessionManager->openFile(*file, fileName);
+    if (KErrNone != err) {
+        const QHBufC nativeFileName(QDir::toNativeSeparators(fileName));
+        TRACE("RFile::Open filename %S error %d", nativeFileName.data(), err);
+        delete file;
+        return result;
+    }
+
+    result.m_file = file;
+
+    if (generation == *currentGeneration)
+        result.m_mediaType = fileMediaType(*file, fileName, sessionManager, cache);
+
+    return result;
+}
+
 int MMF::MediaObject::openFileHandle(const QString &fileName)
 {
     TRACE_CONTEXT(MediaObject::openFileHandle, EAudioInternal);
@@ -153,18 +261,21 @@ int MMF::MediaObject::openFileHandle(const QString &fileName)
     delete m_file;
     m_file = 0;
     m_file = new RFile;
-    TInt err = m_file->Open(m_fileServer, *nativeFileName, EFileRead | EFileShareReadersOrWriters);
+    TInt err = m_sessionManager->openFile(*m_file, fileName);
     return err;
 }
 
-MMF::MediaType MMF::MediaObject::bufferMediaType(const uchar *data, qint64 size)
+MMF::MediaType MMF::MediaObject::bufferMediaType(const uchar *data, qint64 size,
+                                                 const QString &fileName)
 {
     TRACE_CONTEXT(MediaObject::bufferMediaType, EAudioInternal);
-    MediaType result = MediaTypeUnknown;
-    if (openRecognizer()) {
+    const QByteArray suffix = QFileInfo(fileName).suffix().toLower().toLatin1();
+    MediaType result = ContentSniffer::sniff(data, qMin(size, qint64(ContentSniffer::HeaderSize)),
+                                             suffix.constData());
+    if (MediaTypeUnknown == result) {
         TDataRecognitionResult recognizerResult;
         const TPtrC8 des(data, size);
-        const TInt err = m_recognizer.RecognizeData(KNullDesC, recognizerResult);
+        const TInt err = m_sessionManager->recognizeData(des, recognizerResult);
         if (KErrNone == err) {
             const TPtrC mimeType = recognizerResult.iDataType.Des();
             result = Utils::mimeTypeToMediaType(mimeType);
@@ -181,22 +292,36 @@ MMF::MediaType MMF::MediaObject::bufferMediaType(const uchar *data, qint64 size)
 
 void MMF::MediaObject::play()
 {
+    if (m_opening)
+        m_pendingCommand = PlayCommand;
     m_player->play();
+    if (m_outgoingPlayer)
+        m_outgoingPlayer->play();
 }
 
 void MMF::MediaObject::pause()
 {
+    if (m_opening)
+        m_pendingCommand = PauseCommand;
     m_player->pause();
+    if (m_outgoingPlayer)
+        m_outgoingPlayer->pause();
 }
 
 void MMF::MediaObject::stop()
 {
+    m_transitionGapTimer->stop();
+    endCrossfade();
+    m_pendingCommand = NoCommand;
     m_player->stop();
 }
 
 void MMF::MediaObject::seek(qint64 ms)
 {
+    endCrossfade();
     m_player->seek(ms);
+    m_cueScheduler->seek(ms);
+    emit seeked(ms);
 
     if (state() == PausedState or state() == PlayingState) {
         emit tick(currentTime());
@@ -211,6 +336,8 @@ qint32 MMF::MediaObject::tickInterval() const
 void MMF::MediaObject::setTickInterval(qint32 interval)
 {
     m_player->setTickInterval(interval);
+    if (m_nextPlayer)
+        m_nextPlayer->setTickInterval(interval);
 }
 
 bool MMF::MediaObject::hasVideo() const
@@ -260,6 +387,11 @@ void MMF::MediaObject::setSource(const MediaSource &source)
 
 void MMF::MediaObject::switchToSource(const MediaSource &source)
 {
+    TRACE_CONTEXT(MediaObject::switchToSource, EAudioApi);
+
+    QElapsedTimer timer;
+    timer.start();
+
     if (m_file)
         m_file->Close();
     delete m_file;
@@ -268,26 +400,170 @@ void MMF::MediaObject::switchToSource(const MediaSource &source)
     delete m_resource;
     m_resource = 0;
 
-    createPlayer(source);
+    m_transitionGapTimer->stop();
+    releaseOutgoingPlayer();
+    discardNextPlayer();
+    m_standbyMarkReached = false;
+
+    m_cueScheduler->clear();
+
+    // Supersede any request which is still in progress
+    m_openGeneration.fetchAndAddOrdered(1);
+    m_opening = false;
+    m_pendingCommand = NoCommand;
+
     m_source = source;
-    m_player->open();
+
+    // Local files may be on slow media, so they are opened and recognized
+    // in a worker thread.  Other sources are opened synchronously.
+    const QString fileName = localFileName(source);
+    if (!fileName.isEmpty()) {
+        startOpen(fileName);
+    } else {
+        QString errorMessage;
+        const MediaType mediaType = sourceMediaType(source, errorMessage);
+        createPlayer(mediaType, errorMessage);
+        m_player->open();
+    }
+
+    // Time spent in this function, excluding asynchronous loading of the
+    // clip.  This is the part which PlayerPool reduces, by avoiding
+    // construction of a new native player.
+    m_lastSwitchLatency = timer.elapsed();
+    TRACE("switch latency %Ld ms", m_lastSwitchLatency);
+
     emit currentSourceChanged(m_source);
 }
 
-void MMF::MediaObject::createPlayer(const MediaSource &source)
+/**
+ * Installs a placeholder player, which reports LoadingState, and starts
+ * opening fileName in a worker thread.  The real player is created by
+ * fileOpened().
+ */
+void MMF::MediaObject::startOpen(const QString &fileName)
 {
-    TRACE_CONTEXT(MediaObject::createPlayer, EAudioApi);
-    TRACE_ENTRY("state %d source.type %d", state(), source.type());
-    TRACE_ENTRY("source.type %d", source.type());
+    TRACE_CONTEXT(MediaObject::startOpen, EAudioInternal);
+
+    AbstractPlayer *const oldPlayer = m_player.data();
+    const Phonon::State oldState = state();
+    oldPlayer->close();
+
+    // The placeholder holds the parameters (volume, tickInterval etc) which
+    // are set while the file is being opened, and passes them on to the
+    // real player.
+    m_backend->playerPool()->release(setPlayer(new DummyPlayer(oldPlayer)));
+
+    m_opening = true;
+    m_openTimer.start();
+
+    OpenWatcher *const watcher = new OpenWatcher(this);
+    connect(watcher, SIGNAL(finished()), SLOT(fileOpened()));
+    m_openWatchers.append(watcher);
+    watcher->setFuture(QtConcurrent::run(&MediaObject::openLocalFile,
+                                         m_sessionManager,
+                                         m_backend->recognizerCache(),
+                                         fileName,
+                                         int(m_openGeneration),
+                                         &m_openGeneration));
+
+    if (Phonon::LoadingState != oldState) {
+        TRACE("emit stateChanged(%d, %d)", Phonon::LoadingState, oldState);
+        emit stateChanged(Phonon::LoadingState, oldState);
+    }
+}
 
-    MediaType mediaType = MediaTypeUnknown;
+void MMF::MediaObject::fileOpened()
+{
+    TRACE_CONTEXT(MediaObject::fileOpened, EAudioInternal);
+
+    OpenWatcher *const watcher = static_cast<OpenWatcher *>(sender());
+    const OpenResult result = watcher->result();
+    m_openWatchers.removeOne(watcher);
+    watcher->deleteLater();
+
+    if (result.m_generation != int(m_openGeneration)) {
+        TRACE_0("Superseded");
+        if (result.m_file)
+            result.m_file->Close();
+        delete result.m_file;
+        return;
+    }
+
+    TRACE("open latency %Ld ms", m_openTimer.elapsed());
+
+    Q_ASSERT(!m_file);
+    m_file = result.m_file;
+    m_opening = false;
+
+    createPlayer(result.m_mediaType, QString());
+    m_player->open();
+
+    const PendingCommand command = m_pendingCommand;
+    m_pendingCommand = NoCommand;
+    switch (command) {
+    case NoCommand:
+        break;
+    case PlayCommand:
+        play();
+        break;
+    case PauseCommand:
+        pause();
+        break;
+    }
+}
+
+void MMF::MediaObject::createPlayer(MediaType mediaType, QString errorMessage)
+{
+    TRACE_CONTEXT(MediaObject::createPlayer, EAudioApi);
+    TRACE_ENTRY("state %d mediaType %d", state(), mediaType);
 
     AbstractPlayer* oldPlayer = m_player.data();
 
-    const bool oldPlayerHasVideo = oldPlayer->hasVideo();
-    const bool oldPlayerSeekable = oldPlayer->isSeekable();
+    if (oldPlayer)
+        oldPlayer->close();
 
-    QString errorMessage;
+    AbstractPlayer* newPlayer = 0;
+
+    // Construct newPlayer using oldPlayer (if not 0) in order to copy
+    // parameters (volume, prefinishMark, transitionTime) which may have
+    // been set on oldPlayer.
+
+    switch (mediaType) {
+    case MediaTypeUnknown:
+        TRACE_0("Media type could not be determined");
+        newPlayer = new DummyPlayer(oldPlayer);
+        errorMessage = tr("Error opening source: media type could not be determined");
+        break;
+
+    case MediaTypeAudio:
+        newPlayer = createAudioPlayer(oldPlayer);
+        break;
+
+    case MediaTypeVideo:
+#ifdef PHONON_MMF_VIDEO_SURFACES
+        newPlayer = SurfaceVideoPlayer::create(this, oldPlayer);
+#else
+        newPlayer = DsaVideoPlayer::create(this, oldPlayer);
+#endif
+        break;
+    }
+
+    m_backend->playerPool()->release(setPlayer(newPlayer));
+
+    // We need to call setError() after doing the connects, otherwise the
+    // error won't be received.
+    if (!errorMessage.isEmpty()) {
+        Q_ASSERT(m_player);
+        m_player->setError(errorMessage);
+    }
+
+    TRACE_EXIT_0();
+}
+
+MMF::MediaType MMF::MediaObject::sourceMediaType(const MediaSource &source,
+                                                 QString &errorMessage)
+{
+    MediaType mediaType = MediaTypeUnknown;
 
     // Determine media type
     switch (source.type()) {
@@ -325,7 +601,7 @@ void MMF::MediaObject::createPlayer(const MediaSource &source)
                     if (m_resource->isCompressed())
                         errorMessage = tr("Error opening source: resource is compressed");
                     else
-		        mediaType = bufferMediaType(m_resource->data(), m_resource->size());
+		        mediaType = bufferMediaType(m_resource->data(), m_resource->size(), fileName);
 		} else {
                     errorMessage = tr("Error opening source: resource not valid");
                 }
@@ -340,39 +616,24 @@ void MMF::MediaObject::createPlayer(const MediaSource &source)
         break;
     }
 
-    if (oldPlayer)
-        oldPlayer->close();
-
-    AbstractPlayer* newPlayer = 0;
-
-    // Construct newPlayer using oldPlayer (if not 0) in order to copy
-    // parameters (volume, prefinishMark, transitionTime) which may have
-    // been set on oldPlayer.
-
-    switch (mediaType) {
-    case MediaTypeUnknown:
-        TRACE_0("Media type could not be determined");
-        newPlayer = new DummyPlayer(oldPlayer);
-        errorMessage = tr("Error opening source: media type could not be determined");
-        break;
+    return mediaType;
+}
 
-    case MediaTypeAudio:
-        newPlayer = new AudioPlayer(this, oldPlayer);
-        break;
+/**
+ * Makes player the current player, and returns the previous one, which the
+ * caller must delete.
+ */
+AbstractPlayer *MMF::MediaObject::setPlayer(AbstractPlayer *player)
+{
+    AbstractPlayer *const oldPlayer = m_player.take();
 
-    case MediaTypeVideo:
-#ifdef PHONON_MMF_VIDEO_SURFACES
-        newPlayer = SurfaceVideoPlayer::create(this, oldPlayer);
-#else
-        newPlayer = DsaVideoPlayer::create(this, oldPlayer);
-#endif
-        break;
-    }
+    const bool oldPlayerHasVideo = oldPlayer ? oldPlayer->hasVideo() : false;
+    const bool oldPlayerSeekable = oldPlayer ? oldPlayer->isSeekable() : false;
 
     if (oldPlayer)
         emit abstractPlayerChanged(0);
-    m_player.reset(newPlayer);
-    emit abstractPlayerChanged(newPlayer);
+    m_player.reset(player);
+    emit abstractPlayerChanged(player);
 
     if (oldPlayerHasVideo != hasVideo()) {
         emit hasVideoChanged(hasVideo());
@@ -388,24 +649,26 @@ void MMF::MediaObject::createPlayer(const MediaSource &source)
     connect(m_player.data(), SIGNAL(bufferStatus(int)), SIGNAL(bufferStatus(int)));
     connect(m_player.data(), SIGNAL(metaDataChanged(QMultiMap<QString,QString>)), SIGNAL(metaDataChanged(QMultiMap<QString,QString>)));
     connect(m_player.data(), SIGNAL(aboutToFinish()), SIGNAL(aboutToFinish()));
+    connect(m_player.data(), SIGNAL(aboutToFinish()), SLOT(handleStandbyMarkReached()));
+    connect(m_player.data(), SIGNAL(standbyMarkReached()), SLOT(handleStandbyMarkReached()));
+    connect(m_player.data(), SIGNAL(transitionMarkReached()), SLOT(handleTransitionMarkReached()));
     connect(m_player.data(), SIGNAL(prefinishMarkReached(qint32)), SIGNAL(prefinishMarkReached(qint32)));
     connect(m_player.data(), SIGNAL(prefinishMarkReached(qint32)), SLOT(handlePrefinishMarkReached(qint32)));
     connect(m_player.data(), SIGNAL(tick(qint64)), SIGNAL(tick(qint64)));
+    connect(m_player.data(), SIGNAL(stateChanged(Phonon::State,Phonon::State)), SLOT(handleStateChanged(Phonon::State,Phonon::State)));
 
-    // We need to call setError() after doing the connects, otherwise the
-    // error won't be received.
-    if (!errorMessage.isEmpty()) {
-        Q_ASSERT(m_player);
-        m_player->setError(errorMessage);
-    }
-
-    TRACE_EXIT_0();
+    return oldPlayer;
 }
 
 void MMF::MediaObject::setNextSource(const MediaSource &source)
 {
     m_nextSource = source;
     m_nextSourceSet = true;
+
+    // If the source is queued after the standby mark was reached, the
+    // standby player is prepared straight away.
+    if (m_standbyMarkReached)
+        prepareNextPlayer();
 }
 
 qint32 MMF::MediaObject::prefinishMark() const
@@ -416,6 +679,8 @@ qint32 MMF::MediaObject::prefinishMark() const
 void MMF::MediaObject::setPrefinishMark(qint32 mark)
 {
     m_player->setPrefinishMark(mark);
+    if (m_nextPlayer)
+        m_nextPlayer->setPrefinishMark(mark);
 }
 
 qint32 MMF::MediaObject::transitionTime() const
@@ -426,11 +691,39 @@ qint32 MMF::MediaObject::transitionTime() const
 void MMF::MediaObject::setTransitionTime(qint32 time)
 {
     m_player->setTransitionTime(time);
+    if (m_nextPlayer)
+        m_nextPlayer->setTransitionTime(time);
+}
+
+void MMF::MediaObject::addCuePoint(int id, qint64 position)
+{
+    m_cueScheduler->addCuePoint(id, position);
+}
+
+void MMF::MediaObject::removeCuePoint(int id)
+{
+    m_cueScheduler->removeCuePoint(id);
+}
+
+void MMF::MediaObject::clearCuePoints()
+{
+    m_cueScheduler->clear();
 }
 
 void MMF::MediaObject::volumeChanged(qreal volume)
 {
+    m_volume = volume;
     m_player->volumeChanged(volume);
+    if (m_nextPlayer)
+        m_nextPlayer->volumeChanged(volume);
+    if (m_outgoingPlayer)
+        m_outgoingPlayer->volumeChanged(volume);
+    emit outputVolumeChanged(volume);
+}
+
+qreal MMF::MediaObject::volume() const
+{
+    return m_volume;
 }
 
 RFile* MMF::MediaObject::file() const
@@ -477,6 +770,71 @@ AbstractPlayer *MMF::MediaObject::abstractPlayer() const
     return m_player.data();
 }
 
+Backend *MMF::MediaObject::backend() const
+{
+    return m_backend;
+}
+
+int MMF::MediaObject::audioRoute() const
+{
+    return m_audioRoute;
+}
+
+void MMF::MediaObject::updateAudioRoute()
+{
+    AudioGraph *const graph = m_backend->audioGraph();
+    if (!graph)
+        return;
+
+    TRACE_CONTEXT(MediaObject::updateAudioRoute, EAudioInternal);
+    TRACE_ENTRY_0();
+
+    QList<AudioGraph::Stage> stages;
+    foreach (MediaNode *node, outputs())
+        appendAudioStages(node, -1, stages);
+
+    graph->setStages(m_audioRoute, stages);
+
+    TRACE_EXIT("stages %d", stages.count());
+}
+
+/**
+ * Appends the stages for node and the nodes downstream of it, in
+ * depth-first order, so that a node which feeds several others is
+ * rendered once.  Subtrees which contain no AudioOutput or Visualization
+ * are not rendered, and nothing is appended for them.  Returns true if
+ * anything was appended.
+ */
+bool MMF::MediaObject::appendAudioStages(MediaNode *node, int parent,
+                                         QList<AudioGraph::Stage> &stages)
+{
+    if (qobject_cast<AudioOutput *>(node)) {
+        stages.append(AudioGraph::Stage(0, parent, true));
+        return true;
+    }
+
+    if (Visualization *const visualization = qobject_cast<Visualization *>(node)) {
+        stages.append(AudioGraph::Stage(visualization, parent, false));
+        return true;
+    }
+
+    // Nodes which do not process audio pass it through
+    const int count = stages.count();
+    int index = parent;
+    if (AudioProcessor *const processor = node->audioProcessor()) {
+        stages.append(AudioGraph::Stage(processor, parent, false));
+        index = count;
+    }
+
+    bool appended = false;
+    foreach (MediaNode *output, node->outputs())
+        appended |= appendAudioStages(output, index, stages);
+
+    if (!appended)
+        stages.erase(stages.begin() + count, stages.end());
+    return appended;
+}
+
 //-----------------------------------------------------------------------------
 // Playlist support
 //-----------------------------------------------------------------------------
@@ -492,6 +850,175 @@ void MMF::MediaObject::switchToNextSource()
     }
 }
 
+void MMF::MediaObject::handlePlaybackComplete(AbstractPlayer *player)
+{
+    if (player == m_outgoingPlayer.data()) {
+        // The outgoing clip of a crossfade has finished
+        releaseOutgoingPlayer();
+        return;
+    }
+
+    if (m_nextSourceSet) {
+        m_transitionTimer.start();
+
+        // Phonon defines a negative transition time as a gap between the
+        // two sources.
+        if (transitionTime() < 0) {
+            m_transitionGapTimer->start(-transitionTime());
+            return;
+        }
+    }
+
+    switchToNext();
+}
+
+void MMF::MediaObject::switchToNext()
+{
+    if (m_nextPlayer) {
+        // This may be called from within the current player's end of
+        // playback handler, so the player must not be deleted synchronously.
+        // PlayerPool::release() guarantees this.
+        m_backend->playerPool()->release(switchToNextPlayer());
+    } else {
+        // MediaObject::switchToNextSource deletes the current player, so we
+        // call it via delayed slot invokation to ensure that the player does
+        // not get deleted during execution of one of its member functions.
+        QMetaObject::invokeMethod(this, "switchToNextSource", Qt::QueuedConnection);
+    }
+}
+
+qint64 MMF::MediaObject::lastTransitionGap() const
+{
+    return m_lastTransitionGap;
+}
+
+qint64 MMF::MediaObject::lastSwitchLatency() const
+{
+    return m_lastSwitchLatency;
+}
+
+void MMF::MediaObject::prepareNextPlayer()
+{
+    TRACE_CONTEXT(MediaObject::prepareNextPlayer, EAudioApi);
+    TRACE_ENTRY("state %d source.type %d", state(), m_nextSource.type());
+
+    discardNextPlayer();
+
+    // Media type recognition and AbstractMediaPlayer::open() operate on
+    // m_source, m_file and m_resource, so the next source is swapped in
+    // while the standby player is being opened.
+    qSwap(m_source, m_nextSource);
+    qSwap(m_file, m_nextFile);
+    qSwap(m_resource, m_nextResource);
+
+    QString errorMessage;
+    const MediaType mediaType = sourceMediaType(m_source, errorMessage);
+
+    // Only audio clips are prepared in advance.  Video players need a
+    // video output, which is owned by the current player until the switch,
+    // so video sources are opened by switchToNextSource() as before.
+    if (MediaTypeAudio == mediaType) {
+        m_nextPlayer.reset(createAudioPlayer(m_player.data()));
+        m_nextPlayer->open();
+    }
+
+    qSwap(m_source, m_nextSource);
+    qSwap(m_file, m_nextFile);
+    qSwap(m_resource, m_nextResource);
+
+    if (!m_nextPlayer)
+        discardNextPlayer();
+
+    TRACE_EXIT("prepared %d", !m_nextPlayer.isNull());
+}
+
+AbstractPlayer *MMF::MediaObject::createAudioPlayer(const AbstractPlayer *player)
+{
+    // Sources which cannot be decoded in process are played natively, so
+    // that enabling in-process rendering does not break playback.
+    AudioGraph *const graph = m_backend->audioGraph();
+    if (graph && SoftwarePlayer::canPlay(m_file, m_resource, graph->sampleRate()))
+        return new SoftwarePlayer(this, player);
+    return m_backend->playerPool()->createAudioPlayer(this, player);
+}
+
+void MMF::MediaObject::discardNextPlayer()
+{
+    m_backend->playerPool()->release(m_nextPlayer.take());
+
+    if (m_nextFile)
+        m_nextFile->Close();
+    delete m_nextFile;
+    m_nextFile = 0;
+
+    delete m_nextResource;
+    m_nextResource = 0;
+}
+
+/**
+ * Makes the standby player current and starts it.  Returns the previous
+ * player, which is disconnected from this object, and which the caller must
+ * delete.
+ */
+AbstractPlayer *MMF::MediaObject::switchToNextPlayer()
+{
+    TRACE_CONTEXT(MediaObject::switchToNextPlayer, EAudioApi);
+    TRACE_ENTRY("state %d next state %d", state(), m_nextPlayer->state());
+
+    m_nextSourceSet = false;
+    m_standbyMarkReached = false;
+
+    if (m_file)
+        m_file->Close();
+    delete m_file;
+    m_file = m_nextFile;
+    m_nextFile = 0;
+
+    delete m_resource;
+    m_resource = m_nextResource;
+    m_nextResource = 0;
+
+    m_source = m_nextSource;
+
+    m_cueScheduler->clear();
+
+    AbstractPlayer *const oldPlayer = setPlayer(m_nextPlayer.take());
+    oldPlayer->disconnect(this);
+
+    // Signals which the standby player emitted while loading were not
+    // connected, so the client is brought up to date here.
+    if (Phonon::LoadingState != state()) {
+        emit totalTimeChanged(totalTime());
+        if (AbstractMediaPlayer *player = qobject_cast<AbstractMediaPlayer *>(m_player.data()))
+            emit metaDataChanged(player->metaData());
+    }
+
+    emit currentSourceChanged(m_source);
+    play();
+
+    TRACE_EXIT_0();
+    return oldPlayer;
+}
+
+void MMF::MediaObject::endCrossfade()
+{
+    if (m_outgoingPlayer) {
+        releaseOutgoingPlayer();
+        if (AbstractMediaPlayer *player = qobject_cast<AbstractMediaPlayer *>(m_player.data()))
+            player->setFadeLevel(1.0);
+    }
+}
+
+void MMF::MediaObject::releaseOutgoingPlayer()
+{
+    if (m_outgoingPlayer) {
+        // Effects which are still applied to the outgoing player are
+        // deleted before the player is reused.
+        emit outgoingPlayerReleased();
+        m_backend->playerPool()->release(m_outgoingPlayer.take());
+    }
+}
+
 //-----------------------------------------------------------------------------
 // Other private functions
 //-----------------------------------------------------------------------------
@@ -501,6 +1028,65 @@ void MMF::MediaObject::handlePrefinishMarkReached(qint32 time)
     emit tick(time);
 }
 
+void MMF::MediaObject::handleStandbyMarkReached()
+{
+    // aboutToFinish() also counts as the standby mark, in case the clip
+    // ended before the standby mark could be scheduled.
+    if (m_standbyMarkReached)
+        return;
+
+    // A source which was queued in advance is opened now, so that it is
+    // ready by the time the current source completes.  Sources queued
+    // later, for example by receivers of aboutToFinish(), are opened by
+    // setNextSource().
+    m_standbyMarkReached = true;
+    if (m_nextSourceSet)
+        prepareNextPlayer();
+}
+
+void MMF::MediaObject::handleTransitionMarkReached()
+{
+    TRACE_CONTEXT(MediaObject::handleTransitionMarkReached, EAudioApi);
+
+    AbstractMediaPlayer *const current = qobject_cast<AbstractMediaPlayer *>(m_player.data());
+    AbstractMediaPlayer *const next = qobject_cast<AbstractMediaPlayer *>(m_nextPlayer.data());
+
+    // If the standby player has not finished loading, there is no
+    // crossfade, and the next source starts when the current one completes.
+    if (current && next
+        && Phonon::PlayingState == current->state()
+        && Phonon::StoppedState == next->state()) {
+        const qint64 duration = qMax(qint64(0), totalTime() - currentTime());
+        TRACE("crossfade %Ld ms", duration);
+
+        m_transitionTimer.start();
+
+        // Both ramps follow the clocks of their respective players, and
+        // are serviced by the same TickScheduler wakeups.
+        next->fade(0.0, 1.0, duration);
+        current->fade(1.0, 0.0, duration);
+
+        releaseOutgoingPlayer();
+        emit crossfadeStarted();
+        m_outgoingPlayer.reset(switchToNextPlayer());
+    }
+}
+
+void MMF::MediaObject::handleStateChanged(Phonon::State newState,
+                                          Phonon::State oldState)
+{
+    TRACE_CONTEXT(MediaObject::handleStateChanged, EAudioInternal);
+    Q_UNUSED(oldState)
+
+    if (Phonon::PlayingState == newState && m_transitionTimer.isValid()) {
+        m_lastTransitionGap = m_transitionTimer.elapsed();
+        m_transitionTimer.invalidate();
+        TRACE("transition gap %Ld ms", m_lastTransitionGap);
+    } else if (Phonon::ErrorState == newState) {
+        m_transitionTimer.invalidate();
+    }
+}
+
 
 QT_END_NAMESPACE
 
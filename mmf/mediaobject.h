@@ -21,16 +21,20 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <phonon/mediasource.h>
 #include <phonon/mediaobjectinterface.h>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QList>
 #include <QScopedPointer>
 #include <QTimer>
 
-// For recognizer
-#include <apgcli.h>
-
 #include "abstractplayer.h"
+#include "audiograph.h"
 #include "mmf_medianode.h"
 #include "defs.h"
 
+class RFile;
+
 QT_BEGIN_NAMESPACE
 
 class QResource;
@@ -41,6 +45,10 @@ namespace MMF
 {
 class AbstractPlayer;
 class AbstractVideoOutput;
+class Backend;
+class CueScheduler;
+class RecognizerCache;
+class SessionManager;
 
 /**
  * @short Facade class which wraps MMF client utility instance
@@ -52,7 +60,7 @@ class MediaObject : public MediaNode
     Q_INTERFACES(Phonon::MediaObjectInterface)
 
 public:
-    MediaObject(QObject *parent);
+    MediaObject(Backend *backend, QObject *parent);
     virtual ~MediaObject();
 
     // MediaObjectInterface
@@ -89,16 +97,84 @@ public:
 
     void setVideoOutput(AbstractVideoOutput* videoOutput);
 
+    Backend *backend() const;
+
     int openFileHandle(const QString &fileName);
     RFile* file() const;
     QResource* resource() const;
 
+    /**
+     * Called by a player when playback of its source completes
+     * successfully.  If a standby player has been prepared for the next
+     * source, it is swapped in and started immediately; otherwise the
+     * next source is opened via switchToNextSource().  A negative
+     * transitionTime() delays the switch by that many milliseconds.
+     */
+    void handlePlaybackComplete(AbstractPlayer *player);
+
+    /**
+     * Duration of the silence between the end of the previous source and
+     * the start of playback of the current one, measured at the most
+     * recent transition between queued sources.  Returns -1 if no such
+     * transition has occurred.
+     */
+    Q_INVOKABLE qint64 lastTransitionGap() const;
+
+    /**
+     * Time taken to create the player for the current source, when it was
+     * set by setSource() or was queued without a standby player being
+     * prepared.  Asynchronous loading of the clip is excluded.
+     * Comparing this with the Backend's playerPoolSize property set to
+     * zero shows the saving made by pooling.  Returns -1 if no source has
+     * been set.
+     */
+    Q_INVOKABLE qint64 lastSwitchLatency() const;
+
+    /**
+     * Identifier of the route via which this object's players render, if
+     * in-process rendering is enabled.  Otherwise returns -1.
+     */
+    int audioRoute() const;
+
+    /**
+     * Rebuilds the stages of the route from the nodes connected to this
+     * object.  Called by the Backend when connections change.
+     */
+    void updateAudioRoute();
+
+    /**
+     * Volume most recently set by the connected AudioOutput.
+     */
+    qreal volume() const;
+
 public Q_SLOTS:
+    /**
+     * Cue points apply to the current source, and are cleared when the
+     * source changes.  cueReached() is emitted when playback reaches
+     * a cue point.  Several cue points may share an ID.
+     *
+     * These are slots, since clients only reach this object through its
+     * metaobject, e.g. via QMetaObject::invokeMethod().
+     */
+    void addCuePoint(int id, qint64 position);
+    void removeCuePoint(int id);
+    void clearCuePoints();
+
     void volumeChanged(qreal volume);
     void switchToNextSource();
 
 Q_SIGNALS:
     void abstractPlayerChanged(AbstractPlayer *player);
+
+    /**
+     * Emitted when a crossfade starts, before abstractPlayerChanged().
+     * The current player becomes the outgoing player, which plays on
+     * until outgoingPlayerReleased() is emitted.  That is emitted before
+     * the player is released to the PlayerPool.
+     */
+    void crossfadeStarted();
+    void outgoingPlayerReleased();
+
     void totalTimeChanged(qint64 length);
     void hasVideoChanged(bool hasVideo);
     void seekableChanged(bool seekable);
@@ -112,28 +188,78 @@ Q_SIGNALS:
                       Phonon::State oldState);
     void finished();
     void tick(qint64 time);
+    void cueReached(int id, qint64 position);
+
+    /**
+     * Emitted when the playback position jumps as a result of seek().
+     */
+    void seeked(qint64 position);
+
+    /**
+     * Emitted when the volume of the connected AudioOutput changes.
+     */
+    void outputVolumeChanged(qreal volume);
 
 private Q_SLOTS:
     void handlePrefinishMarkReached(qint32);
+    void handleStandbyMarkReached();
+    void handleTransitionMarkReached();
+    void handleStateChanged(Phonon::State newState,
+                            Phonon::State oldState);
+    void switchToNext();
+    void fileOpened();
 
 private:
+    struct OpenResult
+    {
+        int         m_generation;
+        RFile*      m_file;
+        MediaType   m_mediaType;
+    };
+
+    typedef QFutureWatcher<OpenResult> OpenWatcher;
+
+    enum PendingCommand {
+        NoCommand,
+        PlayCommand,
+        PauseCommand
+    };
+
     void switchToSource(const MediaSource &source);
-    void createPlayer(const MediaSource &source);
-    bool openRecognizer();
+    void startOpen(const QString &fileName);
+    void createPlayer(MediaType mediaType, QString errorMessage);
+    AbstractPlayer *createAudioPlayer(const AbstractPlayer *player);
+    MediaType sourceMediaType(const MediaSource &source, QString &errorMessage);
+    AbstractPlayer *setPlayer(AbstractPlayer *player);
+    void prepareNextPlayer();
+    void discardNextPlayer();
+    AbstractPlayer *switchToNextPlayer();
+    void endCrossfade();
+    void releaseOutgoingPlayer();
+    static bool appendAudioStages(MediaNode *node, int parent,
+                                  QList<AudioGraph::Stage> &stages);
 
     // Audio / video media type recognition
     MediaType fileMediaType(const QString& fileName);
-    MediaType bufferMediaType(const uchar *data, qint64 size);
+    static MediaType fileMediaType(RFile &file, const QString &fileName,
+                                   SessionManager *sessionManager,
+                                   RecognizerCache *cache);
+    static QString localFileName(const MediaSource &source);
+    static OpenResult openLocalFile(SessionManager *sessionManager,
+                                    RecognizerCache *cache,
+                                    const QString &fileName, int generation,
+                                    const QAtomicInt *currentGeneration);
+    MediaType bufferMediaType(const uchar *data, qint64 size, const QString &fileName);
     // TODO: urlMediaType function
 
     static qint64 toMilliSeconds(const TTimeIntervalMicroSeconds &);
 
 private:
+    // Not owned
+    Backend *const                      m_backend;
 
-    // Audio / video media type recognition
-    bool                                m_recognizerOpened;
-    RApaLsSession                       m_recognizer;
-    RFs                                 m_fileServer;
+    // Shared file server and recognizer sessions
+    SessionManager *const               m_sessionManager;
 
     MediaSource                         m_source;
     MediaSource                         m_nextSource;
@@ -144,6 +270,45 @@ private:
 
     QScopedPointer<AbstractPlayer>      m_player;
 
+    // Standby player, which is prepared for m_nextSource once the current
+    // player has reached its standby mark, so that the next source can
+    // start as soon as the current one completes.
+    QScopedPointer<AbstractPlayer>      m_nextPlayer;
+    RFile*                              m_nextFile;
+    QResource*                          m_nextResource;
+    bool                                m_standbyMarkReached;
+
+    // During a crossfade, the player for the previous source, which plays
+    // on until the end of its clip while its volume ramps down
+    QScopedPointer<AbstractPlayer>      m_outgoingPlayer;
+
+    // Delays the switch to the next source if transitionTime() is negative
+    QScopedPointer<QTimer>              m_transitionGapTimer;
+
+    // Measures the gap between the end of one source and the start of
+    // playback of the next
+    QElapsedTimer                       m_transitionTimer;
+    qint64                              m_lastTransitionGap;
+
+    // Duration of the most recent switchToSource() call
+    qint64                              m_lastSwitchLatency;
+
+    QScopedPointer<CueScheduler>        m_cueScheduler;
+
+    // Route in the Backend's AudioGraph, or -1
+    const int                           m_audioRoute;
+
+    // Local files are opened and recognized by openLocalFile() in a worker
+    // thread.  Each call to switchToSource() increments the generation, so
+    // that results of superseded requests are discarded.
+    QAtomicInt                          m_openGeneration;
+    QList<OpenWatcher *>                m_openWatchers;
+    bool                                m_opening;
+    PendingCommand                      m_pendingCommand;
+    QElapsedTimer                       m_openTimer;
+
+    qreal                               m_volume;
+
 };
 }
 }
@@ -0,0 +1,117 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QScopedPointer>
+
+#include <apmrec.h> // for CDataTypeArray
+
+#include "mimetypecache.h"
+#include "sessionmanager.h"
+#include "utils.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::MimeTypeCache
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::MimeTypeCache::MimeTypeCache()
+    :   m_sessionManager(SessionManager::acquire())
+    ,   m_notifier(0)
+    ,   m_valid(false)
+{
+
+}
+
+MMF::MimeTypeCache::~MimeTypeCache()
+{
+    delete m_notifier;
+    m_sessionManager->release();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+QStringList MMF::MimeTypeCache::mimeTypes()
+{
+    if (!m_valid)
+        update();
+    return m_mimeTypes;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::MimeTypeCache::update()
+{
+    TRACE_CONTEXT(MimeTypeCache::update, EAudioInternal);
+
+    m_mimeTypes.clear();
+
+    // CBase::operator new returns null, rather than leaving, if there is
+    // insufficient memory.
+    static const TInt DataTypeArrayGranularity = 8;
+    QScopedPointer<CDataTypeArray> array(new CDataTypeArray(DataTypeArrayGranularity));
+    const TInt err = array ? m_sessionManager->getSupportedDataTypes(*array)
+                           : KErrNoMemory;
+
+    if (KErrNone == err) {
+        for (TInt i = 0; i < array->Count(); ++i) {
+            const TPtrC mimeType = array->At(i).Des();
+            const MediaType mediaType = Utils::mimeTypeToMediaType(mimeType);
+            if (MediaTypeAudio == mediaType or MediaTypeVideo == mediaType)
+                m_mimeTypes.append(qt_TDesC2QString(mimeType));
+        }
+
+        m_mimeTypes.sort();
+
+        // The notifier is created once the list has been built, because
+        // there is nothing to invalidate before then.  If it cannot be
+        // created, the list is not cached.
+        if (!m_notifier)
+            TRAP_IGNORE(m_notifier = CApaAppListNotifier::NewL(this, CActive::EPriorityLow));
+        m_valid = m_notifier;
+    } else {
+        TRACE("error %d", err);
+    }
+
+    TRACE("%d MIME types", m_mimeTypes.count());
+}
+
+void MMF::MimeTypeCache::HandleAppListEvent(TInt aEvent)
+{
+    TRACE_CONTEXT(MimeTypeCache::HandleAppListEvent, EAudioInternal);
+    TRACE("event %d", aEvent);
+
+    if (MApaAppListServObserver::EAppListChanged == aEvent)
+        m_valid = false;
+}
+
+QT_END_NAMESPACE
+
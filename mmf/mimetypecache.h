@@ -0,0 +1,79 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_MIMETYPECACHE_H
+#define PHONON_MMF_MIMETYPECACHE_H
+
+#include <QStringList>
+
+#include <apgnotif.h> // for MApaAppListServObserver
+
+class CApaAppListNotifier;
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+class SessionManager;
+
+/**
+ * @short Caches the list of MIME types which can be played
+ *
+ * Querying the supported data types requires a round trip to the AppArc
+ * server, and the result must then be filtered and sorted.  The list is
+ * built when it is first requested, and kept until the set of installed
+ * applications and plugins changes, at which point it is built again on
+ * the next request.
+ *
+ * The cache is owned by the Backend.
+ */
+class MimeTypeCache : public MApaAppListServObserver
+{
+public:
+    MimeTypeCache();
+    ~MimeTypeCache();
+
+    /**
+     * Returns the supported MIME types, sorted, as reported by AppArc.
+     */
+    QStringList mimeTypes();
+
+private:
+    void update();
+
+    // MApaAppListServObserver
+    virtual void HandleAppListEvent(TInt aEvent);
+
+private:
+    SessionManager *const       m_sessionManager;
+
+    // Notifies changes to the set of installed applications and plugins
+    CApaAppListNotifier         *m_notifier;
+
+    bool                        m_valid;
+    QStringList                 m_mimeTypes;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
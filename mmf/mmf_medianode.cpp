@@ -96,6 +96,21 @@ bool MMF::MediaNode::disconnectOutput(MediaNode *output)
     return disconnected;
 }
 
+MediaObject *MMF::MediaNode::mediaObject() const
+{
+    return m_mediaObject;
+}
+
+QList<MMF::MediaNode *> MMF::MediaNode::outputs() const
+{
+    return m_outputs;
+}
+
+MMF::AudioProcessor *MMF::MediaNode::audioProcessor()
+{
+    return 0;
+}
+
 bool MMF::MediaNode::isMediaObject() const
 {
     return (qobject_cast<const MediaObject *>(this) != 0);
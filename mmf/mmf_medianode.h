@@ -38,6 +38,7 @@ namespace Phonon
 {
 namespace MMF
 {
+class AudioProcessor;
 class MediaObject;
 
 /**
@@ -58,6 +59,8 @@ class MediaObject;
  * - VideoWidget
  *      A native widget on which video will be rendered.
  * - An audio effect, derived form AbstractAudioEffect
+ * - VolumeFader
+ * - Visualization
  *
  * Because the MMF API does not support the concept of a media filter graph,
  * this class must ensure the following:
@@ -80,6 +83,23 @@ public:
     virtual void connectMediaObject(MediaObject *mediaObject) = 0;
     virtual void disconnectMediaObject(MediaObject *mediaObject) = 0;
 
+    /**
+     * The MediaObject in this node's graph, if any.
+     */
+    MediaObject *mediaObject() const;
+
+    /**
+     * Nodes to which this node is connected, in the order in which the
+     * connections were made.
+     */
+    QList<MediaNode *> outputs() const;
+
+    /**
+     * The stage which this node contributes to in-process rendering, if
+     * any.  The default implementation returns null.
+     */
+    virtual AudioProcessor *audioProcessor();
+
 private:
     bool isMediaObject() const;
 
@@ -0,0 +1,232 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "outputstreamsink.h"
+#include "utils.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::OutputStreamSink
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// At least this many buffers are queued, so that one can be refilled while
+// another is being played.
+const int       MinBufferCount = 2;
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+OutputStreamSink::OutputStreamSink(AudioGraph *graph, int latency)
+    :   m_graph(graph)
+    ,   m_state(Closed)
+    ,   m_bufferCount(qMax(MinBufferCount, int(qint64(latency) * graph->sampleRate()
+                           / (1000 * graph->blockFrames()))))
+    ,   m_bufferSize(graph->blockFrames() * graph->channelCount())
+    ,   m_buffers(m_bufferCount * m_bufferSize)
+    ,   m_descriptors(m_bufferCount)
+    ,   m_nextBuffer(0)
+    ,   m_queuedBuffers(0)
+    ,   m_writeError(KErrNone)
+{
+    TRACE_CONTEXT(OutputStreamSink::OutputStreamSink, EAudioInternal);
+    TRACE_ENTRY("buffers %d", m_bufferCount);
+
+    TRAPD(err, m_stream.reset(CMdaAudioOutputStream::NewL(*this)));
+    if (KErrNone != err)
+        TRACE("NewL error %d", err);
+
+    TRACE_EXIT_0();
+}
+
+OutputStreamSink::~OutputStreamSink()
+{
+    close();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+void OutputStreamSink::start(AudioGraph *graph)
+{
+    Q_ASSERT_X(graph == m_graph, Q_FUNC_INFO, "Sink belongs to another graph");
+    Q_UNUSED(graph)
+
+    if (Closed == m_state && m_stream) {
+        m_settings.Query();
+        m_stream->Open(&m_settings);
+        m_state = Opening;
+    } else if (Open == m_state) {
+        fill();
+    }
+}
+
+void OutputStreamSink::writeAudio(const float *samples, int frameCount)
+{
+    Q_ASSERT_X(frameCount == m_graph->blockFrames(), Q_FUNC_INFO, "Invalid block size");
+
+    qint16 *const buffer = m_buffers.data() + m_nextBuffer * m_bufferSize;
+    const int sampleCount = frameCount * m_graph->channelCount();
+    for (int i = 0; i < sampleCount; ++i)
+        buffer[i] = qBound(-32768, qRound(samples[i] * 32768.0f), 32767);
+
+    // Buffers are returned by MaoscBufferCopied() in the order in which
+    // they are written, so they are used in rotation.
+    TPtrC8 &descriptor = m_descriptors[m_nextBuffer];
+    descriptor.Set(reinterpret_cast<const TUint8 *>(buffer), sampleCount * sizeof(qint16));
+
+    TRAPD(err, m_stream->WriteL(descriptor));
+    if (KErrNone == err) {
+        m_nextBuffer = (m_nextBuffer + 1) % m_bufferCount;
+        ++m_queuedBuffers;
+    } else {
+        m_writeError = err;
+    }
+}
+
+bool OutputStreamSink::isSampleRateSupported(int sampleRate)
+{
+    return sampleRateCapability(sampleRate) >= 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// MMdaAudioOutputStreamCallback
+//-----------------------------------------------------------------------------
+
+void OutputStreamSink::MaoscOpenComplete(TInt aError)
+{
+    TRACE_CONTEXT(OutputStreamSink::MaoscOpenComplete, EAudioInternal);
+    TRACE_ENTRY("err %d", aError);
+
+    if (KErrNone == aError) {
+        const TInt channels = 1 == m_graph->channelCount()
+            ? TMdaAudioDataSettings::EChannelsMono
+            : TMdaAudioDataSettings::EChannelsStereo;
+        TRAP(aError, m_stream->SetAudioPropertiesL(
+            sampleRateCapability(m_graph->sampleRate()), channels));
+    }
+
+    if (KErrNone == aError) {
+        m_state = Open;
+        fill();
+    } else {
+        close();
+    }
+
+    TRACE_EXIT_0();
+}
+
+void OutputStreamSink::MaoscBufferCopied(TInt aError, const TDesC8 &/*aBuffer*/)
+{
+    // Buffers aborted by close() have already been discounted
+    if (Closed == m_state)
+        return;
+
+    --m_queuedBuffers;
+    if (KErrNone == aError)
+        fill();
+}
+
+void OutputStreamSink::MaoscPlayComplete(TInt aError)
+{
+    TRACE_CONTEXT(OutputStreamSink::MaoscPlayComplete, EAudioInternal);
+    TRACE_ENTRY("err %d", aError);
+
+    close();
+
+    // KErrUnderflow indicates that the queue drained, either because no
+    // source is playing or because rendering did not keep up.  Only in the
+    // latter case is the stream reopened; otherwise it remains closed
+    // until a source starts playing.
+    if (KErrUnderflow == aError && m_graph->isPlaying())
+        start(m_graph);
+
+    TRACE_EXIT_0();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+/**
+ * Renders blocks until the queue is full, or no source is playing.
+ */
+void OutputStreamSink::fill()
+{
+    TRACE_CONTEXT(OutputStreamSink::fill, EAudioInternal);
+
+    while (Open == m_state && m_queuedBuffers < m_bufferCount) {
+        m_writeError = KErrNone;
+        if (!m_graph->renderBlock())
+            break;
+
+        // A block which could not be written does not join the queue, so
+        // filling would otherwise continue until the sources were
+        // exhausted.  The stream is reopened when a source next starts.
+        if (KErrNone != m_writeError) {
+            TRACE("WriteL error %d", m_writeError);
+            close();
+        }
+    }
+}
+
+void OutputStreamSink::close()
+{
+    const State state = m_state;
+
+    // Stop() completes the outstanding buffers via the callbacks, so the
+    // state is updated first.
+    m_state = Closed;
+    m_nextBuffer = 0;
+    m_queuedBuffers = 0;
+
+    if (m_stream && Closed != state)
+        m_stream->Stop();
+}
+
+TInt OutputStreamSink::sampleRateCapability(int sampleRate)
+{
+    switch (sampleRate) {
+    case 8000:  return TMdaAudioDataSettings::ESampleRate8000Hz;
+    case 11025: return TMdaAudioDataSettings::ESampleRate11025Hz;
+    case 12000: return TMdaAudioDataSettings::ESampleRate12000Hz;
+    case 16000: return TMdaAudioDataSettings::ESampleRate16000Hz;
+    case 22050: return TMdaAudioDataSettings::ESampleRate22050Hz;
+    case 24000: return TMdaAudioDataSettings::ESampleRate24000Hz;
+    case 32000: return TMdaAudioDataSettings::ESampleRate32000Hz;
+    case 44100: return TMdaAudioDataSettings::ESampleRate44100Hz;
+    case 48000: return TMdaAudioDataSettings::ESampleRate48000Hz;
+    default:    return KErrNotSupported;
+    }
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,109 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_OUTPUTSTREAMSINK_H
+#define PHONON_MMF_OUTPUTSTREAMSINK_H
+
+#include <QScopedPointer>
+#include <QVector>
+
+#include <mdaaudiooutputstream.h>
+#include <mda/common/audio.h>
+
+#include "audiograph.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+/**
+ * @short Writes the output of an AudioGraph to a native output stream
+ *
+ * The sink pulls blocks from the graph as the stream consumes them, and
+ * keeps enough blocks queued to cover the requested latency.  When no
+ * source is playing the queue drains and the stream is closed; the next
+ * call to start() reopens it.
+ */
+class OutputStreamSink  :   public AudioSink
+                        ,   public MMdaAudioOutputStreamCallback
+{
+public:
+    /**
+     * @param latency Duration of audio, in milliseconds, which is queued
+     * in the stream.
+     */
+    OutputStreamSink(AudioGraph *graph, int latency);
+    virtual ~OutputStreamSink();
+
+    // AudioSink
+    virtual void start(AudioGraph *graph);
+    virtual void writeAudio(const float *samples, int frameCount);
+
+    /**
+     * Returns true if the stream supports sampleRate.  No sample rate
+     * conversion is done, so graphs at other rates cannot be played.
+     */
+    static bool isSampleRateSupported(int sampleRate);
+
+private:
+    // MMdaAudioOutputStreamCallback
+    virtual void MaoscOpenComplete(TInt aError);
+    virtual void MaoscBufferCopied(TInt aError, const TDesC8 &aBuffer);
+    virtual void MaoscPlayComplete(TInt aError);
+
+    void fill();
+    void close();
+
+    /**
+     * Returns KErrNotSupported if the sample rate is not supported.
+     */
+    static TInt sampleRateCapability(int sampleRate);
+
+private:
+    enum State {
+        Closed,
+        Opening,
+        Open
+    };
+
+    // Not owned
+    AudioGraph *const           m_graph;
+
+    QScopedPointer<CMdaAudioOutputStream> m_stream;
+    TMdaAudioDataSettings       m_settings;
+    State                       m_state;
+
+    const int                   m_bufferCount;
+    const int                   m_bufferSize;
+    QVector<qint16>             m_buffers;
+    QVector<TPtrC8>             m_descriptors;
+    int                         m_nextBuffer;
+    int                         m_queuedBuffers;
+
+    // Error from the most recent call to writeAudio()
+    TInt                        m_writeError;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
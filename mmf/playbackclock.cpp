@@ -0,0 +1,128 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "playbackclock.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::PlaybackClock
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Maximum age of the anchor before the position is re-read from the native
+// player.  This bounds the drift between the interpolated clock and the
+// actual playback position.
+const qint64    SyncInterval = 300; // ms
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::PlaybackClock::PlaybackClock()
+    :   m_anchorPosition(0)
+    ,   m_running(false)
+    ,   m_syncCount(0)
+    ,   m_runningTime(0)
+{
+
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+void MMF::PlaybackClock::start(qint64 position)
+{
+    anchor(position);
+    m_running = true;
+}
+
+void MMF::PlaybackClock::stop(qint64 position)
+{
+    anchor(position);
+    m_running = false;
+}
+
+void MMF::PlaybackClock::sync(qint64 position)
+{
+    anchor(position);
+}
+
+bool MMF::PlaybackClock::isRunning() const
+{
+    return m_running;
+}
+
+qint64 MMF::PlaybackClock::position() const
+{
+    qint64 result = m_anchorPosition;
+    if (m_running)
+        result += m_timer.elapsed();
+    return result;
+}
+
+qint64 MMF::PlaybackClock::timeUntil(qint64 target) const
+{
+    const qint64 current = position();
+    return (m_running && target > current) ? target - current : 0;
+}
+
+bool MMF::PlaybackClock::syncDue() const
+{
+    return m_running && m_timer.elapsed() >= SyncInterval;
+}
+
+int MMF::PlaybackClock::syncCount() const
+{
+    return m_syncCount;
+}
+
+qint64 MMF::PlaybackClock::runningTime() const
+{
+    qint64 result = m_runningTime;
+    if (m_running)
+        result += m_timer.elapsed();
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::PlaybackClock::anchor(qint64 position)
+{
+    if (m_running)
+        m_runningTime += m_timer.elapsed();
+
+    m_anchorPosition = position;
+    m_timer.start();
+    ++m_syncCount;
+}
+
+QT_END_NAMESPACE
+
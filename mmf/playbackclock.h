@@ -0,0 +1,108 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_PLAYBACKCLOCK_H
+#define PHONON_MMF_PLAYBACKCLOCK_H
+
+#include <QElapsedTimer>
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Media clock which interpolates between native position samples
+ *
+ * Querying the playback position from the MMF client utilities involves a
+ * round trip to the multimedia server.  Rather than doing this on every
+ * tick, the player anchors this clock on a native position sample, and
+ * the clock then extrapolates the current position from a monotonic
+ * wall-clock timer.  The anchor only needs to be refreshed periodically
+ * (see syncDue()) and when playback starts, stops or jumps.
+ */
+class PlaybackClock
+{
+public:
+    PlaybackClock();
+
+    /**
+     * Anchors the clock at @p position and starts advancing it.
+     */
+    void start(qint64 position);
+
+    /**
+     * Anchors the clock at @p position and freezes it there.
+     */
+    void stop(qint64 position);
+
+    /**
+     * Re-anchors the clock at @p position without changing whether it is
+     * running.
+     */
+    void sync(qint64 position);
+
+    bool isRunning() const;
+
+    /**
+     * Returns the interpolated media position, in milliseconds.
+     */
+    qint64 position() const;
+
+    /**
+     * Returns the time, in milliseconds, until the clock reaches
+     * @p position.  If the clock is stopped, or @p position has already
+     * been passed, zero is returned.
+     */
+    qint64 timeUntil(qint64 position) const;
+
+    /**
+     * Returns true if the clock is running and the anchor is old enough
+     * that it should be refreshed from the native player.
+     */
+    bool syncDue() const;
+
+    /**
+     * Number of times the clock has been anchored since construction.
+     */
+    int syncCount() const;
+
+    /**
+     * Total time for which the clock has been running, in milliseconds.
+     */
+    qint64 runningTime() const;
+
+private:
+    void anchor(qint64 position);
+
+private:
+    QElapsedTimer               m_timer;
+    qint64                      m_anchorPosition;
+    bool                        m_running;
+    int                         m_syncCount;
+    qint64                      m_runningTime;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
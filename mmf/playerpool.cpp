@@ -0,0 +1,181 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <bacntf.h> // for CEnvironmentChangeNotifier
+#include <hal.h>
+#include <hal_data.h>
+
+#include "audioplayer.h"
+#include "playerpool.h"
+#include "utils.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::PlayerPool
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Two players are enough for a playlist UI which alternates between the
+// current source and the next one.
+const int       DefaultCapacity = 2;
+
+// Pooled players are deleted if free RAM falls below this level.  Each
+// native player utility holds its controller plugin and buffers, which
+// together can amount to several hundred kilobytes.
+const TInt      LowMemoryThreshold = 4 * 1024 * 1024; // bytes
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::PlayerPool::PlayerPool(QObject *parent)
+    :   QObject(parent)
+    ,   m_capacity(DefaultCapacity)
+    ,   m_hitCount(0)
+    ,   m_missCount(0)
+    ,   m_environmentNotifier(0)
+{
+    TRAP_IGNORE(m_environmentNotifier = CEnvironmentChangeNotifier::NewL(
+                    CActive::EPriorityLow, TCallBack(&environmentChanged, this)));
+    if (m_environmentNotifier)
+        m_environmentNotifier->Start();
+}
+
+MMF::PlayerPool::~PlayerPool()
+{
+    delete m_environmentNotifier;
+    qDeleteAll(m_releasedPlayers);
+    qDeleteAll(m_audioPlayers);
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+AudioPlayer *MMF::PlayerPool::createAudioPlayer(MediaObject *parent,
+                                                const AbstractPlayer *player)
+{
+    TRACE_CONTEXT(PlayerPool::createAudioPlayer, EAudioInternal);
+
+    AudioPlayer *result = 0;
+
+    if (m_audioPlayers.isEmpty()) {
+        ++m_missCount;
+        result = new AudioPlayer(parent, player);
+    } else {
+        ++m_hitCount;
+        result = m_audioPlayers.takeLast();
+        result->reuse(parent, player);
+    }
+
+    TRACE("hits %d misses %d pooled %d", m_hitCount, m_missCount, m_audioPlayers.count());
+
+    return result;
+}
+
+void MMF::PlayerPool::release(AbstractPlayer *player)
+{
+    if (player) {
+        player->disconnect();
+        player->close();
+
+        AudioPlayer *const audioPlayer = qobject_cast<AudioPlayer *>(player);
+        if (audioPlayer && m_audioPlayers.count() < m_capacity) {
+            m_audioPlayers.append(audioPlayer);
+        } else {
+            if (m_releasedPlayers.isEmpty())
+                QMetaObject::invokeMethod(this, "deleteReleasedPlayers",
+                                          Qt::QueuedConnection);
+            m_releasedPlayers.append(player);
+        }
+    }
+}
+
+int MMF::PlayerPool::capacity() const
+{
+    return m_capacity;
+}
+
+void MMF::PlayerPool::setCapacity(int capacity)
+{
+    m_capacity = qMax(0, capacity);
+    trim(m_capacity);
+}
+
+void MMF::PlayerPool::purge()
+{
+    TRACE_CONTEXT(PlayerPool::purge, EAudioInternal);
+    TRACE("pooled %d", m_audioPlayers.count());
+
+    trim(0);
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::PlayerPool::deleteReleasedPlayers()
+{
+    qDeleteAll(m_releasedPlayers);
+    m_releasedPlayers.clear();
+}
+
+void MMF::PlayerPool::trim(int count)
+{
+    // Players are deleted synchronously, so that purge() frees memory
+    // immediately.  Pooled players are closed, so no native callbacks are
+    // outstanding.
+    while (m_audioPlayers.count() > count)
+        delete m_audioPlayers.takeFirst();
+}
+
+// Called by the kernel's change notifier.  The first notification, which
+// is delivered as soon as the notifier starts, reports every change; the
+// pool is empty at that point, so the resulting purge has no effect.
+TInt MMF::PlayerPool::environmentChanged(TAny *self)
+{
+    PlayerPool *const pool = static_cast<PlayerPool *>(self);
+    const TInt changes = pool->m_environmentNotifier->Change();
+
+    bool lowMemory = (changes & EChangesOutOfMemory);
+
+    // EChangesFreeMemory is reported when free memory crosses one of the
+    // system's thresholds in either direction
+    if (!lowMemory && (changes & EChangesFreeMemory)) {
+        TInt freeRam = 0;
+        lowMemory = (HAL::Get(HALData::EMemoryRAMFree, freeRam) == KErrNone
+                     && freeRam < LowMemoryThreshold);
+    }
+
+    if (lowMemory)
+        pool->purge();
+
+    return KErrNone;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,126 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_PLAYERPOOL_H
+#define PHONON_MMF_PLAYERPOOL_H
+
+#include <QObject>
+#include <QList>
+
+#include <e32base.h>
+
+class CEnvironmentChangeNotifier;
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+class AbstractPlayer;
+class AudioPlayer;
+class MediaObject;
+
+/**
+ * @short Keeps closed audio players, and their native player utilities,
+ * for reuse
+ *
+ * Constructing an AudioPlayer creates a native player utility, which is
+ * relatively expensive.  Players which are no longer needed by a
+ * MediaObject are closed and kept in the pool, and subsequent requests for
+ * an audio player are satisfied from the pool where possible.
+ *
+ * Video players are not pooled, because their native player utilities are
+ * bound to a window when they are constructed.
+ *
+ * Pooled players are deleted when the system reports that free memory is
+ * low, or when a native player cannot be constructed due to lack of
+ * memory.
+ *
+ * The pool is owned by the Backend.
+ */
+class PlayerPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlayerPool(QObject *parent);
+    ~PlayerPool();
+
+    /**
+     * Returns an audio player for parent, taken from the pool if one is
+     * available.  Parameters are copied from player, as for the
+     * AudioPlayer constructor.  The caller takes ownership.
+     */
+    AudioPlayer *createAudioPlayer(MediaObject *parent, const AbstractPlayer *player);
+
+    /**
+     * Takes ownership of player.  The player is disconnected and closed,
+     * then either kept for reuse or deleted.
+     *
+     * This may be called from within one of player's own member functions,
+     * so the player is never deleted synchronously.  Instead, it is
+     * deleted when control returns to the event loop, or when the pool is
+     * destroyed, whichever comes first.  Since the pool is destroyed
+     * before the rest of the Backend, no player outlives the
+     * TickScheduler or AudioGraph which it uses.
+     */
+    void release(AbstractPlayer *player);
+
+    /**
+     * Maximum number of players which are kept.  A capacity of zero
+     * disables pooling.
+     */
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    /**
+     * Deletes all pooled players.  Called when free memory is low, and
+     * when a native player cannot be constructed due to lack of memory.
+     */
+    void purge();
+
+private Q_SLOTS:
+    void deleteReleasedPlayers();
+
+private:
+    void trim(int count);
+    static TInt environmentChanged(TAny *self);
+
+private:
+    QList<AudioPlayer *>        m_audioPlayers;
+    int                         m_capacity;
+
+    // Released players which are waiting to be deleted
+    QList<AbstractPlayer *>     m_releasedPlayers;
+
+    int                         m_hitCount;
+    int                         m_missCount;
+
+    // Notifies changes in the level of free memory.  Null if it could not
+    // be created, in which case players are only purged when construction
+    // of a native player fails.
+    CEnvironmentChangeNotifier  *m_environmentNotifier;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
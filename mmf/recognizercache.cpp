@@ -0,0 +1,227 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QPair>
+
+#include <f32file.h>
+
+#include "recognizercache.h"
+#include "utils.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::RecognizerCache
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Maximum number of entries
+const int       CacheSize = 256;
+
+const quint32   FileMagic = 0x50524331; // "PRC1"
+const quint32   FileVersion = 1;
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::RecognizerCache::RecognizerCache()
+    :   m_loaded(false)
+    ,   m_modified(false)
+    ,   m_hitCount(0)
+    ,   m_missCount(0)
+{
+
+}
+
+MMF::RecognizerCache::~RecognizerCache()
+{
+    if (m_modified)
+        save();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+QString MMF::RecognizerCache::key(const QString &fileName, RFile &file)
+{
+    QString result;
+
+    TInt size = 0;
+    TTime modified;
+    if (KErrNone == file.Size(size) && KErrNone == file.Modified(modified)) {
+        // The Symbian file system is case-insensitive
+        const QString path =
+            QDir::cleanPath(QFileInfo(fileName).absoluteFilePath()).toLower();
+        result = QString::fromLatin1("%1|%2|%3")
+                    .arg(path).arg(size).arg(modified.Int64());
+    }
+
+    return result;
+}
+
+bool MMF::RecognizerCache::find(const QString &key, MediaType &mediaType)
+{
+    TRACE_CONTEXT(RecognizerCache::find, EAudioInternal);
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_loaded)
+        load();
+
+    const QHash<QString, MediaType>::const_iterator it = m_cache.constFind(key);
+    const bool cached = (it != m_cache.constEnd());
+    if (cached) {
+        ++m_hitCount;
+        mediaType = it.value();
+        touch(key);
+    } else {
+        ++m_missCount;
+    }
+
+    TRACE("hits %d misses %d", m_hitCount, m_missCount);
+
+    return cached;
+}
+
+void MMF::RecognizerCache::insert(const QString &key, MediaType mediaType)
+{
+    QMutexLocker locker(&m_mutex);
+    doInsert(key, mediaType);
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::RecognizerCache::doInsert(const QString &key, MediaType mediaType)
+{
+    if (!key.isEmpty() && MediaTypeUnknown != mediaType) {
+        if (m_cache.contains(key)) {
+            touch(key);
+        } else {
+            m_recency.append(key);
+            if (m_recency.count() > CacheSize)
+                m_cache.remove(m_recency.takeFirst());
+        }
+        m_cache.insert(key, mediaType);
+        m_modified = true;
+    }
+}
+
+// Marks key, which must be in the cache, as the most recently used
+void MMF::RecognizerCache::touch(const QString &key)
+{
+    if (m_recency.last() != key) {
+        m_recency.removeOne(key);
+        m_recency.append(key);
+        m_modified = true;
+    }
+}
+
+void MMF::RecognizerCache::load()
+{
+    TRACE_CONTEXT(RecognizerCache::load, EAudioInternal);
+
+    m_loaded = true;
+
+    QFile file(fileName());
+    if (file.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&file);
+
+        quint32 magic = 0;
+        quint32 version = 0;
+        qint32 count = 0;
+        stream >> magic >> version >> count;
+
+        // Files written by other versions, and files which are truncated
+        // or corrupt, are discarded as a whole, since a bad media type
+        // would prevent the file from being played at all.
+        bool valid = FileMagic == magic && FileVersion == version
+                  && count >= 0 && count <= CacheSize
+                  && QDataStream::Ok == stream.status();
+
+        // Entries are stored least recently used first, so inserting them
+        // in order restores the order of use
+        QList<QPair<QString, MediaType> > entries;
+        for (qint32 i = 0; i < count && valid; ++i) {
+            QString key;
+            qint32 mediaType = MediaTypeUnknown;
+            stream >> key >> mediaType;
+            valid = QDataStream::Ok == stream.status() && !key.isEmpty()
+                 && (MediaTypeAudio == mediaType || MediaTypeVideo == mediaType);
+            if (valid)
+                entries.append(qMakePair(key, static_cast<MediaType>(mediaType)));
+        }
+
+        valid = valid && stream.atEnd();
+
+        if (valid) {
+            for (int i = 0; i < entries.count(); ++i)
+                doInsert(entries.at(i).first, entries.at(i).second);
+            m_modified = false;
+        } else {
+            // Overwrite the file when the cache is destroyed
+            m_modified = true;
+        }
+
+        TRACE("loaded %d entries, valid %d", m_cache.count(), valid);
+    }
+}
+
+void MMF::RecognizerCache::save() const
+{
+    TRACE_CONTEXT(RecognizerCache::save, EAudioInternal);
+
+    QFile file(fileName());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QDataStream stream(&file);
+        stream << FileMagic << FileVersion;
+
+        stream << qint32(m_recency.count());
+        foreach (const QString &key, m_recency)
+            stream << key << qint32(m_cache.value(key));
+
+        TRACE("saved %d entries", m_recency.count());
+    }
+}
+
+QString MMF::RecognizerCache::fileName()
+{
+    // On Symbian, this is the application's private directory
+    return QCoreApplication::applicationDirPath()
+        + QLatin1String("/phonon_mmf_recognizer.cache");
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,105 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_RECOGNIZERCACHE_H
+#define PHONON_MMF_RECOGNIZERCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include "defs.h"
+
+class RFile;
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Caches the media types of local files which have been recognized
+ *
+ * Recognition of a file requires a round trip to the AppArc server.  This
+ * cache allows it to be skipped when the same file is opened again, for
+ * example when a playlist is repeated.
+ *
+ * Entries are keyed on the cleaned, absolute path of the file together
+ * with its size and modification time, so that a file which is modified
+ * or replaced is recognized again.  The least recently used entries are
+ * evicted first.  Entries are saved in order of use, so this order is
+ * kept across restarts.
+ *
+ * The cache is owned by the Backend, and so is shared by all MediaObjects.
+ * It is loaded from a file in the application's private directory when it
+ * is first used, and saved when it is destroyed.  find() and insert() may
+ * be called from any thread.
+ */
+class RecognizerCache
+{
+public:
+    RecognizerCache();
+    ~RecognizerCache();
+
+    /**
+     * Returns the key for the specified file, which must be open.  Returns
+     * an empty string if the file attributes cannot be read.
+     */
+    static QString key(const QString &fileName, RFile &file);
+
+    /**
+     * Returns true and sets mediaType if the cache contains key.
+     */
+    bool find(const QString &key, MediaType &mediaType);
+
+    /**
+     * Only recognized types are cached, so that a file which could not be
+     * recognized is tried again next time.
+     */
+    void insert(const QString &key, MediaType mediaType);
+
+private:
+    void doInsert(const QString &key, MediaType mediaType);
+    void touch(const QString &key);
+    void load();
+    void save() const;
+    static QString fileName();
+
+private:
+    QMutex                      m_mutex;
+    QHash<QString, MediaType>   m_cache;
+
+    // Keys of m_cache, least recently used first
+    QStringList                 m_recency;
+
+    bool                        m_loaded;
+    bool                        m_modified;
+
+    int                         m_hitCount;
+    int                         m_missCount;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
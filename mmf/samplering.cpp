@@ -0,0 +1,117 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "samplering.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::SampleRing
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+SampleRing::SampleRing(int capacity)
+    :   m_buffer(roundUpToPowerOfTwo(capacity))
+    ,   m_mask(m_buffer.count() - 1)
+    ,   m_writePosition(0)
+    ,   m_readPosition(0)
+{
+    Q_ASSERT_X(capacity > 0, Q_FUNC_INFO, "Invalid capacity");
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+int SampleRing::capacity() const
+{
+    return m_buffer.count();
+}
+
+int SampleRing::write(const float *samples, int count)
+{
+    // The read position is acquired so that the consumer has finished
+    // with the samples which are about to be overwritten.
+    const quint32 writePosition = quint32(int(m_writePosition));
+    const quint32 readPosition =
+        quint32(const_cast<QAtomicInt &>(m_readPosition).fetchAndAddAcquire(0));
+    const int space = capacity() - int(writePosition - readPosition);
+
+    count = qMin(count, space);
+    float *const buffer = m_buffer.data();
+    for (int i = 0; i < count; ++i)
+        buffer[(writePosition + i) & m_mask] = samples[i];
+
+    // Publishes the samples to the consumer
+    m_writePosition.fetchAndStoreRelease(int(writePosition + count));
+    return count;
+}
+
+int SampleRing::available() const
+{
+    const quint32 writePosition =
+        quint32(const_cast<QAtomicInt &>(m_writePosition).fetchAndAddAcquire(0));
+    return int(writePosition - quint32(int(m_readPosition)));
+}
+
+int SampleRing::read(float *samples, int count)
+{
+    const quint32 readPosition = quint32(int(m_readPosition));
+
+    count = qMin(count, available());
+    const float *const buffer = m_buffer.constData();
+    for (int i = 0; i < count; ++i)
+        samples[i] = buffer[(readPosition + i) & m_mask];
+
+    // Releases the space to the producer
+    m_readPosition.fetchAndStoreRelease(int(readPosition + count));
+    return count;
+}
+
+int SampleRing::skip(int count)
+{
+    const quint32 readPosition = quint32(int(m_readPosition));
+
+    count = qMin(count, available());
+    m_readPosition.fetchAndStoreRelease(int(readPosition + count));
+    return count;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+int SampleRing::roundUpToPowerOfTwo(int value)
+{
+    int result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,86 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_SAMPLERING_H
+#define PHONON_MMF_SAMPLERING_H
+
+#include <QAtomicInt>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Lock-free ring buffer of samples, with one producer and one
+ * consumer
+ *
+ * The producer calls write(), and the consumer calls available(), read()
+ * and skip(); the two may be in different threads.  Neither side blocks
+ * or allocates.  If the buffer is full, samples which do not fit are
+ * dropped.
+ */
+class SampleRing
+{
+public:
+    /**
+     * The capacity is rounded up to a power of two.
+     */
+    explicit SampleRing(int capacity);
+
+    int capacity() const;
+
+    /**
+     * Appends up to count samples, and returns the number appended.
+     */
+    int write(const float *samples, int count);
+
+    /**
+     * Number of samples which can be read.
+     */
+    int available() const;
+
+    /**
+     * Removes up to count of the oldest samples, and returns the number
+     * removed.
+     */
+    int read(float *samples, int count);
+    int skip(int count);
+
+private:
+    static int roundUpToPowerOfTwo(int value);
+
+private:
+    QVector<float>              m_buffer;
+    const int                   m_mask;
+
+    // Positions increase without bound, and are reduced modulo the
+    // capacity on access.  Each is only modified by one side.
+    QAtomicInt                  m_writePosition;
+    QAtomicInt                  m_readPosition;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,168 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QDir>
+#include <QMutexLocker>
+
+#include "sessionmanager.h"
+#include "utils.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::SessionManager
+  \internal
+*/
+
+MMF::SessionManager *MMF::SessionManager::s_instance = 0;
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::SessionManager::SessionManager()
+    :   m_refCount(0)
+    ,   m_fileServerError(KErrNotReady)
+    ,   m_recognizerError(KErrNotReady)
+{
+
+}
+
+MMF::SessionManager::~SessionManager()
+{
+    if (KErrNone == m_recognizerError)
+        m_recognizer.Close();
+    if (KErrNone == m_fileServerError)
+        m_fileServer.Close();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+MMF::SessionManager *MMF::SessionManager::acquire()
+{
+    if (!s_instance)
+        s_instance = new SessionManager;
+    ++s_instance->m_refCount;
+
+    s_instance->connectFileServer();
+    s_instance->connectRecognizer();
+
+    return s_instance;
+}
+
+void MMF::SessionManager::release()
+{
+    Q_ASSERT(this == s_instance);
+    Q_ASSERT(m_refCount > 0);
+    if (--m_refCount == 0) {
+        s_instance = 0;
+        delete this;
+    }
+}
+
+int MMF::SessionManager::openFile(RFile &file, const QString &fileName)
+{
+    QMutexLocker locker(&m_fileServerMutex);
+    TInt err = m_fileServerError;
+    locker.unlock();
+
+    if (KErrNone == err) {
+        const QHBufC nativeFileName(QDir::toNativeSeparators(fileName));
+        err = file.Open(m_fileServer, *nativeFileName, EFileRead | EFileShareReadersOrWriters);
+    }
+    return err;
+}
+
+int MMF::SessionManager::recognizeData(RFile &file, TDataRecognitionResult &result)
+{
+    QMutexLocker locker(&m_recognizerMutex);
+    TInt err = m_recognizerError;
+    if (KErrNone == err)
+        err = m_recognizer.RecognizeData(file, result);
+    return err;
+}
+
+int MMF::SessionManager::recognizeData(const TDesC8 &buffer, TDataRecognitionResult &result)
+{
+    QMutexLocker locker(&m_recognizerMutex);
+    TInt err = m_recognizerError;
+    if (KErrNone == err)
+        err = m_recognizer.RecognizeData(KNullDesC, buffer, result);
+    return err;
+}
+
+int MMF::SessionManager::getSupportedDataTypes(CDataTypeArray &array)
+{
+    QMutexLocker locker(&m_recognizerMutex);
+    TInt err = m_recognizerError;
+    if (KErrNone == err)
+        TRAP(err, m_recognizer.GetSupportedDataTypesL(array));
+    return err;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::SessionManager::connectFileServer()
+{
+    TRACE_CONTEXT(SessionManager::connectFileServer, EAudioInternal);
+
+    QMutexLocker locker(&m_fileServerMutex);
+
+    if (KErrNone != m_fileServerError) {
+        TInt err = m_fileServer.Connect();
+        if (KErrNone == err) {
+            // This must be called in order to be able to share file handles
+            // with the recognizer server, and to be able to open files from
+            // threads other than the one which connected the session.
+            err = m_fileServer.ShareProtected();
+            if (KErrNone != err)
+                m_fileServer.Close();
+        }
+        m_fileServerError = err;
+        TRACE("RFs connect error %d", err);
+    }
+}
+
+void MMF::SessionManager::connectRecognizer()
+{
+    TRACE_CONTEXT(SessionManager::connectRecognizer, EAudioInternal);
+
+    QMutexLocker locker(&m_recognizerMutex);
+
+    if (KErrNone != m_recognizerError) {
+        TInt err = m_recognizer.Connect();
+        if (KErrNone == err) {
+            err = m_recognizer.ShareAuto();
+            if (KErrNone != err)
+                m_recognizer.Close();
+        }
+        m_recognizerError = err;
+        TRACE("RApaLsSession connect error %d", err);
+    }
+}
+
+QT_END_NAMESPACE
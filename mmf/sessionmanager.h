@@ -0,0 +1,109 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_SESSIONMANAGER_H
+#define PHONON_MMF_SESSIONMANAGER_H
+
+#include <QMutex>
+#include <QString>
+
+#include <apgcli.h>
+#include <apmrec.h> // for CDataTypeArray
+#include <f32file.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Process-wide file server and recognizer sessions
+ *
+ * Each MediaObject used to connect its own file server session, and its
+ * own recognizer session.  An application which creates many MediaObjects
+ * therefore paid for many server connections.  The SessionManager owns a
+ * single session of each type, which is shared by all MediaObjects.
+ *
+ * The manager is reference counted: it is created by the first call to
+ * acquire(), and deleted when the last reference is released.
+ *
+ * Session handles are owned by the thread which connects them, so both
+ * sessions are connected by acquire(), which, like release(), must be
+ * called from the main thread.  If a connection fails, it is retried by
+ * the next call to acquire().  The other functions may be called from any
+ * thread, and only open subsessions or make requests on the sessions.
+ */
+class SessionManager
+{
+public:
+    static SessionManager *acquire();
+    void release();
+
+    /**
+     * Opens fileName for reading on the shared file server session.
+     * Returns a Symbian error code.
+     */
+    int openFile(RFile &file, const QString &fileName);
+
+    /**
+     * Requests from different threads are serialized.  Return a Symbian
+     * error code.
+     */
+    int recognizeData(RFile &file, TDataRecognitionResult &result);
+    int recognizeData(const TDesC8 &buffer, TDataRecognitionResult &result);
+
+    /**
+     * Fills array with the data types which can be handled by installed
+     * applications and plugins.  Returns a Symbian error code.
+     */
+    int getSupportedDataTypes(CDataTypeArray &array);
+
+private:
+    SessionManager();
+    ~SessionManager();
+
+    void connectFileServer();
+    void connectRecognizer();
+
+private:
+    static SessionManager       *s_instance;
+    int                         m_refCount;
+
+    // The errors are those of the most recent connection attempts, which
+    // are only made on the main thread.
+
+    // Guards the connection state of m_fileServer
+    QMutex                      m_fileServerMutex;
+    int                         m_fileServerError;
+    RFs                         m_fileServer;
+
+    // Guards the connection state of, and serializes requests to,
+    // m_recognizer
+    QMutex                      m_recognizerMutex;
+    int                         m_recognizerError;
+    RApaLsSession               m_recognizer;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,326 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+
+#include "dspkernel.h"
+#include "shelffilter.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::ShelfFilter
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Number of frames which are deinterleaved and filtered at a time
+const int       BlockFrames = 32;
+
+// State values below this level are flushed to zero, in order to avoid
+// the cost of denormal arithmetic as the filters decay.
+const float     DenormalThreshold = 1.0e-20f;
+
+#ifdef PHONON_MMF_DSP_SIMD
+const int       SimdLanes = SimdKernel::Lanes;
+
+// Signals with up to this many channels are filtered two sections at a
+// time, one in each pair of lanes, by filterSectionPairs(); wider signals
+// are filtered SimdLanes channels at a time, by filterBlock().
+const int       PairLanes = SimdLanes / 2;
+#else
+const int       SimdLanes = 1;
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+ShelfFilter::ShelfFilter(int channelCount, int sectionCount)
+    :   m_channelCount(channelCount)
+    ,   m_sectionCount(sectionCount)
+    ,   m_simd(laneCount(channelCount) > 1)
+    ,   m_lanes(laneCount(channelCount))
+    ,   m_groupCount((channelCount + m_lanes - 1) / m_lanes)
+    ,   m_coefficients(sectionCount)
+    ,   m_state1(sectionCount * m_groupCount * m_lanes)
+    ,   m_state2(sectionCount * m_groupCount * m_lanes)
+    ,   m_block(m_groupCount * BlockFrames * m_lanes)
+{
+    Q_ASSERT_X(channelCount > 0 && channelCount <= MaxChannelCount,
+               Q_FUNC_INFO, "Invalid channel count");
+
+    const Coefficients flat = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    m_coefficients.fill(flat);
+
+    reset();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+ShelfFilter::Coefficients ShelfFilter::design(Type type, qreal frequency,
+                                              qint32 millibels, int sampleRate)
+{
+    Coefficients c = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    if (frequency <= 0 || frequency >= 0.5 * sampleRate)
+        return c;
+
+    const qreal a = qPow(10.0, millibels / 4000.0);
+    const qreal omega = 2.0 * M_PI * frequency / sampleRate;
+    const qreal cosOmega = qCos(omega);
+    const qreal beta = qSin(omega) * M_SQRT2 * qSqrt(a);
+
+    // sign selects between the low- and high-shelf forms of the cookbook
+    // formulae, which differ only in the signs of some terms.
+    const qreal sign = LowShelf == type ? 1.0 : -1.0;
+    const qreal plus = (a + 1.0) - sign * (a - 1.0) * cosOmega;
+    const qreal minus = (a + 1.0) + sign * (a - 1.0) * cosOmega;
+    const qreal a0 = minus + beta;
+
+    c.m_b0 = a * (plus + beta) / a0;
+    c.m_b1 = sign * 2.0 * a * ((a - 1.0) - (a + 1.0) * cosOmega * sign) / a0;
+    c.m_b2 = a * (plus - beta) / a0;
+    c.m_a1 = -sign * 2.0 * ((a - 1.0) + (a + 1.0) * cosOmega * sign) / a0;
+    c.m_a2 = (minus - beta) / a0;
+
+    return c;
+}
+
+ShelfFilter::Coefficients ShelfFilter::interpolate(const Coefficients &from,
+                                                   const Coefficients &to,
+                                                   float position)
+{
+    Coefficients c;
+    c.m_b0 = from.m_b0 + position * (to.m_b0 - from.m_b0);
+    c.m_b1 = from.m_b1 + position * (to.m_b1 - from.m_b1);
+    c.m_b2 = from.m_b2 + position * (to.m_b2 - from.m_b2);
+    c.m_a1 = from.m_a1 + position * (to.m_a1 - from.m_a1);
+    c.m_a2 = from.m_a2 + position * (to.m_a2 - from.m_a2);
+    return c;
+}
+
+int ShelfFilter::channelCount() const
+{
+    return m_channelCount;
+}
+
+int ShelfFilter::sectionCount() const
+{
+    return m_sectionCount;
+}
+
+void ShelfFilter::setCoefficients(int section, const Coefficients &coefficients)
+{
+    Q_ASSERT_X(section >= 0 && section < m_sectionCount, Q_FUNC_INFO,
+               "Invalid section index");
+    m_coefficients[section] = coefficients;
+}
+
+void ShelfFilter::reset()
+{
+    m_state1.fill(0.0f);
+    m_state2.fill(0.0f);
+}
+
+void ShelfFilter::process(qint16 *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+void ShelfFilter::process(float *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+const char *ShelfFilter::kernelName() const
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    if (m_simd)
+        return SimdKernel::name();
+#endif
+    return ScalarKernel::name();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+int ShelfFilter::laneCount(int channelCount)
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    return channelCount <= PairLanes ? PairLanes : SimdLanes;
+#else
+    Q_UNUSED(channelCount)
+    return 1;
+#endif
+}
+
+template<typename Sample>
+void ShelfFilter::processBlocks(Sample *samples, int frameCount)
+{
+    const int lanes = m_lanes;
+
+    while (frameCount > 0) {
+        const int blockFrames = qMin(frameCount, int(BlockFrames));
+
+        // Deinterleave into groups of lanes, padding unused lanes
+        for (int g = 0; g < m_groupCount; ++g) {
+            float *block = m_block.data() + g * BlockFrames * lanes;
+            for (int f = 0; f < blockFrames; ++f) {
+                const Sample *frame = samples + f * m_channelCount;
+                for (int l = 0; l < lanes; ++l) {
+                    const int channel = g * lanes + l;
+                    *block++ = channel < m_channelCount
+                             ? toFloat(frame[channel]) : 0.0f;
+                }
+            }
+        }
+
+#ifdef PHONON_MMF_DSP_SIMD
+        if (PairLanes == lanes)
+            filterSectionPairs(blockFrames);
+        else if (m_simd)
+            filterBlock<SimdKernel>(blockFrames);
+        else
+#endif
+            filterBlock<ScalarKernel>(blockFrames);
+
+        for (int g = 0; g < m_groupCount; ++g) {
+            const float *block = m_block.data() + g * BlockFrames * lanes;
+            for (int f = 0; f < blockFrames; ++f) {
+                Sample *frame = samples + f * m_channelCount;
+                for (int l = 0; l < lanes; ++l, ++block) {
+                    const int channel = g * lanes + l;
+                    if (channel < m_channelCount)
+                        fromFloat(*block, frame[channel]);
+                }
+            }
+        }
+
+        flushDenormals();
+
+        samples += blockFrames * m_channelCount;
+        frameCount -= blockFrames;
+    }
+}
+
+/**
+ * Applies each section in turn to m_block, using the transposed direct
+ * form II structure.
+ */
+template<typename Kernel>
+void ShelfFilter::filterBlock(int frameCount)
+{
+    typedef typename Kernel::Vector Vector;
+    const int lanes = Kernel::Lanes;
+
+    for (int section = 0; section < m_sectionCount; ++section) {
+        const Coefficients &c = m_coefficients[section];
+        const Vector b0 = Kernel::set(c.m_b0);
+        const Vector b1 = Kernel::set(c.m_b1);
+        const Vector b2 = Kernel::set(c.m_b2);
+        const Vector a1 = Kernel::set(c.m_a1);
+        const Vector a2 = Kernel::set(c.m_a2);
+
+        for (int g = 0; g < m_groupCount; ++g) {
+            const int offset = (section * m_groupCount + g) * lanes;
+            Vector s1 = Kernel::load(m_state1.data() + offset);
+            Vector s2 = Kernel::load(m_state2.data() + offset);
+
+            float *block = m_block.data() + g * BlockFrames * lanes;
+            for (int f = 0; f < frameCount; ++f, block += lanes) {
+                const Vector x = Kernel::load(block);
+                const Vector y = Kernel::add(Kernel::mul(b0, x), s1);
+                s1 = Kernel::add(Kernel::sub(Kernel::mul(b1, x), Kernel::mul(a1, y)), s2);
+                s2 = Kernel::sub(Kernel::mul(b2, x), Kernel::mul(a2, y));
+                Kernel::store(block, y);
+            }
+
+            Kernel::store(m_state1.data() + offset, s1);
+            Kernel::store(m_state2.data() + offset, s2);
+        }
+    }
+}
+
+#ifdef PHONON_MMF_DSP_SIMD
+/**
+ * Applies the sections to m_block, which holds a single group of PairLanes
+ * lanes, two sections at a time; see filterSectionPair().  With an odd
+ * number of sections, the last is paired with a flat section.
+ */
+void ShelfFilter::filterSectionPairs(int frameCount)
+{
+    typedef SimdKernel::Vector Vector;
+
+    const Coefficients flat = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for (int section = 0; section < m_sectionCount; section += 2) {
+        float *const state1 = m_state1.data() + section * PairLanes;
+        float *const state2 = m_state2.data() + section * PairLanes;
+
+        if (section + 1 < m_sectionCount) {
+            // The states of consecutive sections are adjacent
+            Vector s1 = SimdKernel::load(state1);
+            Vector s2 = SimdKernel::load(state2);
+
+            filterSectionPair(m_block.data(), frameCount, m_coefficients[section],
+                              m_coefficients[section + 1], s1, s2);
+
+            SimdKernel::store(state1, s1);
+            SimdKernel::store(state2, s2);
+        } else {
+            // The state of the flat section remains zero
+            Vector s1 = SimdKernel::loadPair(state1);
+            Vector s2 = SimdKernel::loadPair(state2);
+
+            filterSectionPair(m_block.data(), frameCount, m_coefficients[section],
+                              flat, s1, s2);
+
+            SimdKernel::storeLowPair(state1, s1);
+            SimdKernel::storeLowPair(state2, s2);
+        }
+    }
+}
+#endif
+
+void ShelfFilter::flushDenormals()
+{
+    float *const state1 = m_state1.data();
+    float *const state2 = m_state2.data();
+
+    for (int i = 0; i < m_state1.count(); ++i) {
+        if (qAbs(state1[i]) < DenormalThreshold)
+            state1[i] = 0.0f;
+        if (qAbs(state2[i]) < DenormalThreshold)
+            state2[i] = 0.0f;
+    }
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,154 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_SHELFFILTER_H
+#define PHONON_MMF_SHELFFILTER_H
+
+#include <QVector>
+
+#include "audiograph.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Cascade of low- and high-shelf biquad filters
+ *
+ * Each section is a shelving filter, from Robert Bristow-Johnson's
+ * "Cookbook formulae for audio EQ biquad filter coefficients", with a
+ * slope of one.  The coefficients are designed by design(), and may be
+ * changed between calls to process(); designing them involves
+ * trigonometry, so clients which change them frequently should design
+ * tables of them in advance, and move between the entries using
+ * interpolate().
+ *
+ * Samples are interleaved 16-bit or floating-point PCM, and are processed
+ * in place.  As for BiquadEqualizer, where SSE2 or NEON is available,
+ * mono and stereo signals are filtered two sections at a time, and wider
+ * signals four channels at a time.
+ *
+ * All memory is allocated on construction; process() does not allocate.
+ */
+class ShelfFilter : public AudioProcessor
+{
+public:
+    enum Type
+    {
+        LowShelf,
+        HighShelf
+    };
+
+    struct Coefficients
+    {
+        float   m_b0;
+        float   m_b1;
+        float   m_b2;
+        float   m_a1;
+        float   m_a2;
+    };
+
+    /**
+     * Returns the coefficients of a shelf with the specified corner
+     * frequency and gain.  A frequency which cannot be represented at the
+     * sample rate results in a flat response.
+     */
+    static Coefficients design(Type type, qreal frequency, qint32 millibels,
+                               int sampleRate);
+
+    /**
+     * Linear interpolation between two sets of coefficients; position is
+     * in the range 0.0 (from) to 1.0 (to).  Provided the two sets are
+     * designed for nearby gains, the result is close to the set which
+     * would be designed for the intermediate gain.
+     */
+    static Coefficients interpolate(const Coefficients &from,
+                                    const Coefficients &to, float position);
+
+    /**
+     * Constructs a cascade of sectionCount flat sections.
+     */
+    ShelfFilter(int channelCount, int sectionCount);
+
+    enum Constants
+    {
+        MaxChannelCount = 8
+    };
+
+    int channelCount() const;
+    int sectionCount() const;
+
+    void setCoefficients(int section, const Coefficients &coefficients);
+
+    /**
+     * Clears the filter history.
+     */
+    void reset();
+
+    /**
+     * Filters frameCount frames of interleaved samples in place.
+     */
+    void process(qint16 *samples, int frameCount);
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
+    /**
+     * Name of the kernel which is used, e.g. "sse2" or "scalar".
+     */
+    const char *kernelName() const;
+
+private:
+    static int laneCount(int channelCount);
+    template<typename Sample> void processBlocks(Sample *samples, int frameCount);
+    template<typename Kernel> void filterBlock(int frameCount);
+    void filterSectionPairs(int frameCount);
+    void flushDenormals();
+
+private:
+    const int                   m_channelCount;
+    const int                   m_sectionCount;
+
+    // Number of channels filtered in parallel by the selected kernel, or,
+    // when filtering two sections at a time, the number of lanes per section
+    const bool                  m_simd;
+    const int                   m_lanes;
+
+    // Number of groups of channels which are filtered in parallel
+    const int                   m_groupCount;
+
+    QVector<Coefficients>       m_coefficients;
+
+    // Filter state, indexed by section, then group, then lane
+    QVector<float>              m_state1;
+    QVector<float>              m_state2;
+
+    // Samples of the block being filtered, indexed by group, then frame,
+    // then lane
+    QVector<float>              m_block;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,349 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QBuffer>
+#include <QFile>
+#include <QResource>
+#include <f32file.h>
+
+#include "backend.h"
+#include "mediaobject.h"
+#include "softwareplayer.h"
+#include "utils.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::SoftwarePlayer
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Volume range reported via maxVolumeChanged()
+const int       MaxVolume = 10000;
+
+
+//-----------------------------------------------------------------------------
+// RFileDevice
+//-----------------------------------------------------------------------------
+
+namespace
+{
+/**
+ * Exposes a file handle which has been opened by the MediaObject as a
+ * QIODevice, so that it can be parsed by WavReader.  The handle is not
+ * owned.
+ */
+class RFileDevice : public QIODevice
+{
+public:
+    RFileDevice(RFile &file) : m_file(file) { }
+
+    virtual bool isSequential() const
+    {
+        return false;
+    }
+
+    virtual qint64 size() const
+    {
+        TInt size = 0;
+        return KErrNone == m_file.Size(size) ? size : 0;
+    }
+
+    virtual bool seek(qint64 pos)
+    {
+        TInt offset = pos;
+        if (KErrNone != m_file.Seek(ESeekStart, offset))
+            return false;
+        return QIODevice::seek(pos);
+    }
+
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize)
+    {
+        TPtr8 ptr(reinterpret_cast<TUint8 *>(data), maxSize);
+        return KErrNone == m_file.Read(ptr) ? ptr.Length() : -1;
+    }
+
+    virtual qint64 writeData(const char *, qint64)
+    {
+        return -1;
+    }
+
+private:
+    RFile &m_file;
+};
+}
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::SoftwarePlayer::SoftwarePlayer(MediaObject *parent, const AbstractPlayer *player)
+        :   AbstractMediaPlayer(parent, player)
+        ,   m_graph(parent->backend()->audioGraph())
+        ,   m_route(parent->audioRoute())
+        ,   m_playing(false)
+        ,   m_gain(1.0f)
+{
+    TRACE_CONTEXT(SoftwarePlayer::SoftwarePlayer, EAudioApi);
+    TRACE_ENTRY("route %d", m_route);
+
+    Q_ASSERT_X(m_graph, Q_FUNC_INFO, "In-process rendering is not enabled");
+    m_graph->addSource(m_route, this);
+
+    TRACE_EXIT_0();
+}
+
+MMF::SoftwarePlayer::~SoftwarePlayer()
+{
+    TRACE_CONTEXT(SoftwarePlayer::~SoftwarePlayer, EAudioApi);
+    TRACE_ENTRY_0();
+
+    m_graph->removeSource(m_route, this);
+
+    TRACE_EXIT_0();
+}
+
+//-----------------------------------------------------------------------------
+// Public API
+//-----------------------------------------------------------------------------
+
+bool MMF::SoftwarePlayer::canPlay(RFile *file, QResource *resource, int sampleRate)
+{
+    QScopedPointer<QIODevice> device;
+    if (file) {
+        device.reset(new RFileDevice(*file));
+    } else if (resource && !resource->isCompressed()) {
+        QBuffer *const buffer = new QBuffer;
+        buffer->setData(QByteArray::fromRawData(
+            reinterpret_cast<const char *>(resource->data()), resource->size()));
+        device.reset(buffer);
+    } else {
+        // URLs and compressed resources are not supported
+        return false;
+    }
+
+    device->open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    WavReader reader;
+    const bool supported = device->seek(0) && reader.open(device.data())
+                        && reader.sampleRate() == sampleRate;
+    device->seek(0);
+
+    return supported;
+}
+
+void MMF::SoftwarePlayer::doPlay()
+{
+    m_playing = true;
+    m_graph->start();
+}
+
+void MMF::SoftwarePlayer::doPause()
+{
+    m_playing = false;
+}
+
+void MMF::SoftwarePlayer::doStop()
+{
+    m_playing = false;
+    m_reader.seek(0);
+}
+
+void MMF::SoftwarePlayer::doSeek(qint64 ms)
+{
+    if (m_reader.isOpen())
+        m_reader.seek(ms * m_reader.sampleRate() / 1000);
+}
+
+int MMF::SoftwarePlayer::setDeviceVolume(int mmfVolume)
+{
+    m_gain = float(mmfVolume) / MaxVolume;
+    return KErrNone;
+}
+
+int MMF::SoftwarePlayer::openFile(const QString &fileName)
+{
+    QScopedPointer<QFile> file(new QFile(fileName));
+    if (!file->open(QIODevice::ReadOnly))
+        return KErrNotFound;
+    return openDevice(file.take());
+}
+
+int MMF::SoftwarePlayer::openFile(RFile& file)
+{
+    QScopedPointer<RFileDevice> device(new RFileDevice(file));
+    device->open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    // The recognizer may have moved the file position
+    if (!device->seek(0))
+        return KErrGeneral;
+
+    return openDevice(device.take());
+}
+
+int MMF::SoftwarePlayer::openUrl(const QString& /*url*/)
+{
+    return KErrNotSupported;
+}
+
+int MMF::SoftwarePlayer::openDescriptor(const TDesC8 &des)
+{
+    QBuffer *const buffer = new QBuffer;
+    buffer->setData(QByteArray::fromRawData(
+        reinterpret_cast<const char *>(des.Ptr()), des.Length()));
+    buffer->open(QIODevice::ReadOnly);
+    return openDevice(buffer);
+}
+
+int MMF::SoftwarePlayer::bufferStatus() const
+{
+    return 100;
+}
+
+void MMF::SoftwarePlayer::doClose()
+{
+    m_playing = false;
+    m_reader.close();
+    m_device.reset();
+}
+
+bool MMF::SoftwarePlayer::hasVideo() const
+{
+    return false;
+}
+
+qint64 MMF::SoftwarePlayer::totalTime() const
+{
+    return m_reader.isOpen()
+        ? m_reader.frameCount() * 1000 / m_reader.sampleRate() : 0;
+}
+
+qint64 MMF::SoftwarePlayer::getCurrentTime() const
+{
+    return m_reader.isOpen()
+        ? m_reader.position() * 1000 / m_reader.sampleRate() : 0;
+}
+
+int MMF::SoftwarePlayer::numberOfMetaDataEntries() const
+{
+    return 0;
+}
+
+QPair<QString, QString> MMF::SoftwarePlayer::metaDataEntry(int /*index*/) const
+{
+    return QPair<QString, QString>();
+}
+
+//-----------------------------------------------------------------------------
+// AudioSource
+//-----------------------------------------------------------------------------
+
+int MMF::SoftwarePlayer::readAudio(float *samples, int frameCount)
+{
+    if (!m_playing)
+        return 0;
+
+    const int outputChannels = m_graph->channelCount();
+    const int inputChannels = m_reader.channelCount();
+
+    const int frames = m_reader.read(m_buffer.data(), frameCount);
+    const float *input = m_buffer.constData();
+
+    for (int f = 0; f < frames; ++f, input += inputChannels) {
+        if (1 == outputChannels && inputChannels > 1) {
+            // Downmix
+            float sum = 0.0f;
+            for (int c = 0; c < inputChannels; ++c)
+                sum += input[c];
+            *samples++ = m_gain * sum / inputChannels;
+        } else {
+            // Mono is copied to all channels; surplus channels are dropped,
+            // and missing ones are silent
+            for (int c = 0; c < outputChannels; ++c) {
+                const float sample = 1 == inputChannels ? input[0]
+                                   : c < inputChannels ? input[c] : 0.0f;
+                *samples++ = m_gain * sample;
+            }
+        }
+    }
+
+    if (frames < frameCount) {
+        m_playing = false;
+        QMetaObject::invokeMethod(this, "completed", Qt::QueuedConnection);
+    }
+
+    return frames;
+}
+
+bool MMF::SoftwarePlayer::isPlaying() const
+{
+    return m_playing;
+}
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+int MMF::SoftwarePlayer::openDevice(QIODevice *device)
+{
+    TRACE_CONTEXT(SoftwarePlayer::openDevice, EAudioInternal);
+    TRACE_ENTRY_0();
+
+    m_device.reset(device);
+
+    // No sample rate conversion is done, so the source must match the
+    // format of the graph.
+    if (!m_reader.open(device) || m_reader.sampleRate() != m_graph->sampleRate()) {
+        doClose();
+        TRACE_RETURN("err %d", KErrNotSupported);
+    }
+
+    m_buffer.resize(m_graph->blockFrames() * m_reader.channelCount());
+
+    // Loading completes asynchronously, as it does for the native player
+    QMetaObject::invokeMethod(this, "loaded", Qt::QueuedConnection);
+
+    TRACE_RETURN("err %d", KErrNone);
+}
+
+void MMF::SoftwarePlayer::loaded()
+{
+    if (!m_reader.isOpen() || LoadingState != privateState())
+        return;
+
+    maxVolumeChanged(MaxVolume);
+    emit totalTimeChanged(totalTime());
+    loadingComplete(KErrNone);
+}
+
+void MMF::SoftwarePlayer::completed()
+{
+    if (m_reader.isOpen())
+        playbackComplete(KErrNone);
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,118 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_SOFTWAREPLAYER_H
+#define PHONON_MMF_SOFTWAREPLAYER_H
+
+#include <QVector>
+
+#include "abstractmediaplayer.h"
+#include "audiograph.h"
+#include "wavfile.h"
+
+QT_BEGIN_NAMESPACE
+
+class QIODevice;
+class QResource;
+
+namespace Phonon
+{
+namespace MMF
+{
+/**
+ * @short Player which decodes in process, and renders via the AudioGraph
+ *
+ * Used instead of AudioPlayer when in-process rendering is enabled, so
+ * that the audio passes through the in-process implementations of the
+ * effects which are connected to the MediaObject.  Only uncompressed
+ * 16-bit PCM WAVE sources are supported, at the sample rate of the graph;
+ * other sources are played by AudioPlayer, with native effects.
+ */
+class SoftwarePlayer    :   public AbstractMediaPlayer
+                        ,   public AudioSource
+{
+    Q_OBJECT
+
+public:
+    SoftwarePlayer(MediaObject *parent, const AbstractPlayer *player);
+    virtual ~SoftwarePlayer();
+
+    /**
+     * Returns true if the source which the MediaObject has opened, either
+     * as a file or as a resource, is supported at sampleRate.  The file
+     * position is restored to the start of the file.
+     */
+    static bool canPlay(RFile *file, QResource *resource, int sampleRate);
+
+    // AbstractMediaPlayer
+    virtual void doPlay();
+    virtual void doPause();
+    virtual void doStop();
+    virtual void doSeek(qint64 milliseconds);
+    virtual int setDeviceVolume(int mmfVolume);
+    virtual int openFile(const QString &fileName);
+    virtual int openFile(RFile& file);
+    virtual int openUrl(const QString& url);
+    virtual int openDescriptor(const TDesC8 &des);
+    virtual int bufferStatus() const;
+    virtual void doClose();
+
+    // MediaObjectInterface
+    virtual bool hasVideo() const;
+    virtual qint64 totalTime() const;
+
+    // AbstractMediaPlayer
+    virtual qint64 getCurrentTime() const;
+    virtual int numberOfMetaDataEntries() const;
+    virtual QPair<QString, QString> metaDataEntry(int index) const;
+
+    // AudioSource
+    virtual int readAudio(float *samples, int frameCount);
+    virtual bool isPlaying() const;
+
+private Q_SLOTS:
+    void loaded();
+    void completed();
+
+private:
+    /**
+     * Takes ownership of device, which must be open.
+     */
+    int openDevice(QIODevice *device);
+
+private:
+    // Not owned
+    AudioGraph *const           m_graph;
+    const int                   m_route;
+
+    QScopedPointer<QIODevice>   m_device;
+    WavReader                   m_reader;
+
+    // Source frames, before conversion to the channel count of the graph
+    QVector<float>              m_buffer;
+
+    bool                        m_playing;
+    float                       m_gain;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,196 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+
+#include "dspkernel.h"
+#include "spectrumanalyzer.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::SpectrumAnalyzer
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+SpectrumAnalyzer::SpectrumAnalyzer(int size)
+    :   m_size(size)
+    ,   m_halfSize(size / 2)
+    ,   m_window(size)
+    ,   m_bitReversal(size / 2)
+    ,   m_twiddleReal(size / 2)
+    ,   m_twiddleImag(size / 2)
+    ,   m_splitReal(size / 2 + 1)
+    ,   m_splitImag(size / 2 + 1)
+    ,   m_real(size / 2)
+    ,   m_imag(size / 2)
+{
+    Q_ASSERT_X(size >= MinSize && size <= MaxSize && !(size & (size - 1)),
+               Q_FUNC_INFO, "Invalid size");
+
+    // Periodic Hann window
+    for (int i = 0; i < m_size; ++i)
+        m_window[i] = 0.5 - 0.5 * qCos(2.0 * M_PI * i / m_size);
+
+    int bits = 0;
+    while ((1 << bits) < m_halfSize)
+        ++bits;
+    for (int i = 0; i < m_halfSize; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b)
+            if (i & (1 << b))
+                reversed |= 1 << (bits - 1 - b);
+        m_bitReversal[i] = reversed;
+    }
+
+    for (int span = 1; span < m_halfSize; span *= 2) {
+        for (int k = 0; k < span; ++k) {
+            const qreal angle = -M_PI * k / span;
+            m_twiddleReal[span - 1 + k] = qCos(angle);
+            m_twiddleImag[span - 1 + k] = qSin(angle);
+        }
+    }
+
+    for (int k = 0; k <= m_halfSize; ++k) {
+        const qreal angle = -2.0 * M_PI * k / m_size;
+        m_splitReal[k] = qCos(angle);
+        m_splitImag[k] = qSin(angle);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+int SpectrumAnalyzer::size() const
+{
+    return m_size;
+}
+
+int SpectrumAnalyzer::binCount() const
+{
+    return m_halfSize + 1;
+}
+
+void SpectrumAnalyzer::analyze(const float *samples, float *magnitudes)
+{
+    const int n = m_halfSize;
+    float *const re = m_real.data();
+    float *const im = m_imag.data();
+
+    // Even samples form the real parts, and odd samples the imaginary
+    // parts, of a complex sequence of half the size.
+    const float *const window = m_window.constData();
+    for (int i = 0; i < n; ++i) {
+        const int j = m_bitReversal[i];
+        re[j] = samples[2 * i] * window[2 * i];
+        im[j] = samples[2 * i + 1] * window[2 * i + 1];
+    }
+
+    for (int span = 1; span < n; span *= 2) {
+#ifdef PHONON_MMF_DSP_SIMD
+        if (span >= SimdKernel::Lanes)
+            butterflies<SimdKernel>(span);
+        else
+#endif
+            butterflies<ScalarKernel>(span);
+    }
+
+    // Splits the transform Z of the complex sequence into the transform X
+    // of the real input:
+    //     X[k] = E[k] + W^k O[k], where W = exp(-2 pi i / size),
+    //     E[k] = (Z[k] + conj(Z[n - k])) / 2,
+    //     O[k] = -i (Z[k] - conj(Z[n - k])) / 2.
+    // The window has a sum of size / 2, so the amplitude of a sinusoid is
+    // 4 |X[k]| / size, except at DC and Nyquist.
+    const float scale = 4.0f / m_size;
+    for (int k = 0; k <= n; ++k) {
+        const int a = k % n;
+        const int b = (n - k) % n;
+        const float evenReal = 0.5f * (re[a] + re[b]);
+        const float evenImag = 0.5f * (im[a] - im[b]);
+        const float oddReal = 0.5f * (im[a] + im[b]);
+        const float oddImag = -0.5f * (re[a] - re[b]);
+        const float wr = m_splitReal[k];
+        const float wi = m_splitImag[k];
+        const float xr = evenReal + wr * oddReal - wi * oddImag;
+        const float xi = evenImag + wr * oddImag + wi * oddReal;
+        magnitudes[k] = scale * qSqrt(xr * xr + xi * xi);
+    }
+
+    magnitudes[0] *= 0.5f;
+    magnitudes[n] *= 0.5f;
+}
+
+const char *SpectrumAnalyzer::kernelName() const
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    return SimdKernel::name();
+#else
+    return ScalarKernel::name();
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+/**
+ * Performs one stage of the FFT, in which each butterfly combines points
+ * which are span apart.  span must be a multiple of Kernel::Lanes.
+ */
+template<typename Kernel>
+void SpectrumAnalyzer::butterflies(int span)
+{
+    typedef typename Kernel::Vector Vector;
+    const int lanes = Kernel::Lanes;
+
+    const float *const twiddleReal = m_twiddleReal.constData() + span - 1;
+    const float *const twiddleImag = m_twiddleImag.constData() + span - 1;
+
+    for (int group = 0; group < m_halfSize; group += 2 * span) {
+        float *const re = m_real.data() + group;
+        float *const im = m_imag.data() + group;
+
+        for (int k = 0; k < span; k += lanes) {
+            const Vector wr = Kernel::load(twiddleReal + k);
+            const Vector wi = Kernel::load(twiddleImag + k);
+            const Vector br = Kernel::load(re + span + k);
+            const Vector bi = Kernel::load(im + span + k);
+            const Vector tr = Kernel::sub(Kernel::mul(br, wr), Kernel::mul(bi, wi));
+            const Vector ti = Kernel::add(Kernel::mul(br, wi), Kernel::mul(bi, wr));
+            const Vector ar = Kernel::load(re + k);
+            const Vector ai = Kernel::load(im + k);
+            Kernel::store(re + k, Kernel::add(ar, tr));
+            Kernel::store(im + k, Kernel::add(ai, ti));
+            Kernel::store(re + span + k, Kernel::sub(ar, tr));
+            Kernel::store(im + span + k, Kernel::sub(ai, ti));
+        }
+    }
+}
+
+QT_END_NAMESPACE
+
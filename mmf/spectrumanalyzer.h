@@ -0,0 +1,107 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_SPECTRUMANALYZER_H
+#define PHONON_MMF_SPECTRUMANALYZER_H
+
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Magnitude spectrum of blocks of mono samples
+ *
+ * Each block is multiplied by a Hann window, and transformed by a real
+ * FFT: the block is packed into a complex sequence of half its size, which
+ * is transformed by an iterative radix-2 FFT, and then split into the
+ * spectrum of the real input.  The window, bit reversal table and twiddle
+ * factors are calculated on construction, so analysis does not allocate.
+ *
+ * Real and imaginary parts are stored in separate arrays, and the twiddle
+ * factors of each stage are stored contiguously, so that where SSE2 or
+ * NEON is available, the butterflies of each stage are computed several
+ * at a time.
+ */
+class SpectrumAnalyzer
+{
+public:
+    enum Constants
+    {
+        MinSize = 64,
+        MaxSize = 8192
+    };
+
+    /**
+     * Size is the number of samples per block, which must be a power of
+     * two between MinSize and MaxSize.
+     */
+    explicit SpectrumAnalyzer(int size);
+
+    int size() const;
+
+    /**
+     * Number of bins in the spectrum, i.e. size() / 2 + 1.  Bin i is
+     * centred at i * sampleRate / size() Hz.
+     */
+    int binCount() const;
+
+    /**
+     * Writes binCount() magnitudes, scaled so that a full-scale sinusoid
+     * centred on a bin has a magnitude of 1.0 in that bin.
+     */
+    void analyze(const float *samples, float *magnitudes);
+
+    /**
+     * Name of the kernel which is used, e.g. "sse2" or "scalar".
+     */
+    const char *kernelName() const;
+
+private:
+    template<typename Kernel> void butterflies(int span);
+
+private:
+    const int                   m_size;
+    const int                   m_halfSize;
+
+    QVector<float>              m_window;
+    QVector<int>                m_bitReversal;
+
+    // Twiddle factors for the stage whose butterflies span n points start
+    // at index n - 1
+    QVector<float>              m_twiddleReal;
+    QVector<float>              m_twiddleImag;
+
+    // Twiddle factors for splitting the spectrum of the real input
+    QVector<float>              m_splitReal;
+    QVector<float>              m_splitImag;
+
+    QVector<float>              m_real;
+    QVector<float>              m_imag;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,146 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "spectrumtap.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::SpectrumTap
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Number of frames mixed down at a time by write()
+const int       TapFrames = 256;
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::SpectrumTap::SpectrumTap(int channelCount, int capacity, int size)
+    :   m_channelCount(channelCount)
+    ,   m_ring(capacity)
+{
+    Q_ASSERT_X(channelCount > 0, Q_FUNC_INFO, "Invalid channel count");
+    setSize(size);
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+int MMF::SpectrumTap::roundSize(int size)
+{
+    int rounded = SpectrumAnalyzer::MinSize;
+    while (rounded < size && rounded < SpectrumAnalyzer::MaxSize)
+        rounded <<= 1;
+    return rounded;
+}
+
+int MMF::SpectrumTap::channelCount() const
+{
+    return m_channelCount;
+}
+
+int MMF::SpectrumTap::size() const
+{
+    return m_analyzer->size();
+}
+
+const char *MMF::SpectrumTap::kernelName() const
+{
+    return m_analyzer->kernelName();
+}
+
+void MMF::SpectrumTap::write(const float *samples, int frameCount)
+{
+    const float scale = 1.0f / m_channelCount;
+    float mono[TapFrames];
+
+    while (frameCount > 0) {
+        const int frames = qMin(frameCount, TapFrames);
+        for (int f = 0; f < frames; ++f) {
+            float sum = 0.0f;
+            for (int c = 0; c < m_channelCount; ++c)
+                sum += *samples++;
+            mono[f] = sum * scale;
+        }
+        m_ring.write(mono, frames);
+        frameCount -= frames;
+    }
+}
+
+void MMF::SpectrumTap::setSize(int size)
+{
+    const int rounded = roundSize(size);
+
+    if (!m_analyzer || rounded != m_analyzer->size()) {
+        m_analyzer.reset(new SpectrumAnalyzer(rounded));
+
+        // The most recent samples are kept
+        QVector<float> history(rounded, 0.0f);
+        const int kept = qMin(rounded, m_history.count());
+        qCopy(m_history.constEnd() - kept, m_history.constEnd(),
+              history.end() - kept);
+        m_history = history;
+    }
+}
+
+bool MMF::SpectrumTap::analyze(QVector<float> &spectrum, QVector<float> &waveform)
+{
+    const int available = m_ring.available();
+    if (!available)
+        return false;
+
+    const int size = m_history.count();
+    float *const history = m_history.data();
+
+    if (available >= size) {
+        m_ring.skip(available - size);
+        m_ring.read(history, size);
+    } else {
+        qCopy(history + available, history + size, history);
+        m_ring.read(history + size - available, available);
+    }
+
+    spectrum.resize(m_analyzer->binCount());
+    m_analyzer->analyze(history, spectrum.data());
+
+    // The waveform shares the data of the history until the history is
+    // next updated
+    waveform = m_history;
+
+    return true;
+}
+
+void MMF::SpectrumTap::clear()
+{
+    m_ring.skip(m_ring.available());
+    m_history.fill(0.0f);
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,111 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_SPECTRUMTAP_H
+#define PHONON_MMF_SPECTRUMTAP_H
+
+#include <QScopedPointer>
+#include <QVector>
+
+#include "samplering.h"
+#include "spectrumanalyzer.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Mono tap of rendered audio, and analysis of its most recent
+ * samples
+ *
+ * write() is called by the thread which renders the audio.  It mixes each
+ * block down to mono and appends it to a SampleRing, and does nothing
+ * else.  The other functions form the consumer side, which may run in a
+ * different thread: analyze() moves the samples from the ring into a
+ * history of the most recent size() samples, and calculates their
+ * spectrum.  Consumer functions must not be called concurrently with each
+ * other.
+ *
+ * This is the work of Visualization, separated from the rest of the
+ * backend so that it can be built on its own.
+ */
+class SpectrumTap
+{
+public:
+    /**
+     * The ring holds at least capacity samples.  Size is rounded with
+     * roundSize().
+     */
+    SpectrumTap(int channelCount, int capacity, int size);
+
+    /**
+     * Rounds size up to a power of two, between SpectrumAnalyzer::MinSize
+     * and SpectrumAnalyzer::MaxSize.
+     */
+    static int roundSize(int size);
+
+    int channelCount() const;
+    int size() const;
+
+    /**
+     * Name of the kernel used by the analyzer, e.g. "sse2" or "scalar".
+     */
+    const char *kernelName() const;
+
+    /**
+     * Called by the producer.  Samples are interleaved.
+     */
+    void write(const float *samples, int frameCount);
+
+    /**
+     * Changes the size of the history, keeping the most recent samples.
+     */
+    void setSize(int size);
+
+    /**
+     * If samples have been written since the previous call, updates the
+     * history and returns true.  The spectrum then has size() / 2 + 1
+     * bins; see SpectrumAnalyzer::analyze().  The waveform is a copy of
+     * the history, oldest sample first.  Otherwise returns false, and
+     * leaves spectrum and waveform unchanged.
+     */
+    bool analyze(QVector<float> &spectrum, QVector<float> &waveform);
+
+    /**
+     * Discards the samples in the ring and the history.
+     */
+    void clear();
+
+private:
+    const int                           m_channelCount;
+    SampleRing                          m_ring;
+    QScopedPointer<SpectrumAnalyzer>    m_analyzer;
+
+    // Most recent size() samples, oldest first
+    QVector<float>                      m_history;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,244 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+
+#include "dspkernel.h"
+#include "stereowidener.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::StereoWidener
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Number of frames processed between successive updates of the width
+// while the level is ramping
+const int       BlockFrames = 32;
+
+// Gain applied to the side signal at MaxLevel
+const float     MaxWidth = 2.0f;
+
+// State values below this level are flushed to zero, in order to avoid
+// the cost of denormal arithmetic as the crossover decays.
+const float     DenormalThreshold = 1.0e-20f;
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+StereoWidener::StereoWidener(int sampleRate)
+    :   m_sampleRate(sampleRate)
+    ,   m_level(0)
+    ,   m_crossoverFrequency(0)
+    ,   m_crossoverCoefficient(0.0f)
+    ,   m_bassState(0.0f)
+    ,   m_targetWidth(1.0f)
+    ,   m_currentWidth(1.0f)
+    ,   m_widthStep(0.0f)
+    ,   m_rampBlocks(0)
+    ,   m_rampBlockCount(qMax(1, (RampDuration * sampleRate / 1000 + BlockFrames - 1) / BlockFrames))
+    ,   m_block(BlockFrames * ChannelCount)
+    ,   m_bass(BlockFrames * ChannelCount)
+{
+    Q_ASSERT_X(sampleRate > 0, Q_FUNC_INFO, "Invalid sample rate");
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+void StereoWidener::setLevel(qint32 level)
+{
+    m_level = qBound(0, level, int(MaxLevel));
+
+    const float target = width(m_level);
+    if (target != m_targetWidth) {
+        m_targetWidth = target;
+        m_widthStep = (target - m_currentWidth) / m_rampBlockCount;
+        m_rampBlocks = m_rampBlockCount;
+    }
+}
+
+qint32 StereoWidener::level() const
+{
+    return m_level;
+}
+
+void StereoWidener::setCrossoverFrequency(qint32 hz)
+{
+    m_crossoverFrequency = hz;
+    m_crossoverCoefficient = hz > 0 && hz < m_sampleRate / 2
+        ? 1.0 - qExp(-2.0 * M_PI * hz / m_sampleRate) : 0.0;
+    m_bassState = 0.0f;
+}
+
+qint32 StereoWidener::crossoverFrequency() const
+{
+    return m_crossoverFrequency;
+}
+
+void StereoWidener::reset()
+{
+    m_currentWidth = m_targetWidth;
+    m_rampBlocks = 0;
+    m_bassState = 0.0f;
+}
+
+void StereoWidener::process(qint16 *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+void StereoWidener::process(float *samples, int frameCount)
+{
+    processBlocks(samples, frameCount);
+}
+
+const char *StereoWidener::kernelName()
+{
+#ifdef PHONON_MMF_DSP_SIMD
+    return SimdKernel::name();
+#else
+    return ScalarKernel::name();
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+float StereoWidener::width(qint32 level)
+{
+    return 1.0f + (MaxWidth - 1.0f) * level / MaxLevel;
+}
+
+template<typename Sample>
+void StereoWidener::processBlocks(Sample *samples, int frameCount)
+{
+    while (frameCount > 0) {
+        const int blockFrames = qMin(frameCount, BlockFrames);
+        const int sampleCount = blockFrames * ChannelCount;
+
+        if (m_rampBlocks) {
+            if (--m_rampBlocks)
+                m_currentWidth += m_widthStep;
+            else
+                m_currentWidth = m_targetWidth;
+        }
+
+        float *const block = m_block.data();
+        for (int i = 0; i < sampleCount; ++i)
+            block[i] = toFloat(samples[i]);
+
+        if (m_crossoverCoefficient > 0.0f)
+            splitBass(blockFrames);
+        widenBlock(blockFrames);
+
+        for (int i = 0; i < sampleCount; ++i)
+            fromFloat(block[i], samples[i]);
+
+        samples += sampleCount;
+        frameCount -= blockFrames;
+    }
+}
+
+/**
+ * Fills m_bass with the lower band of the side signal of m_block.  This
+ * filter is recursive, so it is not vectorized.
+ */
+void StereoWidener::splitBass(int frameCount)
+{
+    const float *block = m_block.constData();
+    float *bass = m_bass.data();
+    const float k = m_crossoverCoefficient;
+    float state = m_bassState;
+
+    for (int f = 0; f < frameCount; ++f, block += 2, bass += 2) {
+        const float side = 0.5f * (block[0] - block[1]);
+        state += k * (side - state);
+        bass[0] = state;
+        bass[1] = -state;
+    }
+
+    m_bassState = qAbs(state) < DenormalThreshold ? 0.0f : state;
+}
+
+/**
+ * Applies the mid/side matrix to m_block.  With mid M = (L + R) / 2, side
+ * S = (L - R) / 2 and width w, L' = M + wS = aL + bR and R' = aR + bL.
+ * If the crossover is enabled, the gain of the lower band of S is changed
+ * from w to the bass gain g by adding (g - w) times that band.
+ */
+void StereoWidener::widenBlock(int frameCount)
+{
+    const float w = m_currentWidth;
+    const float a = 0.5f * (1.0f + w);
+    const float b = 0.5f * (1.0f - w);
+
+    const bool crossover = m_crossoverCoefficient > 0.0f;
+    const float bassGain = 1.0f - (w - 1.0f) / (MaxWidth - 1.0f);
+    const float c = bassGain - w;
+
+    float *block = m_block.data();
+    const float *bass = m_bass.constData();
+    int f = 0;
+
+#ifdef PHONON_MMF_DSP_SIMD
+    typedef SimdKernel::Vector Vector;
+    const int framesPerVector = SimdKernel::Lanes / ChannelCount;
+    const Vector av = SimdKernel::set(a);
+    const Vector bv = SimdKernel::set(b);
+    const Vector cv = SimdKernel::set(c);
+
+    for ( ; f + framesPerVector <= frameCount; f += framesPerVector) {
+        const Vector v = SimdKernel::load(block);
+        Vector y = SimdKernel::add(SimdKernel::mul(av, v),
+                                   SimdKernel::mul(bv, SimdKernel::swapPairs(v)));
+        if (crossover)
+            y = SimdKernel::add(y, SimdKernel::mul(cv, SimdKernel::load(bass)));
+        SimdKernel::store(block, y);
+        block += SimdKernel::Lanes;
+        bass += SimdKernel::Lanes;
+    }
+#endif
+
+    for ( ; f < frameCount; ++f, block += 2, bass += 2) {
+        const float left = block[0];
+        const float right = block[1];
+        block[0] = a * left + b * right;
+        block[1] = a * right + b * left;
+        if (crossover) {
+            block[0] += c * bass[0];
+            block[1] += c * bass[1];
+        }
+    }
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,127 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_STEREOWIDENER_H
+#define PHONON_MMF_STEREOWIDENER_H
+
+#include <QVector>
+
+#include "audiograph.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short In-process mid/side stereo widener
+ *
+ * The level has the same range as that of CStereoWidening, which is used
+ * by StereoWidening: 0 leaves the signal unchanged, and MaxLevel scales
+ * the side (L - R) signal by MaxWidth relative to the mid (L + R) signal.
+ *
+ * If a crossover frequency is set, the side signal is split by a
+ * first-order crossover, and only its upper band is widened.  The lower
+ * band is narrowed in proportion to the level, so that at MaxLevel the
+ * bass is mono.
+ *
+ * Samples are interleaved 16-bit or floating-point stereo PCM, and are
+ * processed in place.  Where SSE2 or NEON is available, two frames are
+ * processed per vector.  Level changes ramp over RampDuration ms.
+ *
+ * All memory is allocated on construction; process() does not allocate.
+ */
+class StereoWidener : public AudioProcessor
+{
+public:
+    explicit StereoWidener(int sampleRate);
+
+    enum Constants
+    {
+        ChannelCount = 2,
+        MaxLevel = 100,
+        RampDuration = 20 // ms
+    };
+
+    void setLevel(qint32 level);
+    qint32 level() const;
+
+    /**
+     * Sets the crossover frequency in Hz.  Zero, which is the default,
+     * disables the crossover.
+     */
+    void setCrossoverFrequency(qint32 hz);
+    qint32 crossoverFrequency() const;
+
+    /**
+     * Clears the crossover history and completes any ramp in progress.
+     */
+    void reset();
+
+    /**
+     * Processes frameCount interleaved stereo frames in place.
+     */
+    void process(qint16 *samples, int frameCount);
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
+    /**
+     * Name of the kernel which is used, e.g. "sse2" or "scalar".
+     */
+    static const char *kernelName();
+
+private:
+    static float width(qint32 level);
+    template<typename Sample> void processBlocks(Sample *samples, int frameCount);
+    void splitBass(int frameCount);
+    void widenBlock(int frameCount);
+
+private:
+    const int                   m_sampleRate;
+
+    qint32                      m_level;
+    qint32                      m_crossoverFrequency;
+
+    // Coefficient and state of the one-pole low-pass filter which
+    // extracts the lower band of the side signal
+    float                       m_crossoverCoefficient;
+    float                       m_bassState;
+
+    // Widths, i.e. gains applied to the side signal
+    float                       m_targetWidth;
+    float                       m_currentWidth;
+    float                       m_widthStep;
+    int                         m_rampBlocks;
+    const int                   m_rampBlockCount;
+
+    // Interleaved frames of the block being processed
+    QVector<float>              m_block;
+
+    // Lower band of the side signal, interleaved as (+bass, -bass)
+    QVector<float>              m_bass;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
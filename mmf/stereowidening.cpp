@@ -16,7 +16,7 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-#include <StereoWideningBase.h>
+#include "stereowidener.h"
 #include "stereowidening.h"
 
 QT_BEGIN_NAMESPACE
@@ -24,32 +24,48 @@ QT_BEGIN_NAMESPACE
 using namespace Phonon;
 using namespace Phonon::MMF;
 
-// Define functions which depend on concrete native effect class name
-PHONON_MMF_DEFINE_EFFECT_FUNCTIONS(StereoWidening)
-
 /*! \class MMF::StereoWidening
   \internal
 */
 
-StereoWidening::StereoWidening(QObject *parent, const QList<EffectParameter>& parameters)
-    :   AbstractAudioEffect::AbstractAudioEffect(parent, parameters)
+// Crossover frequency of the in-process implementation
+const qint32    CrossoverFrequency = 150; // Hz
+
+StereoWidening::StereoWidening(QObject *parent, const EffectDescriptorPointer &descriptor)
+    :   NativeAudioEffect<CStereoWidening>(parent, descriptor)
 {
 
 }
 
-int StereoWidening::parameterChanged(const EffectParameter &param,
-                                 const QVariant &value)
+int StereoWidening::effectParameterChanged(const EffectParameter &param,
+                                       qint32 internalLevel)
 {
     Q_ASSERT_X(param.id() == ParameterBase, Q_FUNC_INFO, "Invalid parameter ID");
 
-    const qreal externalLevel = value.toReal();
-    const int internalLevel = param.toInternalValue(externalLevel);
-
     TRAPD(err, concreteEffect()->SetStereoWideningLevelL(internalLevel));
 
     return err;
 }
 
+AudioProcessor *StereoWidening::createProcessor(int sampleRate, int channelCount)
+{
+    if (channelCount != StereoWidener::ChannelCount)
+        return 0;
+
+    StereoWidener *const widener = new StereoWidener(sampleRate);
+    widener->setCrossoverFrequency(CrossoverFrequency);
+    return widener;
+}
+
+void StereoWidening::processorParameterChanged(const EffectParameter &param,
+                                               qint32 internalLevel)
+{
+    Q_ASSERT_X(param.id() == ParameterBase, Q_FUNC_INFO, "Invalid parameter ID");
+    Q_UNUSED(param)
+
+    static_cast<StereoWidener *>(m_processor.data())->setLevel(internalLevel);
+}
+
 //-----------------------------------------------------------------------------
 // Static functions
 //-----------------------------------------------------------------------------
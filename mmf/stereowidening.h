@@ -19,9 +19,9 @@ along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PHONON_MMF_STEREOWIDENING_H
 #define PHONON_MMF_STEREOWIDENING_H
 
-#include "abstractaudioeffect.h"
+#include <StereoWideningBase.h>
 
-class CStereoWidening;
+#include "abstractaudioeffect.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -30,13 +30,16 @@ namespace Phonon
 namespace MMF
 {
 /**
- * @short A "bass boost" effect.
+ * @short A stereo widening effect.
+ *
+ * The in-process implementation is StereoWidener, with the crossover
+ * enabled, so that the bass is not widened.
  */
-class StereoWidening : public AbstractAudioEffect
+class StereoWidening : public NativeAudioEffect<CStereoWidening>
 {
     Q_OBJECT
 public:
-    StereoWidening(QObject *parent, const QList<EffectParameter>& parameters);
+    StereoWidening(QObject *parent, const EffectDescriptorPointer &descriptor);
 
     // Static interface required by EffectFactory
     static const char* description();
@@ -45,13 +48,11 @@ public:
 
 protected:
     // AbstractAudioEffect
-    virtual void createEffect(AudioPlayer::NativePlayer *player);
-    virtual int parameterChanged(const EffectParameter &param,
-                                 const QVariant &value);
-
-private:
-    CStereoWidening *concreteEffect();
-
+    virtual int effectParameterChanged(const EffectParameter &param,
+                                       qint32 internalLevel);
+    virtual AudioProcessor *createProcessor(int sampleRate, int channelCount);
+    virtual void processorParameterChanged(const EffectParameter &param,
+                                           qint32 internalLevel);
 };
 }
 }
@@ -0,0 +1,258 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include "biquadequalizer.h"
+#include "fdnreverb.h"
+#include "spectrumtap.h"
+#include "stereowidener.h"
+
+using namespace Phonon::MMF;
+
+/**
+ * Measures the cost of the in-process DSP engines, in milliseconds of
+ * processing per second of audio.  The throughput of the equalizer is
+ * also given in millions of samples per second per band, where a sample
+ * is one channel of one frame.  The stereo widener is measured at 48 kHz
+ * and its cost is also given as a percentage of one core; the exit status
+ * is non-zero if that exceeds 1%.  The kernel is selected at compile time,
+ * so figures for the scalar kernel are obtained by defining
+ * PHONON_MMF_DSP_NO_SIMD, e.g. with -DCMAKE_CXX_FLAGS=-DPHONON_MMF_DSP_NO_SIMD.
+ */
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+const int       SampleRate = 44100;
+
+// The widener is measured at the rate for which its budget is set: below
+// WidenerBudget percent of one core
+const int       WidenerSampleRate = 48000;
+const double    WidenerBudget = 1.0; // percent
+const int       Seconds = 10;
+
+// The block size of the audio graph
+const int       BlockFrames = 1024;
+
+// Each measurement is repeated, and the fastest run is reported
+const int       Runs = 3;
+
+// The default frame rate of Visualization
+const int       FrameRate = 30;
+
+
+//-----------------------------------------------------------------------------
+// Visualization
+//-----------------------------------------------------------------------------
+
+/**
+ * Does the work of Visualization, which cannot be built without the rest
+ * of the backend: each block is written to a SpectrumTap, and FrameRate
+ * times per second the tap is analyzed.  Visualization runs the analysis
+ * in a worker thread; here it is run inline, so that its cost is counted.
+ */
+class VisualizationLoad : public AudioProcessor
+{
+public:
+    VisualizationLoad(int channelCount, int size)
+        :   m_tap(channelCount, SampleRate, size)
+        ,   m_framesToAnalysis(SampleRate / FrameRate)
+    {
+
+    }
+
+    const char *kernelName() const
+    {
+        return m_tap.kernelName();
+    }
+
+    virtual void process(float *samples, int frameCount)
+    {
+        m_tap.write(samples, frameCount);
+
+        m_framesToAnalysis -= frameCount;
+        if (m_framesToAnalysis <= 0) {
+            m_framesToAnalysis += SampleRate / FrameRate;
+            m_tap.analyze(m_spectrum, m_waveform);
+        }
+    }
+
+private:
+    SpectrumTap                 m_tap;
+    QVector<float>              m_spectrum;
+    QVector<float>              m_waveform;
+    int                         m_framesToAnalysis;
+
+};
+
+
+//-----------------------------------------------------------------------------
+// Benchmarks
+//-----------------------------------------------------------------------------
+
+static QVector<float> testSignal(int channelCount, int sampleRate)
+{
+    QVector<float> samples(Seconds * sampleRate * channelCount);
+    for (int i = 0; i < samples.count(); ++i) {
+        const int frame = i / channelCount;
+        const int channel = i % channelCount;
+        samples[i] = 0.3f * qSin(0.013 * (channel + 1) * frame)
+                   + 0.1f * qSin(0.9 * frame);
+    }
+    return samples;
+}
+
+/**
+ * Runs processor over the test signal in blocks, as the audio graph does,
+ * and returns the time taken in nanoseconds.
+ */
+static qint64 measure(AudioProcessor &processor, int channelCount,
+                      int sampleRate = SampleRate)
+{
+    const QVector<float> signal = testSignal(channelCount, sampleRate);
+    qint64 best = 0;
+
+    for (int run = 0; run < Runs; ++run) {
+        QVector<float> samples = signal;
+        float *data = samples.data();
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int frame = 0; frame < Seconds * sampleRate; frame += BlockFrames) {
+            const int frames = qMin(BlockFrames, Seconds * sampleRate - frame);
+            processor.process(data + frame * channelCount, frames);
+        }
+        const qint64 nsecs = timer.nsecsElapsed();
+
+        if (!run || nsecs < best)
+            best = nsecs;
+    }
+
+    return qMax(qint64(1), best);
+}
+
+static void report(const char *name, const char *kernel, qint64 nsecs)
+{
+    qWarning("%-40s %-8s %7.3f ms per s", name, kernel, nsecs / (1.0e6 * Seconds));
+}
+
+static void benchmarkEqualizer()
+{
+    // The bands of a typical CAudioEqualizer
+    const int frequencies[] = { 60, 230, 910, 3600, 14000, 80, 500, 8000 };
+
+    const int channelCounts[] = { 1, 2, 6 };
+
+    for (int c = 0; c < 3; ++c) {
+        const int channelCount = channelCounts[c];
+        for (int bandCount = 5; bandCount <= 8; bandCount += 3) {
+            QVector<BiquadEqualizer::Band> bands;
+            for (int i = 0; i < bandCount; ++i)
+                bands.append(BiquadEqualizer::Band(frequencies[i]));
+
+            BiquadEqualizer equalizer(SampleRate, channelCount, bands);
+            for (int i = 0; i < bandCount; ++i)
+                equalizer.setBandLevel(i, i % 2 ? -600 : 900);
+            equalizer.reset();
+
+            const qint64 nsecs = measure(equalizer, channelCount);
+            const qint64 samples = qint64(Seconds) * SampleRate * channelCount;
+
+            char name[64];
+            qsnprintf(name, sizeof(name), "BiquadEqualizer, %d bands, %d ch",
+                      bandCount, channelCount);
+            qWarning("%-40s %-8s %7.3f ms per s %7.1f Msamples/s per band",
+                     name, equalizer.kernelName(), nsecs / (1.0e6 * Seconds),
+                     1.0e3 * samples * bandCount / nsecs);
+        }
+    }
+}
+
+static void benchmarkReverb()
+{
+    for (int channelCount = 1; channelCount <= FdnReverb::MaxChannelCount; ++channelCount) {
+        FdnReverb reverb(SampleRate, channelCount);
+        reverb.setParameter(FdnReverb::DecayTime, 2500);
+        reverb.setParameter(FdnReverb::Density, 100);
+        reverb.setParameter(FdnReverb::Diffusion, 100);
+        reverb.setParameter(FdnReverb::ReverbLevel, -800);
+
+        char name[64];
+        qsnprintf(name, sizeof(name), "FdnReverb, %d ch", channelCount);
+        report(name, reverb.kernelName(), measure(reverb, channelCount));
+    }
+}
+
+/**
+ * Returns false if the widener exceeds its budget at WidenerSampleRate.
+ */
+static bool benchmarkWidener()
+{
+    const int crossoverFrequencies[] = { 0, 150 };
+    bool withinBudget = true;
+
+    for (int i = 0; i < 2; ++i) {
+        StereoWidener widener(WidenerSampleRate);
+        widener.setCrossoverFrequency(crossoverFrequencies[i]);
+        widener.setLevel(70);
+        widener.reset();
+
+        const qint64 nsecs = measure(widener, StereoWidener::ChannelCount,
+                                     WidenerSampleRate);
+        const double percent = nsecs / (1.0e7 * Seconds);
+
+        char name[64];
+        qsnprintf(name, sizeof(name), "StereoWidener, crossover %d Hz, %d kHz",
+                  crossoverFrequencies[i], WidenerSampleRate / 1000);
+        qWarning("%-40s %-8s %7.3f ms per s %7.3f%% of one core%s",
+                 name, widener.kernelName(), nsecs / (1.0e6 * Seconds), percent,
+                 percent < WidenerBudget ? "" : " (over budget)");
+
+        withinBudget &= (percent < WidenerBudget);
+    }
+
+    return withinBudget;
+}
+
+static void benchmarkVisualization()
+{
+    for (int size = 1024; size <= 4096; size *= 4) {
+        VisualizationLoad load(2, size);
+
+        char name[64];
+        qsnprintf(name, sizeof(name), "Visualization, FFT size %d, 2 ch", size);
+        report(name, load.kernelName(), measure(load, 2));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
+    benchmarkEqualizer();
+    benchmarkReverb();
+    const bool widenerWithinBudget = benchmarkWidener();
+    benchmarkVisualization();
+
+    return widenerWithinBudget ? 0 : 1;
+}
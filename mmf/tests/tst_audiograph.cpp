@@ -0,0 +1,201 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+#include <QString>
+#include <QVector>
+
+#include "audiograph.h"
+#include "wavfile.h"
+
+using namespace Phonon::MMF;
+
+/**
+ * Renders a graph with a shared stage, two outputs and a monitor to a WAVE
+ * file, and compares the file with the expected output.
+ */
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+const int       SampleRate = 44100;
+const int       ChannelCount = 2;
+const int       BlockFrames = 256;
+
+// Not a whole number of blocks, so that the end of the source is padded
+const int       SourceFrames = 10 * BlockFrames + 100;
+const int       RenderFrames = 12 * BlockFrames;
+
+// Half a least significant bit of the 16-bit output, plus rounding error
+const float     Tolerance = 0.6f / 32768;
+
+
+//-----------------------------------------------------------------------------
+// Test nodes
+//-----------------------------------------------------------------------------
+
+class ToneSource : public AudioSource
+{
+public:
+    ToneSource() : m_position(0) { }
+
+    static float sample(int frame, int channel)
+    {
+        const float amplitude = channel ? 0.25f : 0.5f;
+        return amplitude * qSin(2.0 * M_PI * 440.0 * frame / SampleRate);
+    }
+
+    virtual int readAudio(float *samples, int frameCount)
+    {
+        const int frames = qMin(frameCount, SourceFrames - m_position);
+        for (int f = 0; f < frames; ++f, ++m_position)
+            for (int c = 0; c < ChannelCount; ++c)
+                *samples++ = sample(m_position, c);
+        return frames;
+    }
+
+    virtual bool isPlaying() const
+    {
+        return m_position < SourceFrames;
+    }
+
+private:
+    int m_position;
+};
+
+class Gain : public AudioProcessor
+{
+public:
+    Gain(float gain) : m_gain(gain), m_blockCount(0) { }
+
+    virtual void process(float *samples, int frameCount)
+    {
+        for (int i = 0; i < frameCount * ChannelCount; ++i)
+            samples[i] *= m_gain;
+        ++m_blockCount;
+    }
+
+    int blockCount() const
+    {
+        return m_blockCount;
+    }
+
+private:
+    const float m_gain;
+    int m_blockCount;
+};
+
+
+//-----------------------------------------------------------------------------
+// Test
+//-----------------------------------------------------------------------------
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition) {
+        qWarning("FAIL: %s", description);
+        ++failures;
+    }
+}
+
+/**
+ * Returns the rendered samples, or an empty vector if rendering failed.
+ */
+static QVector<float> render(const QString &fileName)
+{
+    //  source -> half -> output
+    //                 -> half -> output
+    //                 -> monitor
+    //         -> output
+    // so the expected output is (0.5 + 0.25 + 1.0) * source.
+    Gain half(0.5f);
+    Gain quarter(0.5f);
+    Gain monitor(0.0f);
+
+    QList<AudioGraph::Stage> stages;
+    stages.append(AudioGraph::Stage(&half, -1, false));
+    stages.append(AudioGraph::Stage(0, 0, true));
+    stages.append(AudioGraph::Stage(&quarter, 0, false));
+    stages.append(AudioGraph::Stage(0, 2, true));
+    stages.append(AudioGraph::Stage(&monitor, 0, false));
+    stages.append(AudioGraph::Stage(0, -1, true));
+
+    ToneSource source;
+    AudioGraph graph(SampleRate, ChannelCount, BlockFrames);
+    const int route = graph.createRoute();
+    graph.addSource(route, &source);
+    graph.setStages(route, stages);
+
+    {
+        WavFileSink sink(fileName, SampleRate, ChannelCount);
+        check(sink.open(), "open sink");
+        graph.setSink(&sink);
+        graph.render(RenderFrames);
+        graph.setSink(0);
+    }
+
+    // Blocks after the end of the source are not processed
+    const int playedBlocks = (SourceFrames + BlockFrames - 1) / BlockFrames;
+    check(half.blockCount() == playedBlocks, "shared stage processed once per block");
+    check(quarter.blockCount() == playedBlocks, "branch processed once per block");
+    check(monitor.blockCount() == playedBlocks, "monitor processed once per block");
+
+    QFile file(fileName);
+    WavReader reader;
+    QVector<float> samples;
+    if (file.open(QIODevice::ReadOnly) && reader.open(&file)) {
+        check(reader.sampleRate() == SampleRate, "sample rate");
+        check(reader.channelCount() == ChannelCount, "channel count");
+        check(reader.frameCount() == RenderFrames, "frame count");
+        samples.resize(RenderFrames * ChannelCount);
+        samples.resize(reader.read(samples.data(), RenderFrames) * ChannelCount);
+    } else {
+        check(false, "open rendered file");
+    }
+
+    return samples;
+}
+
+int main(int argc, char *argv[])
+{
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
+    const QVector<float> first = render(QLatin1String("tst_audiograph_1.wav"));
+    check(first.count() == RenderFrames * ChannelCount, "rendered length");
+
+    float maxError = 0.0f;
+    for (int i = 0; i < first.count(); ++i) {
+        const int frame = i / ChannelCount;
+        const float expected = frame < SourceFrames
+            ? 1.75f * ToneSource::sample(frame, i % ChannelCount) : 0.0f;
+        maxError = qMax(maxError, qAbs(first.at(i) - expected));
+    }
+    check(maxError <= Tolerance, "rendered samples");
+
+    // Rendering is deterministic
+    const QVector<float> second = render(QLatin1String("tst_audiograph_2.wav"));
+    check(first == second, "second rendering");
+
+    qWarning("%s: max error %g, %d failures", failures ? "FAIL" : "PASS",
+             maxError, failures);
+    return failures ? 1 : 0;
+}
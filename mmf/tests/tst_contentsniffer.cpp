@@ -0,0 +1,200 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QElapsedTimer>
+#include <QList>
+
+#include <string.h>
+
+#include "contentsniffer.h"
+
+using namespace Phonon::MMF;
+
+/**
+ * Classifies a corpus of clip headers built from the magic numbers of the
+ * supported containers, and measures the throughput of the sniffer.
+ */
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+const int       BenchmarkRounds = 20000;
+
+const uchar     AsfHeaderGuid[] = {
+    0x30, 0x26, 0xB2, 0x75, 0x8E, 0x66, 0xCF, 0x11,
+    0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C
+};
+
+const uchar     AsfAudioMediaGuid[] = {
+    0x40, 0x9E, 0x69, 0xF8, 0x4D, 0x5B, 0xCF, 0x11,
+    0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B
+};
+
+const uchar     AsfVideoMediaGuid[] = {
+    0xC0, 0xEF, 0x19, 0xBC, 0x4D, 0x5B, 0xCF, 0x11,
+    0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B
+};
+
+
+//-----------------------------------------------------------------------------
+// Corpus
+//-----------------------------------------------------------------------------
+
+/**
+ * Leading bytes of a clip, which are zero except where set by put().
+ */
+class Clip
+{
+public:
+    Clip(const char *name, MediaType expected, const char *suffix = 0)
+        :   m_name(name)
+        ,   m_expected(expected)
+        ,   m_suffix(suffix)
+        ,   m_size(ContentSniffer::HeaderSize)
+    {
+        memset(m_data, 0, sizeof(m_data));
+    }
+
+    Clip &put(int offset, const void *bytes, int length)
+    {
+        memcpy(m_data + offset, bytes, length);
+        return *this;
+    }
+
+    // For string literals, without the terminating null
+    template<int N>
+    Clip &put(int offset, const char (&bytes)[N])
+    {
+        return put(offset, bytes, N - 1);
+    }
+
+    Clip &truncate(int size)
+    {
+        m_size = size;
+        return *this;
+    }
+
+    const char *        m_name;
+    MediaType           m_expected;
+    const char *        m_suffix;
+    int                 m_size;
+    uchar               m_data[ContentSniffer::HeaderSize];
+};
+
+static QList<Clip> corpus()
+{
+    QList<Clip> clips;
+
+    // MPEG audio
+    clips.append(Clip("ID3v2 tag", MediaTypeAudio).put(0, "ID3\x03\x00\x00\x00\x00\x10\x00"));
+    clips.append(Clip("MPEG-1 layer III frame", MediaTypeAudio).put(0, "\xFF\xFB\x90\x64"));
+    clips.append(Clip("MPEG-2 layer III frame", MediaTypeAudio).put(0, "\xFF\xF3\x84\xC4"));
+    clips.append(Clip("ADTS AAC frame", MediaTypeAudio).put(0, "\xFF\xF1\x50\x80\x2E\x7F\xFC"));
+    clips.append(Clip("reserved MPEG header", MediaTypeUnknown).put(0, "\xFF\xFF\xFF\xFF"));
+
+    // ISO base media
+    clips.append(Clip("ftyp M4A", MediaTypeAudio).put(0, "\x00\x00\x00\x20" "ftypM4A \x00\x00\x00\x00"));
+    clips.append(Clip("ftyp M4B", MediaTypeAudio).put(0, "\x00\x00\x00\x20" "ftypM4B \x00\x00\x00\x00"));
+    clips.append(Clip("ftyp isom", MediaTypeVideo).put(0, "\x00\x00\x00\x20" "ftypisom\x00\x00\x02\x00"));
+    clips.append(Clip("ftyp isom .m4a", MediaTypeAudio, "m4a").put(0, "\x00\x00\x00\x20" "ftypisom\x00\x00\x02\x00"));
+    clips.append(Clip("ftyp mp42 .mp4", MediaTypeVideo, "mp4").put(0, "\x00\x00\x00\x18" "ftypmp42\x00\x00\x00\x00"));
+    clips.append(Clip("ftyp 3gp4", MediaTypeVideo).put(0, "\x00\x00\x00\x18" "ftyp3gp4\x00\x00\x02\x00"));
+    clips.append(Clip("ftyp 3gp4 .amr", MediaTypeAudio, "amr").put(0, "\x00\x00\x00\x18" "ftyp3gp4\x00\x00\x02\x00"));
+
+    // RIFF
+    clips.append(Clip("RIFF WAVE", MediaTypeAudio).put(0, "RIFF\x24\x08\x00\x00WAVEfmt "));
+    clips.append(Clip("RIFF RMID", MediaTypeAudio).put(0, "RIFF\x24\x08\x00\x00RMIDdata"));
+    clips.append(Clip("RIFF AVI", MediaTypeVideo).put(0, "RIFF\x24\x08\x00\x00" "AVI LIST"));
+    clips.append(Clip("RIFF other", MediaTypeUnknown).put(0, "RIFF\x24\x08\x00\x00" "CDXAfmt "));
+
+    // Ogg: the first packet follows a one-entry segment table
+    clips.append(Clip("Ogg Vorbis", MediaTypeAudio).put(0, "OggS\x00\x02").put(26, "\x01\x1E\x01vorbis"));
+    clips.append(Clip("Ogg Opus", MediaTypeAudio).put(0, "OggS\x00\x02").put(26, "\x01\x13OpusHead"));
+    clips.append(Clip("Ogg FLAC", MediaTypeAudio).put(0, "OggS\x00\x02").put(26, "\x01\x33\x7F" "FLAC"));
+    clips.append(Clip("Ogg Theora", MediaTypeVideo).put(0, "OggS\x00\x02").put(26, "\x01\x2A\x80theora"));
+    clips.append(Clip("Ogg other .ogv", MediaTypeVideo, "ogv").put(0, "OggS\x00\x02").put(26, "\x01\x10" "fishead"));
+    clips.append(Clip("Ogg other", MediaTypeAudio).put(0, "OggS\x00\x02").put(26, "\x01\x10" "fishead"));
+
+    // ASF: stream properties objects follow the header object
+    clips.append(Clip("ASF video", MediaTypeVideo)
+        .put(0, AsfHeaderGuid, 16).put(200, AsfAudioMediaGuid, 16).put(320, AsfVideoMediaGuid, 16));
+    clips.append(Clip("ASF audio", MediaTypeAudio)
+        .put(0, AsfHeaderGuid, 16).put(200, AsfAudioMediaGuid, 16));
+    clips.append(Clip("ASF .wma", MediaTypeAudio, "wma").put(0, AsfHeaderGuid, 16));
+    clips.append(Clip("ASF", MediaTypeVideo).put(0, AsfHeaderGuid, 16));
+
+    // FLV: flags 0x04 = audio, 0x01 = video
+    clips.append(Clip("FLV audio", MediaTypeAudio).put(0, "FLV\x01\x04\x00\x00\x00\x09"));
+    clips.append(Clip("FLV audio and video", MediaTypeVideo).put(0, "FLV\x01\x05\x00\x00\x00\x09"));
+
+    // Others
+    clips.append(Clip("AMR-NB", MediaTypeAudio).put(0, "#!AMR\n"));
+    clips.append(Clip("AMR-WB", MediaTypeAudio).put(0, "#!AMR-WB\n"));
+    clips.append(Clip("MIDI", MediaTypeAudio).put(0, "MThd\x00\x00\x00\x06"));
+
+    // Unrecognized and truncated data
+    clips.append(Clip("HTML", MediaTypeUnknown).put(0, "<!DOCTYPE html>"));
+    clips.append(Clip("zeros", MediaTypeUnknown));
+    clips.append(Clip("empty", MediaTypeUnknown).put(0, "ID3").truncate(0));
+    clips.append(Clip("truncated RIFF", MediaTypeUnknown).put(0, "RIFF\x24\x08").truncate(6));
+    clips.append(Clip("truncated ftyp", MediaTypeUnknown).put(0, "\x00\x00\x00\x20" "fty").truncate(7));
+    clips.append(Clip("truncated MPEG frame", MediaTypeUnknown).put(0, "\xFF\xFB\x90").truncate(3));
+
+    return clips;
+}
+
+
+//-----------------------------------------------------------------------------
+// Test
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
+    const QList<Clip> clips = corpus();
+
+    int failures = 0;
+    foreach (const Clip &clip, clips) {
+        const MediaType type = ContentSniffer::sniff(clip.m_data, clip.m_size, clip.m_suffix);
+        if (type != clip.m_expected) {
+            qWarning("FAIL: %s: expected %d, got %d", clip.m_name, clip.m_expected, type);
+            ++failures;
+        }
+    }
+
+    // Throughput, over whole headers as passed by MediaObject
+    QElapsedTimer timer;
+    timer.start();
+    int checksum = 0;
+    for (int round = 0; round < BenchmarkRounds; ++round)
+        foreach (const Clip &clip, clips)
+            checksum += ContentSniffer::sniff(clip.m_data, clip.m_size, clip.m_suffix);
+    const qint64 nsecs = qMax(qint64(1), timer.nsecsElapsed());
+
+    const qint64 calls = qint64(BenchmarkRounds) * clips.count();
+    qWarning("sniff: %.1f ns per header, %.0f MB/s of headers (checksum %d)",
+             double(nsecs) / calls,
+             1000.0 * calls * ContentSniffer::HeaderSize / nsecs, checksum);
+
+    qWarning("%s: %d clips, %d failures", failures ? "FAIL" : "PASS",
+             clips.count(), failures);
+    return failures ? 1 : 0;
+}
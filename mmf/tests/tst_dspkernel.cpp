@@ -0,0 +1,245 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtCore/qmath.h>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "biquadequalizer.h"
+#include "shelffilter.h"
+
+using namespace Phonon::MMF;
+
+/**
+ * Checks the response of BiquadEqualizer at a band center, and that a flat
+ * equalizer passes samples through unchanged.  The output of a set of
+ * equalizer and shelf filter scenarios is then written to a file.  This
+ * test is built twice, once with the SIMD kernel and once with
+ * PHONON_MMF_DSP_NO_SIMD, and the two files are compared, so that the
+ * SIMD kernels are checked to match the scalar kernel bit for bit.
+ */
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+const int       SampleRate = 44100;
+const int       MaxChannelCount = 6;
+const int       MaxBandCount = 5;
+const qint32    BandFrequencies[MaxBandCount] = { 60, 230, 910, 3600, 14000 };
+
+// Level of the band whose response is measured
+const qint32    CenterLevel = 600; // mB
+const qreal     CenterTolerance = 0.01; // dB
+
+// Length of each scenario which is written to the output file
+const int       ScenarioFrames = 3000;
+
+// Scenarios are processed in blocks of varying size, so that the SIMD
+// kernels' handling of partial vectors and steps is exercised.
+const int       BlockSizes[] = { 1, 7, 32, 33, 100, 257, 1000 };
+const int       BlockSizeCount = sizeof(BlockSizes) / sizeof(BlockSizes[0]);
+
+
+//-----------------------------------------------------------------------------
+// Test
+//-----------------------------------------------------------------------------
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition) {
+        qWarning("FAIL: %s", description);
+        ++failures;
+    }
+}
+
+static QVector<BiquadEqualizer::Band> bands(int bandCount)
+{
+    QVector<BiquadEqualizer::Band> result;
+    for (int i = 0; i < bandCount; ++i)
+        result.append(BiquadEqualizer::Band(BandFrequencies[i]));
+    return result;
+}
+
+static QVector<float> testSignal(int channelCount, int frameCount)
+{
+    QVector<float> samples(frameCount * channelCount);
+    for (int i = 0; i < samples.count(); ++i) {
+        const int frame = i / channelCount;
+        const int channel = i % channelCount;
+        samples[i] = 0.3f * qSin(0.013 * (channel + 1) * frame)
+                   + 0.1f * qSin(0.9 * frame);
+    }
+    return samples;
+}
+
+/**
+ * A band at +600 mB raises a tone at its center frequency by 6.00 dB.
+ */
+static void checkCenterResponse(int channelCount)
+{
+    const int band = 2;
+    BiquadEqualizer equalizer(SampleRate, channelCount, bands(MaxBandCount));
+    equalizer.setBandLevel(band, CenterLevel);
+    equalizer.reset();
+
+    // One second, of which the second half is measured, once the filters
+    // have settled
+    const qreal step = 2.0 * M_PI * BandFrequencies[band] / SampleRate;
+    QVector<float> samples(SampleRate * channelCount);
+    for (int i = 0; i < samples.count(); ++i)
+        samples[i] = 0.25f * qSin(step * (i / channelCount));
+    const QVector<float> input = samples;
+    equalizer.process(samples.data(), SampleRate);
+
+    for (int c = 0; c < channelCount; ++c) {
+        qreal inputPower = 0.0;
+        qreal outputPower = 0.0;
+        for (int f = SampleRate / 2; f < SampleRate; ++f) {
+            inputPower += qreal(input[f * channelCount + c]) * input[f * channelCount + c];
+            outputPower += qreal(samples[f * channelCount + c]) * samples[f * channelCount + c];
+        }
+        const qreal gain = 10.0 * log10(outputPower / inputPower);
+        check(qAbs(gain - CenterLevel / 100.0) < CenterTolerance, "band center response");
+    }
+}
+
+/**
+ * A flat equalizer passes samples through unchanged.
+ */
+static void checkFlatBypass(int channelCount)
+{
+    BiquadEqualizer equalizer(SampleRate, channelCount, bands(MaxBandCount));
+
+    const QVector<float> input = testSignal(channelCount, ScenarioFrames);
+    QVector<float> samples = input;
+    equalizer.process(samples.data(), ScenarioFrames);
+    check(samples == input, "flat bypass, float");
+
+    QVector<qint16> input16(input.count());
+    for (int i = 0; i < input.count(); ++i)
+        input16[i] = qint16(input[i] * 20000);
+    QVector<qint16> samples16 = input16;
+    equalizer.process(samples16.data(), ScenarioFrames);
+    check(samples16 == input16, "flat bypass, 16-bit");
+}
+
+static void write(QFile &file, const QVector<float> &samples)
+{
+    file.write(reinterpret_cast<const char *>(samples.constData()),
+               samples.count() * sizeof(float));
+}
+
+/**
+ * Writes the output of each equalizer scenario to file.
+ */
+static void writeEqualizerScenarios(QFile &file, int channelCount, int bandCount)
+{
+    const QVector<float> input = testSignal(channelCount, ScenarioFrames);
+
+    // Level changes, which ramp, part way through
+    {
+        BiquadEqualizer equalizer(SampleRate, channelCount, bands(bandCount));
+        for (int b = 0; b < bandCount; ++b)
+            equalizer.setBandLevel(b, b % 2 ? -900 : 1200);
+
+        QVector<float> samples = input;
+        for (int frame = 0, k = 0; frame < ScenarioFrames; ++k) {
+            const int frames = qMin(BlockSizes[k % BlockSizeCount], ScenarioFrames - frame);
+            if (3 == k) {
+                equalizer.setBandLevel(0, -1500);
+                if (bandCount > 2)
+                    equalizer.setBandLevel(2, 0);
+            }
+            equalizer.process(samples.data() + frame * channelCount, frames);
+            frame += frames;
+        }
+        write(file, samples);
+    }
+
+    // 16-bit samples
+    {
+        BiquadEqualizer equalizer(SampleRate, channelCount, bands(bandCount));
+        for (int b = 0; b < bandCount; ++b)
+            equalizer.setBandLevel(b, b % 2 ? 600 : -300);
+        equalizer.reset();
+
+        QVector<qint16> samples16(input.count());
+        for (int i = 0; i < input.count(); ++i)
+            samples16[i] = qint16(input[i] * 20000);
+        equalizer.process(samples16.data(), ScenarioFrames);
+
+        QVector<float> samples(samples16.count());
+        for (int i = 0; i < samples16.count(); ++i)
+            samples[i] = samples16[i];
+        write(file, samples);
+    }
+}
+
+/**
+ * Writes the output of each shelf filter scenario to file.
+ */
+static void writeShelfScenarios(QFile &file, int channelCount)
+{
+    const QVector<float> input = testSignal(channelCount, ScenarioFrames);
+
+    // Up to one more section than the loudness compensator uses
+    for (int sectionCount = 1; sectionCount <= 3; ++sectionCount) {
+        ShelfFilter filter(channelCount, sectionCount);
+        for (int s = 0; s < sectionCount; ++s)
+            filter.setCoefficients(s, ShelfFilter::design(
+                s % 2 ? ShelfFilter::HighShelf : ShelfFilter::LowShelf,
+                200 + 3000 * s, 800 - 500 * s, SampleRate));
+
+        QVector<float> samples = input;
+        for (int frame = 0; frame < ScenarioFrames; frame += 91)
+            filter.process(samples.data() + frame * channelCount,
+                           qMin(91, ScenarioFrames - frame));
+        write(file, samples);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        qWarning("usage: %s output-file", argv[0]);
+        return 2;
+    }
+
+    for (int channelCount = 1; channelCount <= MaxChannelCount; ++channelCount) {
+        checkCenterResponse(channelCount);
+        checkFlatBypass(channelCount);
+    }
+
+    QFile file(QString::fromLocal8Bit(argv[1]));
+    check(file.open(QIODevice::WriteOnly | QIODevice::Truncate), "open output file");
+    for (int channelCount = 1; channelCount <= MaxChannelCount; ++channelCount) {
+        for (int bandCount = 1; bandCount <= MaxBandCount; ++bandCount)
+            writeEqualizerScenarios(file, channelCount, bandCount);
+        writeShelfScenarios(file, channelCount);
+    }
+    file.close();
+
+    BiquadEqualizer equalizer(SampleRate, 2, bands(MaxBandCount));
+    qWarning("%s: kernel %s, %d failures", failures ? "FAIL" : "PASS",
+             equalizer.kernelName(), failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+
+#include "biquadequalizer.h"
+#include "effectpresetbank.h"
+
+using namespace Phonon::MMF;
+
+/**
+ * Loads a preset file into an EffectPresetBank, checks that presets which
+ * are not valid for the effect are skipped, and applies a preset to a
+ * BiquadEqualizer in the same way as AudioEqualizer does.
+ */
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// EffectFactory::Type
+const int       TypeAudioEqualizer = 0;
+const int       TypeStereoWidening = 7;
+
+// AbstractAudioEffect::CommonParameters
+const int       ParameterEnable = 0;
+const int       ParameterBase = 1;
+
+const int       BandCount = 5;
+const qint32    BandFrequencies[BandCount] = { 60, 230, 910, 3600, 14000 };
+const qint32    LevelMinimum = -1200; // mB
+const qint32    LevelMaximum = 1200; // mB
+
+const qint32    RockLevels[BandCount] = { 600, 300, -200, 300, 900 };
+
+const int       SampleRate = 44100;
+const int       ChannelCount = 2;
+
+
+//-----------------------------------------------------------------------------
+// Test data
+//-----------------------------------------------------------------------------
+
+/**
+ * Descriptor with the same parameters as those which
+ * AudioEqualizer::getParameters() reports for a five-band equalizer.
+ */
+static EffectDescriptorPointer equalizerDescriptor()
+{
+    QList<EffectParameter> parameters;
+    parameters.append(EffectParameter(ParameterEnable, QLatin1String("Enabled"),
+        EffectParameter::ToggledHint, QVariant(bool(true))));
+
+    for (int i = 0; i < BandCount; ++i) {
+        EffectParameter param(ParameterBase + i,
+            QString::fromLatin1("%1 Hz").arg(BandFrequencies[i]),
+            EffectParameter::LogarithmicHint, QVariant(qreal(0.0)),
+            QVariant(qreal(-1.0)), QVariant(qreal(+1.0)));
+        param.setInternalRange(LevelMinimum, LevelMaximum);
+        param.setFrequency(BandFrequencies[i]);
+        parameters.append(param);
+    }
+
+    return EffectDescriptorPointer(new EffectDescriptor(parameters));
+}
+
+static void writePreset(QDataStream &stream, int type, const char *name,
+                        const QMap<int, qint32> &values)
+{
+    stream << qint32(type) << QString::fromLatin1(name) << qint32(values.count());
+    QMap<int, qint32>::const_iterator i = values.begin();
+    for ( ; i != values.end(); ++i)
+        stream << qint32(i.key()) << i.value();
+}
+
+static bool writePresetFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << quint32(EffectPresetBank::FileMagic)
+           << quint32(EffectPresetBank::FileVersion) << qint32(5);
+
+    QMap<int, qint32> rock;
+    for (int i = 0; i < BandCount; ++i)
+        rock.insert(ParameterBase + i, RockLevels[i]);
+    writePreset(stream, TypeAudioEqualizer, "Rock", rock);
+
+    // Unknown parameter ID
+    QMap<int, qint32> unknown;
+    unknown.insert(ParameterBase + BandCount, 0);
+    writePreset(stream, TypeAudioEqualizer, "Unknown", unknown);
+
+    // Level outside the range supported by the platform
+    QMap<int, qint32> loud;
+    loud.insert(ParameterBase, LevelMaximum + 1);
+    writePreset(stream, TypeAudioEqualizer, "Loud", loud);
+
+    // Effect which is not supported
+    writePreset(stream, TypeStereoWidening, "Wide", QMap<int, qint32>());
+
+    // Only the enable parameter; the bands take their defaults
+    QMap<int, qint32> off;
+    off.insert(ParameterEnable, 0);
+    writePreset(stream, TypeAudioEqualizer, "Off", off);
+
+    return QDataStream::Ok == stream.status();
+}
+
+
+//-----------------------------------------------------------------------------
+// Test
+//-----------------------------------------------------------------------------
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition) {
+        qWarning("FAIL: %s", description);
+        ++failures;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
+    const EffectDescriptorPointer descriptor = equalizerDescriptor();
+    QHash<int, EffectDescriptorPointer> descriptors;
+    descriptors.insert(TypeAudioEqualizer, descriptor);
+
+    const QString fileName = QDir::tempPath() + QLatin1String("/tst_effectpreset.presets");
+    check(writePresetFile(fileName), "write preset file");
+
+    EffectPresetBank bank;
+    check(bank.load(fileName, descriptors), "load preset file");
+    check(bank.names(TypeAudioEqualizer)
+          == (QStringList() << QLatin1String("Rock") << QLatin1String("Off")),
+          "invalid presets skipped");
+    check(bank.names(TypeStereoWidening).isEmpty(), "unsupported effect skipped");
+    check(!bank.preset(TypeAudioEqualizer, QLatin1String("Loud")), "out of range preset skipped");
+
+    // Files with a different header are rejected
+    check(!bank.load(QDir::tempPath() + QLatin1String("/tst_effectpreset.missing"), descriptors),
+          "missing file rejected");
+    {
+        QFile file(fileName);
+        check(file.open(QIODevice::WriteOnly | QIODevice::Truncate), "rewrite preset file");
+        QDataStream stream(&file);
+        stream << quint32(0) << quint32(EffectPresetBank::FileVersion) << qint32(0);
+    }
+    check(!bank.load(fileName, descriptors), "bad header rejected");
+    QFile::remove(fileName);
+
+    // External values span -1.0 to +1.0 across the internal range
+    const EffectPreset *const off = bank.preset(TypeAudioEqualizer, QLatin1String("Off"));
+    check(off, "Off preset found");
+    if (off) {
+        check(0 == off->internalValue(0), "toggle value");
+        check(false == off->externalValue(0).toBool(), "toggle value");
+        for (int i = 1; i < descriptor->count(); ++i) {
+            check(0 == off->internalValue(i), "default internal value");
+            check(qFuzzyIsNull(off->externalValue(i).toReal()), "default external value");
+        }
+    }
+
+    // Apply the preset to an in-process equalizer, as AudioEqualizer does
+    const EffectPreset *const rock = bank.preset(TypeAudioEqualizer, QLatin1String("Rock"));
+    check(rock, "Rock preset found");
+    if (rock) {
+        QVector<BiquadEqualizer::Band> bands;
+        for (int i = 0; i < descriptor->count(); ++i)
+            if (descriptor->parameter(i).id() >= ParameterBase)
+                bands.append(BiquadEqualizer::Band(descriptor->parameter(i).frequency()));
+        BiquadEqualizer equalizer(SampleRate, ChannelCount, bands);
+
+        for (int i = 0; i < descriptor->count(); ++i) {
+            const EffectParameter &param = descriptor->parameter(i);
+            if (param.id() >= ParameterBase)
+                equalizer.setBandLevel(param.id() - ParameterBase, rock->internalValue(i));
+        }
+
+        check(true == rock->externalValue(0).toBool(), "toggle default");
+        for (int band = 0; band < BandCount; ++band) {
+            const int index = descriptor->indexOf(ParameterBase + band);
+            const qreal expected = qreal(2 * (RockLevels[band] - LevelMinimum))
+                                 / (LevelMaximum - LevelMinimum) - 1.0;
+            check(RockLevels[band] == equalizer.bandLevel(band), "applied band level");
+            check(qFuzzyCompare(expected, rock->externalValue(index).toReal()), "external band level");
+        }
+    }
+
+    qWarning("%s: %d failures", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,215 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "tickscheduler.h"
+#include "utils.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::TickScheduler
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Groups which fall due within this window of a wakeup are serviced by that
+// wakeup, rather than by a separate one.
+const qint64    CoalescingWindow = 5; // ms
+
+// Period over which wakeupsPerSecond() is measured.
+const qint64    StatisticsWindow = 1000; // ms
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::TickScheduler::TickScheduler(QObject *parent)
+    :   QObject(parent)
+    ,   m_timer(new QTimer(this))
+    ,   m_wakeupCount(0)
+    ,   m_windowWakeupCount(0)
+    ,   m_windowStart(0)
+    ,   m_wakeupsPerSecond(0.0)
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer.data(), SIGNAL(timeout()), this, SLOT(timerExpired()));
+    m_epoch.start();
+}
+
+MMF::TickScheduler::~TickScheduler()
+{
+
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+void MMF::TickScheduler::registerTarget(Target *target, int channel, qint32 interval)
+{
+    Q_ASSERT_X(interval > 0, Q_FUNC_INFO, "Invalid interval");
+
+    const Registration registration(target, channel);
+
+    if (m_intervals.value(registration) != interval) {
+        unRegisterTarget(target, channel);
+
+        GroupMap::iterator i = m_groups.find(interval);
+        if (i == m_groups.end()) {
+            // Align the first tick of the group to a multiple of its
+            // interval, so that it coincides with the ticks of groups
+            // whose intervals are multiples or factors of this one.
+            Group group;
+            group.m_due = (m_epoch.elapsed() / interval + 1) * interval;
+            i = m_groups.insert(interval, group);
+        }
+
+        i->m_registrations.append(registration);
+        m_intervals.insert(registration, interval);
+
+        reschedule();
+    }
+}
+
+void MMF::TickScheduler::unRegisterTarget(Target *target, int channel)
+{
+    const Registration registration(target, channel);
+    const QHash<Registration, qint32>::iterator i = m_intervals.find(registration);
+
+    if (i != m_intervals.end()) {
+        const GroupMap::iterator group = m_groups.find(i.value());
+        Q_ASSERT_X(group != m_groups.end(), Q_FUNC_INFO, "Group not found");
+        group->m_registrations.removeOne(registration);
+        if (group->m_registrations.isEmpty())
+            m_groups.erase(group);
+        m_intervals.erase(i);
+
+        reschedule();
+    }
+}
+
+void MMF::TickScheduler::unRegisterTarget(Target *target)
+{
+    QList<int> channels;
+    QHash<Registration, qint32>::const_iterator i = m_intervals.constBegin();
+    for ( ; i != m_intervals.constEnd(); ++i)
+        if (i.key().first == target)
+            channels.append(i.key().second);
+
+    foreach (int channel, channels)
+        unRegisterTarget(target, channel);
+}
+
+bool MMF::TickScheduler::isRegistered(Target *target, int channel) const
+{
+    return m_intervals.contains(Registration(target, channel));
+}
+
+int MMF::TickScheduler::wakeupCount() const
+{
+    return m_wakeupCount;
+}
+
+qreal MMF::TickScheduler::wakeupsPerSecond() const
+{
+    return m_wakeupsPerSecond;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private slots
+//-----------------------------------------------------------------------------
+
+void MMF::TickScheduler::timerExpired()
+{
+    const qint64 now = m_epoch.elapsed();
+    updateStatistics(now);
+
+    // Collect the due registrations before delivering any ticks, because
+    // targets may register or unregister from within scheduledTick().
+    QList<Registration> due;
+    GroupMap::iterator i = m_groups.begin();
+    for ( ; i != m_groups.end(); ++i) {
+        const qint32 interval = i.key();
+        Group &group = i.value();
+        if (group.m_due <= now + CoalescingWindow) {
+            due += group.m_registrations;
+
+            // Ticks which were missed altogether are skipped, rather than
+            // being delivered in a burst.
+            if (group.m_due <= now)
+                group.m_due = (now / interval + 1) * interval;
+            else
+                group.m_due += interval;
+        }
+    }
+
+    foreach (const Registration &registration, due)
+        if (m_intervals.contains(registration))
+            registration.first->scheduledTick(registration.second);
+
+    reschedule();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::TickScheduler::reschedule()
+{
+    if (m_groups.isEmpty()) {
+        m_timer->stop();
+    } else {
+        qint64 due = m_groups.begin()->m_due;
+        GroupMap::const_iterator i = m_groups.constBegin();
+        for ( ; i != m_groups.constEnd(); ++i)
+            due = qMin(due, i->m_due);
+
+        const qint64 delay = qMax(qint64(0), due - m_epoch.elapsed());
+        m_timer->start(delay);
+    }
+}
+
+void MMF::TickScheduler::updateStatistics(qint64 now)
+{
+    TRACE_CONTEXT(TickScheduler::updateStatistics, EBackend);
+
+    ++m_wakeupCount;
+    ++m_windowWakeupCount;
+
+    const qint64 window = now - m_windowStart;
+    if (window >= StatisticsWindow) {
+        m_wakeupsPerSecond = qreal(m_windowWakeupCount) * 1000 / window;
+        TRACE("wakeups %d rate %d/s groups %d registrations %d",
+              m_wakeupCount, int(m_wakeupsPerSecond),
+              m_groups.count(), m_intervals.count());
+        m_windowWakeupCount = 0;
+        m_windowStart = now;
+    }
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,144 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_TICKSCHEDULER_H
+#define PHONON_MMF_TICKSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QScopedPointer>
+#include <QTimer>
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Multiplexes periodic ticks from all players onto a single timer
+ *
+ * Each registration consists of a target, a channel number which the
+ * target uses to distinguish between its different periodic activities,
+ * and an interval.  Registrations which share an interval are grouped, and
+ * the ticks for each group are aligned to multiples of the interval, so
+ * that all targets with the same interval are serviced in the same
+ * wakeup.  Groups whose next tick falls within a short window of the
+ * current wakeup are serviced early rather than causing another wakeup.
+ *
+ * The scheduler is owned by the Backend.
+ */
+class TickScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Interface implemented by objects which receive ticks.
+     */
+    class Target
+    {
+    public:
+        virtual void scheduledTick(int channel) = 0;
+
+    protected:
+        ~Target() { }
+    };
+
+    explicit TickScheduler(QObject *parent);
+    ~TickScheduler();
+
+    /**
+     * Register target for periodic ticks on the specified channel.
+     *
+     * If the target is already registered on this channel, its interval
+     * is updated.
+     */
+    void registerTarget(Target *target, int channel, qint32 interval);
+
+    /**
+     * Stop delivering ticks to the target on the specified channel.
+     */
+    void unRegisterTarget(Target *target, int channel);
+
+    /**
+     * Stop delivering ticks to the target on all channels.  Must be
+     * called before the target is destroyed.
+     */
+    void unRegisterTarget(Target *target);
+
+    bool isRegistered(Target *target, int channel) const;
+
+    /**
+     * Total number of timer wakeups since construction.
+     */
+    int wakeupCount() const;
+
+    /**
+     * Wakeup rate measured over the most recent one-second window.
+     */
+    qreal wakeupsPerSecond() const;
+
+private Q_SLOTS:
+    void timerExpired();
+
+private:
+    void reschedule();
+    void updateStatistics(qint64 now);
+
+private:
+    typedef QPair<Target *, int> Registration;
+
+    struct Group
+    {
+        qint64                  m_due;
+        QList<Registration>     m_registrations;
+    };
+
+    /**
+     * Groups of registrations, keyed on interval.
+     */
+    typedef QMap<qint32, Group> GroupMap;
+    GroupMap                    m_groups;
+
+    /**
+     * Map from registration to interval, i.e. to the key of the group
+     * which contains it.
+     */
+    QHash<Registration, qint32> m_intervals;
+
+    QScopedPointer<QTimer>      m_timer;
+    QElapsedTimer               m_epoch;
+
+    int                         m_wakeupCount;
+    int                         m_windowWakeupCount;
+    qint64                      m_windowStart;
+    qreal                       m_wakeupsPerSecond;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,231 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QtConcurrentRun>
+
+#include "backend.h"
+#include "mediaobject.h"
+#include "utils.h"
+#include "visualization.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::Visualization
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Duration of audio which the ring can hold.  Blocks are rendered in
+// bursts, so this must be well above the frame interval.
+const int       RingDuration = 500;     // ms
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::Visualization::Visualization(Backend *backend, QObject *parent)
+    :   MediaNode(parent)
+    ,   m_backend(backend)
+    ,   m_mediaObject(0)
+    ,   m_frameRate(DefaultFrameRate)
+    ,   m_fftSize(SpectrumTap::roundSize(DefaultFftSize))
+    ,   m_analysisGeneration(0)
+{
+    if (AudioGraph *const graph = backend->audioGraph()) {
+        const int capacity = qMax(int(SpectrumAnalyzer::MaxSize),
+                                  graph->sampleRate() * RingDuration / 1000);
+        m_tap.reset(new SpectrumTap(graph->channelCount(), capacity, m_fftSize));
+    }
+
+    connect(&m_analysisWatcher, SIGNAL(finished()), SLOT(analysisFinished()));
+}
+
+MMF::Visualization::~Visualization()
+{
+    m_backend->tickScheduler()->unRegisterTarget(this);
+
+    // The worker uses the tap
+    m_analysisWatcher.waitForFinished();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+int MMF::Visualization::fftSize() const
+{
+    return m_fftSize;
+}
+
+void MMF::Visualization::setFftSize(int size)
+{
+    const int rounded = SpectrumTap::roundSize(size);
+
+    if (rounded != m_fftSize) {
+        m_fftSize = rounded;
+        if (m_tap) {
+            discardAnalysis();
+            m_tap->setSize(rounded);
+        }
+    }
+}
+
+int MMF::Visualization::frameRate() const
+{
+    return m_frameRate;
+}
+
+void MMF::Visualization::setFrameRate(int frameRate)
+{
+    m_frameRate = qBound(1, frameRate, int(MaxFrameRate));
+    updateFrameTimer();
+}
+
+QVector<float> MMF::Visualization::spectrum() const
+{
+    return m_spectrum;
+}
+
+QVector<float> MMF::Visualization::waveform() const
+{
+    return m_waveform;
+}
+
+void MMF::Visualization::process(float *samples, int frameCount)
+{
+    if (m_tap)
+        m_tap->write(samples, frameCount);
+}
+
+
+//-----------------------------------------------------------------------------
+// MediaNode
+//-----------------------------------------------------------------------------
+
+void MMF::Visualization::connectMediaObject(MediaObject *mediaObject)
+{
+    m_mediaObject = mediaObject;
+
+    connect(mediaObject, SIGNAL(stateChanged(Phonon::State, Phonon::State)),
+            SLOT(stateChanged(Phonon::State, Phonon::State)));
+
+    updateFrameTimer();
+}
+
+void MMF::Visualization::disconnectMediaObject(MediaObject *mediaObject)
+{
+    mediaObject->disconnect(this);
+    m_mediaObject = 0;
+    updateFrameTimer();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::Visualization::stateChanged(Phonon::State newState,
+                                      Phonon::State oldState)
+{
+    Q_UNUSED(oldState)
+
+    // Audio rendered before stopping is not shown after restarting
+    if (m_tap && Phonon::StoppedState == newState) {
+        discardAnalysis();
+        m_tap->clear();
+    }
+
+    updateFrameTimer();
+}
+
+void MMF::Visualization::analysisFinished()
+{
+    const AnalysisResult result = m_analysisWatcher.result();
+
+    if (result.m_generation != m_analysisGeneration || result.m_waveform.isEmpty())
+        return;
+
+    m_spectrum = result.m_spectrum;
+    m_waveform = result.m_waveform;
+
+    emit spectrumChanged(m_spectrum);
+    emit waveformChanged(m_waveform);
+}
+
+// Runs in a worker thread
+MMF::Visualization::AnalysisResult MMF::Visualization::analyze(SpectrumTap *tap,
+                                                               int generation)
+{
+    AnalysisResult result;
+    result.m_generation = generation;
+    tap->analyze(result.m_spectrum, result.m_waveform);
+    return result;
+}
+
+void MMF::Visualization::updateFrameTimer()
+{
+    TickScheduler *const scheduler = m_backend->tickScheduler();
+
+    if (m_tap && m_mediaObject && Phonon::PlayingState == m_mediaObject->state())
+        scheduler->registerTarget(this, FrameTickChannel, 1000 / m_frameRate);
+    else
+        scheduler->unRegisterTarget(this, FrameTickChannel);
+}
+
+/**
+ * Starts an analysis in a worker thread, unless one is still running.
+ * analysisFinished() publishes its result.
+ */
+void MMF::Visualization::startAnalysis()
+{
+    if (m_analysisWatcher.isRunning())
+        return;
+
+    m_analysisWatcher.setFuture(QtConcurrent::run(&Visualization::analyze,
+                                                  m_tap.data(),
+                                                  m_analysisGeneration));
+}
+
+/**
+ * Waits for any running analysis to finish, so that the consumer side of
+ * the tap may be used, and ensures that its result is not published.
+ */
+void MMF::Visualization::discardAnalysis()
+{
+    m_analysisWatcher.waitForFinished();
+    ++m_analysisGeneration;
+}
+
+void MMF::Visualization::scheduledTick(int channel)
+{
+    Q_ASSERT_X(FrameTickChannel == channel, Q_FUNC_INFO, "Unknown channel");
+    Q_UNUSED(channel)
+
+    startAnalysis();
+}
+
+QT_END_NAMESPACE
+
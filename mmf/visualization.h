@@ -0,0 +1,163 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_VISUALIZATION_H
+#define PHONON_MMF_VISUALIZATION_H
+
+#include <QFutureWatcher>
+#include <QScopedPointer>
+#include <QVector>
+
+#include <phonon/phononnamespace.h>
+
+#include "audiograph.h"
+#include "mmf_medianode.h"
+#include "spectrumtap.h"
+#include "tickscheduler.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+class Backend;
+
+/**
+ * @short Spectrum and waveform of the audio played by a MediaObject
+ *
+ * The visualization is only supported if the MediaObject renders in
+ * process.  It is then a leaf stage of the MediaObject's route, whose
+ * output is not played: each block is written to a SpectrumTap, which
+ * mixes it down to mono and appends it to a lock-free ring.  That is all
+ * the work done while rendering.
+ *
+ * While the MediaObject is playing, an analysis is started in a worker
+ * thread at frameRate frames per second.  It takes the most recent
+ * fftSize samples from the ring, and produces snapshots of the waveform
+ * and of the magnitude spectrum, which are published when the worker
+ * finishes.  No snapshot is published if no audio has been rendered since
+ * the previous one.  If an analysis is still running when the next frame
+ * is due, that frame is skipped.
+ *
+ * Because the graph renders ahead of the output, the snapshots lead the
+ * audible output by up to the "softwareLatency" of the Backend.
+ */
+class Visualization : public MediaNode
+                    , public TickScheduler::Target
+                    , public AudioProcessor
+{
+    Q_OBJECT
+    Q_PROPERTY(int fftSize READ fftSize WRITE setFftSize)
+    Q_PROPERTY(int frameRate READ frameRate WRITE setFrameRate)
+
+public:
+    Visualization(Backend *backend, QObject *parent);
+    ~Visualization();
+
+    enum Constants
+    {
+        DefaultFftSize = 1024,
+        DefaultFrameRate = 30,
+        MaxFrameRate = 60
+    };
+
+    int fftSize() const;
+
+    /**
+     * Rounded with SpectrumTap::roundSize().
+     */
+    void setFftSize(int size);
+
+    int frameRate() const;
+    void setFrameRate(int frameRate);
+
+    /**
+     * The most recent snapshots.  The spectrum has fftSize() / 2 + 1 bins,
+     * and the waveform has fftSize() samples; see SpectrumTap::analyze().
+     */
+    QVector<float> spectrum() const;
+    QVector<float> waveform() const;
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
+Q_SIGNALS:
+    void spectrumChanged(const QVector<float> &spectrum);
+    void waveformChanged(const QVector<float> &waveform);
+
+protected:
+    // MediaNode
+    void connectMediaObject(MediaObject *mediaObject);
+    void disconnectMediaObject(MediaObject *mediaObject);
+
+private Q_SLOTS:
+    void stateChanged(Phonon::State newState, Phonon::State oldState);
+    void analysisFinished();
+
+private:
+    struct AnalysisResult
+    {
+        int             m_generation;
+        QVector<float>  m_spectrum;
+        QVector<float>  m_waveform;
+    };
+
+    typedef QFutureWatcher<AnalysisResult> AnalysisWatcher;
+
+    static AnalysisResult analyze(SpectrumTap *tap, int generation);
+
+    void updateFrameTimer();
+    void startAnalysis();
+    void discardAnalysis();
+
+    // TickScheduler::Target
+    virtual void scheduledTick(int channel);
+
+    enum TickChannel {
+        FrameTickChannel
+    };
+
+private:
+    // Not owned
+    Backend *const                      m_backend;
+    MediaObject *                       m_mediaObject;
+
+    int                                 m_frameRate;
+    int                                 m_fftSize;
+
+    // Null if in-process rendering is not enabled.  While an analysis is
+    // running, only the worker uses the consumer side of the tap.
+    QScopedPointer<SpectrumTap>         m_tap;
+
+    AnalysisWatcher                     m_analysisWatcher;
+
+    // Incremented when the tap is changed, so that the result of an
+    // analysis which was started before then is discarded
+    int                                 m_analysisGeneration;
+
+    QVector<float>                      m_spectrum;
+    QVector<float>                      m_waveform;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
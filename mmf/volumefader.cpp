@@ -0,0 +1,262 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "abstractmediaplayer.h"
+#include "backend.h"
+#include "mediaobject.h"
+#include "softwareplayer.h"
+#include "utils.h"
+#include "volumefader.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::VolumeFader
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+// Shortest interval between steps of a fade on the native path
+const qint32    MinStepInterval = 20; // ms
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+MMF::VolumeFader::VolumeFader(Backend *backend, QObject *parent)
+    :   MediaNode(parent)
+    ,   m_backend(backend)
+    ,   m_player(0)
+    ,   m_curve(GainRamp::Fade3Decibel)
+    ,   m_level(1.0f)
+    ,   m_fadeFrom(1.0f)
+    ,   m_fadeTo(1.0f)
+    ,   m_fadeStart(0)
+    ,   m_fadeDuration(0)
+    ,   m_stepInterval(MinStepInterval)
+{
+    if (AudioGraph *const graph = backend->audioGraph())
+        m_ramp.reset(new GainRamp(graph->sampleRate(), graph->channelCount()));
+}
+
+MMF::VolumeFader::~VolumeFader()
+{
+    m_backend->tickScheduler()->unRegisterTarget(this);
+}
+
+
+//-----------------------------------------------------------------------------
+// VolumeFaderInterface
+//-----------------------------------------------------------------------------
+
+float MMF::VolumeFader::volume() const
+{
+    return isRenderedInProcess() ? m_ramp->gain() : m_level;
+}
+
+void MMF::VolumeFader::setVolume(float volume)
+{
+    if (m_ramp)
+        m_ramp->setGain(volume);
+
+    m_level = volume;
+    m_fadeDuration = 0;
+    updateStepTimer();
+    applyLevel();
+}
+
+Phonon::VolumeFaderEffect::FadeCurve MMF::VolumeFader::fadeCurve() const
+{
+    return static_cast<Phonon::VolumeFaderEffect::FadeCurve>(m_curve);
+}
+
+void MMF::VolumeFader::setFadeCurve(Phonon::VolumeFaderEffect::FadeCurve curve)
+{
+    m_curve = static_cast<GainRamp::Curve>(curve);
+}
+
+void MMF::VolumeFader::fadeTo(float volume, int fadeTime)
+{
+    TRACE_CONTEXT(VolumeFader::fadeTo, EAudioApi);
+    TRACE_ENTRY("volume %f time %d", volume, fadeTime);
+
+    if (fadeTime <= 0) {
+        setVolume(volume);
+    } else {
+        m_level = this->volume();
+
+        if (m_ramp)
+            m_ramp->fadeTo(volume, fadeTime, m_curve);
+
+        m_fadeFrom = m_level;
+        m_fadeTo = volume;
+        m_fadeStart = m_player ? m_player->currentTime() : 0;
+        m_fadeDuration = fadeTime;
+
+        int budget = m_backend->property("faderStepBudget").toInt();
+        if (budget <= 0)
+            budget = DefaultStepBudget;
+        m_stepInterval = qMax(MinStepInterval, fadeTime / budget);
+
+        updateStepTimer();
+    }
+
+    TRACE_EXIT_0();
+}
+
+
+//-----------------------------------------------------------------------------
+// MediaNode
+//-----------------------------------------------------------------------------
+
+AudioProcessor *MMF::VolumeFader::audioProcessor()
+{
+    return this;
+}
+
+void MMF::VolumeFader::connectMediaObject(MediaObject *mediaObject)
+{
+    abstractPlayerChanged(mediaObject->abstractPlayer());
+
+    connect(mediaObject, SIGNAL(stateChanged(Phonon::State, Phonon::State)),
+            SLOT(stateChanged(Phonon::State, Phonon::State)));
+
+    connect(mediaObject, SIGNAL(abstractPlayerChanged(AbstractPlayer *)),
+            SLOT(abstractPlayerChanged(AbstractPlayer *)));
+}
+
+void MMF::VolumeFader::disconnectMediaObject(MediaObject *mediaObject)
+{
+    mediaObject->disconnect(this);
+    abstractPlayerChanged(0);
+}
+
+
+//-----------------------------------------------------------------------------
+// AudioProcessor
+//-----------------------------------------------------------------------------
+
+void MMF::VolumeFader::process(float *samples, int frameCount)
+{
+    if (m_ramp)
+        m_ramp->process(samples, frameCount);
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void MMF::VolumeFader::abstractPlayerChanged(AbstractPlayer *player)
+{
+    // The fade level is synchronized before switching paths, in case only
+    // one of the players renders in process.
+    const float level = volume();
+    qint64 elapsed = 0;
+
+    if (m_player) {
+        elapsed = qMax(qint64(0), m_player->currentTime() - m_fadeStart);
+
+        // When the MediaObject switches players, the previous player keeps
+        // its level: during a crossfade it continues as the outgoing
+        // player, and otherwise it is released to the PlayerPool, which
+        // resets the level when the player is reused.  The level is only
+        // restored when the player is detached from this fader.
+        if (!player && !isRenderedInProcess())
+            m_player->setFaderLevel(1.0);
+    }
+
+    m_player = qobject_cast<AbstractMediaPlayer *>(player);
+    m_level = level;
+
+    // A fade in progress continues along the same curve, on the clock of
+    // the new player
+    if (m_fadeDuration > 0)
+        m_fadeStart = (m_player ? m_player->currentTime() : 0) - elapsed;
+
+    updateStepTimer();
+    applyLevel();
+}
+
+void MMF::VolumeFader::stateChanged(Phonon::State newState,
+                                    Phonon::State oldState)
+{
+    Q_UNUSED(newState)
+    Q_UNUSED(oldState)
+    updateStepTimer();
+}
+
+bool MMF::VolumeFader::isRenderedInProcess() const
+{
+    return m_ramp && qobject_cast<SoftwarePlayer *>(m_player);
+}
+
+void MMF::VolumeFader::updateStepTimer()
+{
+    TickScheduler *const scheduler = m_backend->tickScheduler();
+
+    if (m_fadeDuration > 0 && m_player && !isRenderedInProcess()
+        && Phonon::PlayingState == m_player->state())
+        scheduler->registerTarget(this, StepTickChannel, m_stepInterval);
+    else
+        scheduler->unRegisterTarget(this, StepTickChannel);
+}
+
+/**
+ * Recalculates the level of a fade on the native path from the playback
+ * clock.
+ */
+void MMF::VolumeFader::step()
+{
+    const qint64 elapsed = qMax(qint64(0), m_player->currentTime() - m_fadeStart);
+
+    if (elapsed >= m_fadeDuration) {
+        m_level = m_fadeTo;
+        m_fadeDuration = 0;
+        updateStepTimer();
+    } else {
+        m_level = GainRamp::curveValue(m_curve, m_fadeFrom, m_fadeTo,
+                                       float(elapsed) / m_fadeDuration);
+    }
+
+    applyLevel();
+}
+
+void MMF::VolumeFader::applyLevel()
+{
+    if (m_player && !isRenderedInProcess())
+        m_player->setFaderLevel(m_level);
+}
+
+void MMF::VolumeFader::scheduledTick(int channel)
+{
+    Q_ASSERT_X(StepTickChannel == channel, Q_FUNC_INFO, "Unknown channel");
+    Q_UNUSED(channel)
+
+    if (m_player)
+        step();
+}
+
+QT_END_NAMESPACE
+
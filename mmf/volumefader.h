@@ -0,0 +1,134 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_VOLUMEFADER_H
+#define PHONON_MMF_VOLUMEFADER_H
+
+#include <QScopedPointer>
+
+#include <phonon/volumefadereffect.h>
+#include <phonon/volumefaderinterface.h>
+
+#include "audiograph.h"
+#include "gainramp.h"
+#include "mmf_medianode.h"
+#include "tickscheduler.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace Phonon
+{
+namespace MMF
+{
+class AbstractMediaPlayer;
+class AbstractPlayer;
+class Backend;
+
+/**
+ * @short VolumeFaderInterface implementation for MMF.
+ *
+ * When the player renders in process, the fader is a stage of the
+ * AudioGraph, and fades are applied by a GainRamp, with a per-sample gain
+ * ramp which ends on the exact frame at which the fade is due to end.
+ *
+ * Otherwise, the fader level scales the volume of the native player.
+ * During a fade, the level is recalculated from the playback clock and
+ * passed to the player at regular intervals.  Each device volume update
+ * has a cost, so the number of steps per fade is limited by the Backend's
+ * "faderStepBudget" property.
+ *
+ * In both cases, fades only progress while the MediaObject is playing.
+ */
+class VolumeFader : public MediaNode
+                  , public VolumeFaderInterface
+                  , public TickScheduler::Target
+                  , public AudioProcessor
+{
+    Q_OBJECT
+    Q_INTERFACES(Phonon::VolumeFaderInterface)
+
+public:
+    VolumeFader(Backend *backend, QObject *parent);
+    ~VolumeFader();
+
+    // VolumeFaderInterface
+    virtual float volume() const;
+    virtual void setVolume(float volume);
+    virtual Phonon::VolumeFaderEffect::FadeCurve fadeCurve() const;
+    virtual void setFadeCurve(Phonon::VolumeFaderEffect::FadeCurve curve);
+    virtual void fadeTo(float volume, int fadeTime);
+
+    // MediaNode
+    virtual AudioProcessor *audioProcessor();
+
+    // AudioProcessor
+    virtual void process(float *samples, int frameCount);
+
+    enum Constants
+    {
+        DefaultStepBudget = 25
+    };
+
+protected:
+    // MediaNode
+    void connectMediaObject(MediaObject *mediaObject);
+    void disconnectMediaObject(MediaObject *mediaObject);
+
+private Q_SLOTS:
+    void abstractPlayerChanged(AbstractPlayer *player);
+    void stateChanged(Phonon::State newState, Phonon::State oldState);
+
+private:
+    bool isRenderedInProcess() const;
+    void updateStepTimer();
+    void step();
+    void applyLevel();
+
+    // TickScheduler::Target
+    virtual void scheduledTick(int channel);
+
+    enum TickChannel {
+        StepTickChannel
+    };
+
+private:
+    // Not owned
+    Backend *const                  m_backend;
+    AbstractMediaPlayer *           m_player;
+
+    GainRamp::Curve                 m_curve;
+
+    // Used if the player renders in process; null if in-process
+    // rendering is not enabled
+    QScopedPointer<GainRamp>        m_ramp;
+
+    // Used otherwise.  Times are positions of the playback clock.
+    float                           m_level;
+    float                           m_fadeFrom;
+    float                           m_fadeTo;
+    qint64                          m_fadeStart;
+    qint64                          m_fadeDuration;
+    qint32                          m_stepInterval;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,283 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <QIODevice>
+#include <QtEndian>
+
+#include "dspkernel.h"
+#include "wavfile.h"
+
+QT_BEGIN_NAMESPACE
+
+using namespace Phonon;
+using namespace Phonon::MMF;
+
+/*! \class MMF::WavReader
+  \internal
+*/
+
+/*! \class MMF::WavFileSink
+  \internal
+*/
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+const quint16   PcmFormat = 1;
+const quint16   BitsPerSample = 16;
+const int       HeaderSize = 44;
+
+// Number of frames converted per read from, or write to, the device
+const int       ChunkFrames = 1024;
+
+// Internal helper functions
+static quint32 readUInt32(const char *data)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(data));
+}
+
+static quint16 readUInt16(const char *data)
+{
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(data));
+}
+
+
+//-----------------------------------------------------------------------------
+// WavReader
+//-----------------------------------------------------------------------------
+
+WavReader::WavReader()
+    :   m_device(0)
+    ,   m_sampleRate(0)
+    ,   m_channelCount(0)
+    ,   m_dataOffset(0)
+    ,   m_frameCount(0)
+    ,   m_position(0)
+{
+
+}
+
+bool WavReader::open(QIODevice *device)
+{
+    close();
+
+    char header[12];
+    if (device->read(header, 12) != 12
+        || qstrncmp(header, "RIFF", 4) || qstrncmp(header + 8, "WAVE", 4))
+        return false;
+
+    bool formatFound = false;
+    int sampleRate = 0;
+    int channelCount = 0;
+
+    // Walk the chunks until the data chunk is found
+    char chunk[8];
+    while (device->read(chunk, 8) == 8) {
+        const quint32 size = readUInt32(chunk + 4);
+
+        if (!qstrncmp(chunk, "fmt ", 4)) {
+            char format[16];
+            if (size < 16 || device->read(format, 16) != 16)
+                return false;
+            if (readUInt16(format) != PcmFormat
+                || readUInt16(format + 14) != BitsPerSample)
+                return false;
+            channelCount = readUInt16(format + 2);
+            sampleRate = readUInt32(format + 4);
+            formatFound = channelCount > 0 && sampleRate > 0;
+            if (!device->seek(device->pos() + size - 16 + (size & 1)))
+                return false;
+        } else if (!qstrncmp(chunk, "data", 4)) {
+            if (!formatFound)
+                return false;
+            m_device = device;
+            m_sampleRate = sampleRate;
+            m_channelCount = channelCount;
+            m_dataOffset = device->pos();
+            m_frameCount = size / (channelCount * sizeof(qint16));
+            m_position = 0;
+            m_buffer.resize(ChunkFrames * channelCount);
+            return true;
+        } else {
+            // Chunks are padded to an even size
+            if (!device->seek(device->pos() + size + (size & 1)))
+                return false;
+        }
+    }
+
+    return false;
+}
+
+void WavReader::close()
+{
+    m_device = 0;
+    m_sampleRate = 0;
+    m_channelCount = 0;
+    m_frameCount = 0;
+    m_position = 0;
+}
+
+bool WavReader::isOpen() const
+{
+    return m_device;
+}
+
+int WavReader::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+int WavReader::channelCount() const
+{
+    return m_channelCount;
+}
+
+qint64 WavReader::frameCount() const
+{
+    return m_frameCount;
+}
+
+qint64 WavReader::position() const
+{
+    return m_position;
+}
+
+bool WavReader::seek(qint64 frame)
+{
+    frame = qBound(qint64(0), frame, m_frameCount);
+    const qint64 offset = m_dataOffset + frame * m_channelCount * sizeof(qint16);
+    if (!m_device || !m_device->seek(offset))
+        return false;
+    m_position = frame;
+    return true;
+}
+
+int WavReader::read(float *samples, int frameCount)
+{
+    frameCount = qMin(qint64(frameCount), m_frameCount - m_position);
+
+    int read = 0;
+    while (m_device && read < frameCount) {
+        const int chunkFrames = qMin(frameCount - read, ChunkFrames);
+        const qint64 bytes = m_device->read(reinterpret_cast<char *>(m_buffer.data()),
+                                            chunkFrames * m_channelCount * sizeof(qint16));
+        const int frames = qMax(qint64(0), bytes) / (m_channelCount * sizeof(qint16));
+        const qint16 *const buffer = m_buffer.constData();
+        for (int i = 0; i < frames * m_channelCount; ++i)
+            *samples++ = toFloat(qFromLittleEndian(buffer[i]));
+
+        read += frames;
+        if (frames < chunkFrames)
+            break;
+    }
+
+    m_position += read;
+    return read;
+}
+
+
+//-----------------------------------------------------------------------------
+// WavFileSink
+//-----------------------------------------------------------------------------
+
+WavFileSink::WavFileSink(const QString &fileName, int sampleRate, int channelCount)
+    :   m_file(fileName)
+    ,   m_sampleRate(sampleRate)
+    ,   m_channelCount(channelCount)
+    ,   m_frameCount(0)
+    ,   m_buffer(ChunkFrames * channelCount)
+{
+
+}
+
+WavFileSink::~WavFileSink()
+{
+    close();
+}
+
+bool WavFileSink::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    m_frameCount = 0;
+    writeHeader();
+    return true;
+}
+
+void WavFileSink::close()
+{
+    if (m_file.isOpen()) {
+        m_file.seek(0);
+        writeHeader();
+        m_file.close();
+    }
+}
+
+void WavFileSink::start(AudioGraph *graph)
+{
+    // Rendering is driven by the client
+    Q_UNUSED(graph)
+}
+
+void WavFileSink::writeAudio(const float *samples, int frameCount)
+{
+    while (frameCount > 0) {
+        const int chunkFrames = qMin(frameCount, ChunkFrames);
+        qint16 *const buffer = m_buffer.data();
+        for (int i = 0; i < chunkFrames * m_channelCount; ++i) {
+            qint16 sample;
+            fromFloat(*samples++, sample);
+            buffer[i] = qToLittleEndian(sample);
+        }
+        m_file.write(reinterpret_cast<const char *>(buffer),
+                     chunkFrames * m_channelCount * sizeof(qint16));
+        m_frameCount += chunkFrames;
+        frameCount -= chunkFrames;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Private functions
+//-----------------------------------------------------------------------------
+
+void WavFileSink::writeHeader()
+{
+    const quint16 blockAlign = m_channelCount * sizeof(qint16);
+    const quint32 dataSize = m_frameCount * blockAlign;
+
+    uchar header[HeaderSize];
+    qMemCopy(header, "RIFF", 4);
+    qToLittleEndian<quint32>(HeaderSize - 8 + dataSize, header + 4);
+    qMemCopy(header + 8, "WAVEfmt ", 8);
+    qToLittleEndian<quint32>(16, header + 16);
+    qToLittleEndian<quint16>(PcmFormat, header + 20);
+    qToLittleEndian<quint16>(m_channelCount, header + 22);
+    qToLittleEndian<quint32>(m_sampleRate, header + 24);
+    qToLittleEndian<quint32>(m_sampleRate * blockAlign, header + 28);
+    qToLittleEndian<quint16>(blockAlign, header + 32);
+    qToLittleEndian<quint16>(BitsPerSample, header + 34);
+    qMemCopy(header + 36, "data", 4);
+    qToLittleEndian<quint32>(dataSize, header + 40);
+
+    m_file.write(reinterpret_cast<const char *>(header), HeaderSize);
+}
+
+QT_END_NAMESPACE
+
@@ -0,0 +1,121 @@
+/*  This file is part of the KDE project.
+
+Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+
+This library is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 or 3 of the License.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHONON_MMF_WAVFILE_H
+#define PHONON_MMF_WAVFILE_H
+
+#include <QFile>
+#include <QVector>
+
+#include "audiograph.h"
+
+QT_BEGIN_NAMESPACE
+
+class QIODevice;
+
+namespace Phonon
+{
+namespace MMF
+{
+
+/**
+ * @short Reads 16-bit PCM from a RIFF WAVE stream
+ *
+ * Samples are converted to floating point as they are read.  Other
+ * encodings are not supported.
+ */
+class WavReader
+{
+public:
+    WavReader();
+
+    /**
+     * Parses the header.  The device is not owned, and must remain open
+     * while the reader is in use.  Returns false if the stream is not a
+     * supported WAVE stream.
+     */
+    bool open(QIODevice *device);
+    void close();
+    bool isOpen() const;
+
+    int sampleRate() const;
+    int channelCount() const;
+    qint64 frameCount() const;
+    qint64 position() const;
+
+    bool seek(qint64 frame);
+
+    /**
+     * Reads up to frameCount frames.  Returns the number of frames read,
+     * which is less than frameCount at the end of the stream.
+     */
+    int read(float *samples, int frameCount);
+
+private:
+    QIODevice *                 m_device;
+    int                         m_sampleRate;
+    int                         m_channelCount;
+    qint64                      m_dataOffset;
+    qint64                      m_frameCount;
+    qint64                      m_position;
+
+    QVector<qint16>             m_buffer;
+
+};
+
+/**
+ * @short Writes the output of an AudioGraph to a 16-bit PCM WAVE file
+ *
+ * Blocks are not pulled: the client drives rendering via
+ * AudioGraph::render(), which makes the output deterministic.
+ */
+class WavFileSink : public AudioSink
+{
+public:
+    WavFileSink(const QString &fileName, int sampleRate, int channelCount);
+    ~WavFileSink();
+
+    bool open();
+
+    /**
+     * Completes the header.  Called by the destructor.
+     */
+    void close();
+
+    // AudioSink
+    virtual void start(AudioGraph *graph);
+    virtual void writeAudio(const float *samples, int frameCount);
+
+private:
+    void writeHeader();
+
+private:
+    QFile                       m_file;
+    const int                   m_sampleRate;
+    const int                   m_channelCount;
+    qint64                      m_frameCount;
+
+    QVector<qint16>             m_buffer;
+
+};
+}
+}
+
+QT_END_NAMESPACE
+
+#endif